@@ -4,6 +4,7 @@
 
 #include "db/builder.h"
 
+#include <algorithm>
 #include "db/filename.h"
 #include "db/dbformat.h"
 #include "db/table_cache.h"
@@ -11,6 +12,8 @@
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "leveldb/rate_limiter.h"
+#include "util/trace_imp.h"
 
 // temp
 #include <chrono>
@@ -18,6 +21,54 @@
 
 namespace leveldb {
 
+namespace {
+
+// Charges every append to a RateLimiter before passing it on.
+class RateLimitedWritableFile : public WritableFile {
+ public:
+  RateLimitedWritableFile(WritableFile* target, RateLimiter* limiter)
+      : target_(target), limiter_(limiter) { }
+  ~RateLimitedWritableFile() { delete target_; }
+
+  virtual Status Append(const Slice& data) {
+    limiter_->Request(data.size());
+    return target_->Append(data);
+  }
+  virtual Status Close() { return target_->Close(); }
+  virtual Status Flush() { return target_->Flush(); }
+  virtual Status Sync() { return target_->Sync(); }
+
+ private:
+  WritableFile* const target_;
+  RateLimiter* const limiter_;
+};
+
+}  // namespace
+
+Options TableOptionsForLevel(const Options& options, int level) {
+  Options result = options;
+  const std::vector<CompressionType>& per_level = options.compression_per_level;
+  if (!per_level.empty()) {
+    result.compression =
+        per_level[std::min(static_cast<size_t>(level), per_level.size() - 1)];
+  }
+  return result;
+}
+
+Status NewTableFile(Env* env, const Options& options,
+                    const std::string& fname, WritableFile** result) {
+  Status s;
+  if (options.use_direct_io_for_flush_and_compaction) {
+    s = env->NewDirectWritableFile(fname, result);
+  } else {
+    s = env->NewWritableFile(fname, result);
+  }
+  if (s.ok() && options.rate_limiter != nullptr) {
+    *result = new RateLimitedWritableFile(*result, options.rate_limiter);
+  }
+  return s;
+}
+
 /* PROGRESS: Write file based on pmem */
 // /*
 Status BuildTable(const std::string& dbname,
@@ -26,7 +77,12 @@ Status BuildTable(const std::string& dbname,
                   TableCache* table_cache,
                   Iterator* iter,
                   FileMetaData* meta,
-                  Tiering_stats* tiering_stats) {
+                  Tiering_stats* tiering_stats,
+                  uint64_t* pmem_bytes) {
+  TRACE_SPAN("flush.build_table");
+  if (pmem_bytes != nullptr) {
+    *pmem_bytes = 0;
+  }
   SSTMakerType sst_type = options.sst_type;
   // std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
   uint64_t file_number = meta->number;
@@ -56,11 +112,13 @@ Status BuildTable(const std::string& dbname,
         need_file_creation) {
       // printf("%d file@\n", file_number);
       WritableFile* file;
-      s = env->NewWritableFile(fname, &file);
+      s = NewTableFile(env, options, fname, &file);
       if (!s.ok()) {
         return s;
       }
-      TableBuilder* builder = new TableBuilder(options, file);
+      // Flushed tables start in level 0
+      TableBuilder* builder = new TableBuilder(TableOptionsForLevel(options, 0),
+                                               file);
       meta->smallest.DecodeFrom(iter->key());
 
       // int i = 0;
@@ -124,9 +182,18 @@ Status BuildTable(const std::string& dbname,
         if (options.use_pmem_buffer) {
           switch (options.ds_type) {
             case kSkiplist:
-              builder->AddToBufferAndSkiplist(pmem_buffer, pmem_skiplist, 
+              // Entries of a pmem-resident memtable are already in pmem;
+              // link them in place instead of copying.
+              if (iter->buffer_ptr() != nullptr) {
+                builder->AddToSkiplistByPtr(pmem_skiplist, file_number,
+                                            key, iter->value(),
+                                            iter->buffer_ptr(),
+                                            iter->refTimes() /*zewei*/);
+              } else {
+                builder->AddToBufferAndSkiplist(pmem_buffer, pmem_skiplist, 
                                           file_number, key, iter->value(),
 					  iter->refTimes() /*zewei*/);
+              }
               break;
             case kHashmap:
               builder->AddToBufferAndHashmap(pmem_buffer, pmem_hashmap,
@@ -158,13 +225,19 @@ Status BuildTable(const std::string& dbname,
       s = builder->FinishPmem();
       meta->file_size = builder->FileSize();
       assert(meta->file_size > 0);
+      if (pmem_bytes != nullptr) {
+        *pmem_bytes = builder->PmemBytesWritten();
+      }
       delete builder;
 
       // PROGRESS:
-      tiering_stats->InsertIntoSkiplistSet(file_number);
-      if (options.tiering_option == kColdDataTiering || 
-          options.tiering_option == kLRUTiering) {
-        tiering_stats->PushToNumberListInPmem(0, file_number);
+      // A table whose records could not all be written is not published
+      if (s.ok()) {
+        tiering_stats->InsertIntoSkiplistSet(file_number);
+        if (options.tiering_option == kColdDataTiering || 
+            options.tiering_option == kLRUTiering) {
+          tiering_stats->PushToNumberListInPmem(0, file_number);
+        }
       }
     }
     
@@ -5,6 +5,7 @@
 #ifndef STORAGE_LEVELDB_DB_BUILDER_H_
 #define STORAGE_LEVELDB_DB_BUILDER_H_
 
+#include "leveldb/options.h"
 #include "leveldb/status.h"
 #include "pmem/tiering_stats.h"
 
@@ -17,19 +18,33 @@ class Env;
 class Iterator;
 class TableCache;
 class VersionEdit;
+class WritableFile;
 
 // Build a Table file from the contents of *iter.  The generated file
 // will be named according to meta->number.  On success, the rest of
 // *meta will be filled with metadata about the generated table.
 // If no data is present in *iter, meta->file_size will be set to
 // zero, and no Table file will be produced.
+// If pmem_bytes is non-null, *pmem_bytes is set to the number of bytes a
+// PMEM table wrote to the pmem-buffer (zero for an SST).
 Status BuildTable(const std::string& dbname,
                   Env* env,
                   const Options& options,
                   TableCache* table_cache,
                   Iterator* iter,
                   FileMetaData* meta,
-                  Tiering_stats* tiering_stats);
+                  Tiering_stats* tiering_stats,
+                  uint64_t* pmem_bytes = nullptr);
+
+// Return a copy of "options" whose compression is the one configured for
+// tables written to "level" (see Options::compression_per_level).
+Options TableOptionsForLevel(const Options& options, int level);
+
+// Create the file "fname" for a table written by a flush or compaction.
+// Honors options.use_direct_io_for_flush_and_compaction and charges the
+// writes to options.rate_limiter, if any.
+Status NewTableFile(Env* env, const Options& options,
+                    const std::string& fname, WritableFile** result);
 
 }  // namespace leveldb
 
@@ -1,7 +1,10 @@
 // Copyright (c) 2011 The LevelDB Authors. All rights reserved.
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
+#include <atomic>
+#include <chrono>
 #include <iostream>
+#include <math.h>
 #include <sys/types.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,9 +12,13 @@
 #include "leveldb/db.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/perf_context.h"
+#include "leveldb/statistics.h"
+#include "leveldb/trace.h"
 #include "leveldb/write_batch.h"
 #include "port/port.h"
 #include "util/crc32c.h"
+#include "util/hdr_histogram.h"
 #include "util/histogram.h"
 #include "util/mutexlock.h"
 #include "util/random.h"
@@ -35,11 +42,21 @@
 //      open          -- cost of opening a DB
 //      crc32c        -- repeated crc32c of 4K of data
 //      acquireload   -- load N*1000 times
+//      ycsba         -- YCSB workload A: 50% reads, 50% updates
+//      ycsbb         -- YCSB workload B: 95% reads, 5% updates
+//      ycsbc         -- YCSB workload C: 100% reads
+//      ycsbd         -- YCSB workload D: 95% reads of the latest keys, 5% inserts
+//      ycsbe         -- YCSB workload E: 95% short scans, 5% inserts
+//      ycsbf         -- YCSB workload F: 50% reads, 50% read-modify-writes
+//                       (the ycsb* workloads expect a DB loaded with fillseq)
 //   Meta operations:
 //      compact     -- Compact the entire DB
 //      stats       -- Print DB stats
 //      sstables    -- Print sstable info
 //      heapprofile -- Dump a heap profile (if supported by this port)
+//      tierstats   -- Print PMEM/SST hit counts and tiering activity
+//      pmemstats   -- Print the statistics tickers and histograms
+//      amplification -- Print write/space amplification per level and tier
 static const char* FLAGS_benchmarks =
     "fillseq,"
     "fillsync,"
@@ -79,6 +96,17 @@ static double FLAGS_compression_ratio = 0.5;
 // Print histogram of operation timings
 static bool FLAGS_histogram = false;
 
+// Every this many seconds, print the throughput and latency percentiles
+// of the last interval (0: only at the end of each benchmark)
+static int FLAGS_stats_interval_seconds = 0;
+
+// Also write the interval and per-benchmark latency percentiles to this
+// file, for correlating latency spikes with the DB's LOG
+static const char* FLAGS_stats_file = nullptr;
+
+// Format of --stats_file: "csv" or "json" (one object per line)
+static int FLAGS_stats_format = 0;
+
 // Number of bytes to buffer in memtable before compacting
 // (initialized to default value by "main")
 static int FLAGS_write_buffer_size = 0;
@@ -113,11 +141,113 @@ static bool FLAGS_reuse_logs = false;
 // Use the db with the following name.
 static const char* FLAGS_db = nullptr;
 
+// PMEM tier and tiering policy
+// (initialized to default values by "main")
+
+// Table format: "sst" (table files) or "pmem" (PMEM tables)
+static leveldb::SSTMakerType FLAGS_sst_type;
+
+// Structure of PMEM tables: "skiplist" or "hashmap"
+static leveldb::PmemDataStructrueType FLAGS_ds_type;
+
+// Tiering policy: "leveled", "colddata", "lru" or "none"
+static leveldb::TieringOption FLAGS_tiering;
+
+// Stage PMEM table records in the pmem buffer
+static bool FLAGS_use_pmem_buffer;
+
+// Cache PMEM table iterators in the table cache
+static bool FLAGS_skiplist_cache;
+
+// Keep the write-ahead log in PMEM
+static bool FLAGS_use_pmem_log;
+
+// Allocate memtable entries in PMEM
+static bool FLAGS_use_pmem_memtable;
+
+// Per-record value compression in the pmem buffer:
+// "none", "snappy", "zstd" or "lz4"
+static leveldb::CompressionType FLAGS_pmem_value_compression;
+
+// Records between key restart points in the pmem buffer (0: no prefix
+// compression)
+static int FLAGS_pmem_key_restart_interval;
+
+// Bytes of DRAM row cache in front of PMEM tables (0: none)
+static int FLAGS_pmem_row_cache_size = 0;
+
+// Directory holding the PMEM pools (default: paths in pmem/layout.h)
+static const char* FLAGS_pmem_dir = nullptr;
+
+// Print "leveldb.tier-stats" after every benchmark
+static bool FLAGS_tier_stats = false;
+
+// If true, pass a Statistics object to the DB, which also turns on its
+// get/write/compaction latency histograms ("leveldb.pmem-stats")
+static bool FLAGS_statistics = false;
+
+// Perf level of the benchmark threads (0: off, 1: counters, 2: counters
+// and timers); each thread prints its PerfContext when it finishes
+static int FLAGS_perf_level = leveldb::kPerfDisabled;
+
+// If set, record trace spans of the whole run to this file in the Chrome
+// trace format (needs a build with -DLEVELDB_ENABLE_TRACING=ON)
+static const char* FLAGS_trace_file = nullptr;
+
+// YCSB workloads (ycsba..ycsbf)
+
+// Operation mix; a negative proportion keeps the workload's default.  The
+// proportions are normalized by their sum.
+static double FLAGS_ycsb_read_proportion = -1;
+static double FLAGS_ycsb_update_proportion = -1;
+static double FLAGS_ycsb_insert_proportion = -1;
+static double FLAGS_ycsb_scan_proportion = -1;
+static double FLAGS_ycsb_rmw_proportion = -1;
+
+// Key distribution: "uniform", "zipfian", "scrambled" (zipfian with the
+// popular keys spread over the key space), "latest" or "hotspot".  If
+// negative, use the workload's default.
+static int FLAGS_ycsb_distribution = -1;
+
+// Skew of the zipfian, scrambled and latest distributions
+static double FLAGS_ycsb_zipfian_constant = 0.99;
+
+// Scans read a uniformly chosen number of entries in [1, max_scan_length]
+static int FLAGS_ycsb_max_scan_length = 100;
+
+// Hotspot distribution: "op_fraction" of the operations go to the first
+// "data_fraction" of the keys
+static double FLAGS_ycsb_hotspot_data_fraction = 0.2;
+static double FLAGS_ycsb_hotspot_op_fraction = 0.8;
+
 namespace leveldb {
 
 namespace {
 leveldb::Env* g_env = nullptr;
 
+// Names of the enum-valued flags, in enum order
+const char* const kSSTTypeNames[] = { "sst", "pmem" };
+const char* const kDSTypeNames[] = { "skiplist", "hashmap" };
+const char* const kTieringNames[] = { "leveled", "colddata", "lru", "none" };
+const char* const kCompressionNames[] = { "none", "snappy", "zstd", "lz4" };
+
+const char* const kStatsFormatNames[] = { "csv", "json" };
+const char* const kYCSBDistributionNames[] = {
+  "uniform", "zipfian", "scrambled", "latest", "hotspot"
+};
+
+// Set "*value" to the index of "name" in "names"; false if absent.
+bool ParseEnumFlag(const char* name, const char* const names[], int n,
+                   int* value) {
+  for (int i = 0; i < n; i++) {
+    if (strcmp(name, names[i]) == 0) {
+      *value = i;
+      return true;
+    }
+  }
+  return false;
+}
+
 // Helper for quickly generating random data.
 class RandomGenerator {
  private:
@@ -150,6 +280,133 @@ class RandomGenerator {
   }
 };
 
+// Uniform double in [0, 1)
+static double RandomDouble(Random* rnd) {
+  return (rnd->Next() - 1) / 2147483646.0;
+}
+
+// Zipfian ranks in [0, items), 0 the most popular, using the method of
+// Gray et al., "Quickly Generating Billion-Record Synthetic Databases"
+// (as in YCSB).  The zeta constant is extended incrementally as the number
+// of items grows, so copies made after Prepare() are cheap to start.
+class ZipfianGenerator {
+ public:
+  explicit ZipfianGenerator(double theta)
+      : theta_(theta),
+        alpha_(1.0 / (1.0 - theta)),
+        zeta2_(1.0 + pow(0.5, theta)),
+        items_(0),
+        zetan_(0),
+        eta_(0) {
+  }
+
+  void Prepare(uint64_t items) {
+    if (items <= items_) return;
+    for (uint64_t i = items_; i < items; i++) {
+      zetan_ += 1.0 / pow(static_cast<double>(i + 1), theta_);
+    }
+    items_ = items;
+    eta_ = (1.0 - pow(2.0 / items_, 1.0 - theta_)) / (1.0 - zeta2_ / zetan_);
+  }
+
+  uint64_t Next(Random* rnd, uint64_t items) {
+    Prepare(items);
+    const double u = RandomDouble(rnd);
+    const double uz = u * zetan_;
+    if (uz < 1.0) return 0;
+    if (uz < zeta2_) return 1;
+    uint64_t rank = static_cast<uint64_t>(
+        items_ * pow(eta_ * u - eta_ + 1.0, alpha_));
+    return rank < items_ ? rank : items_ - 1;
+  }
+
+ private:
+  const double theta_;
+  const double alpha_;
+  const double zeta2_;
+  uint64_t items_;
+  double zetan_;
+  double eta_;
+};
+
+enum YCSBDistribution {
+  kYCSBUniform,
+  kYCSBZipfian,
+  kYCSBScrambledZipfian,
+  kYCSBLatest,
+  kYCSBHotspot
+};
+
+// Chooses the key of each YCSB operation among the "items" keys inserted
+// so far.  Not thread-safe; each thread owns one.
+class YCSBKeyChooser {
+ public:
+  YCSBKeyChooser(YCSBDistribution distribution, const ZipfianGenerator& zipf)
+      : distribution_(distribution), zipf_(zipf) { }
+
+  uint64_t Next(Random* rnd, uint64_t items) {
+    switch (distribution_) {
+      case kYCSBUniform:
+        return Uniform(rnd, items);
+      case kYCSBZipfian:
+        return zipf_.Next(rnd, items);
+      case kYCSBScrambledZipfian:
+        return FNVHash64(zipf_.Next(rnd, items)) % items;
+      case kYCSBLatest:
+        return items - 1 - zipf_.Next(rnd, items);
+      case kYCSBHotspot: {
+        uint64_t hot = static_cast<uint64_t>(
+            items * FLAGS_ycsb_hotspot_data_fraction);
+        if (hot == 0) hot = 1;
+        if (hot >= items ||
+            RandomDouble(rnd) < FLAGS_ycsb_hotspot_op_fraction) {
+          return Uniform(rnd, hot < items ? hot : items);
+        }
+        return hot + Uniform(rnd, items - hot);
+      }
+    }
+    return 0;
+  }
+
+ private:
+  static uint64_t Uniform(Random* rnd, uint64_t n) {
+    return ((static_cast<uint64_t>(rnd->Next()) << 31) | rnd->Next()) % n;
+  }
+
+  static uint64_t FNVHash64(uint64_t v) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (int i = 0; i < 8; i++) {
+      hash ^= v & 0xff;
+      hash *= 1099511628211ull;
+      v >>= 8;
+    }
+    return hash;
+  }
+
+  const YCSBDistribution distribution_;
+  ZipfianGenerator zipf_;
+};
+
+// Operation mixes and default key distributions of the YCSB core workloads
+struct YCSBWorkload {
+  const char* name;
+  double read;
+  double update;
+  double insert;
+  double scan;
+  double rmw;
+  YCSBDistribution distribution;
+};
+
+const YCSBWorkload kYCSBWorkloads[] = {
+  { "ycsba", 0.50, 0.50, 0,    0,    0,    kYCSBScrambledZipfian },
+  { "ycsbb", 0.95, 0.05, 0,    0,    0,    kYCSBScrambledZipfian },
+  { "ycsbc", 1.00, 0,    0,    0,    0,    kYCSBScrambledZipfian },
+  { "ycsbd", 0.95, 0,    0.05, 0,    0,    kYCSBLatest },
+  { "ycsbe", 0,    0,    0.05, 0.95, 0,    kYCSBScrambledZipfian },
+  { "ycsbf", 0.50, 0,    0,    0,    0.50, kYCSBScrambledZipfian },
+};
+
 #if defined(__linux)
 static Slice TrimSpace(Slice s) {
   size_t start = 0;
@@ -172,6 +429,212 @@ static void AppendWithSpace(std::string* str, Slice msg) {
   str->append(msg.data(), msg.size());
 }
 
+// Operation types timed separately by Stats
+enum OperationType {
+  kRead,
+  kWrite,
+  kDelete,
+  kSeek,
+  kScan,
+  kRMW,
+  kOthers,
+  kNumOperationTypes
+};
+
+const char* const kOperationTypeNames[] = {
+  "read", "write", "delete", "seek", "scan", "rmw", "other"
+};
+
+// True if Stats times every operation
+static bool MeasureLatency() {
+  return FLAGS_histogram || FLAGS_stats_interval_seconds > 0 ||
+         FLAGS_stats_file != nullptr;
+}
+
+static uint64_t NowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Writes interval and per-benchmark latency records to --stats_file.  Every
+// record has the wall-clock time in microseconds, as in the DB's LOG.
+class StatsFile {
+ public:
+  StatsFile(const char* path, int format)
+      : file_(fopen(path, "w")), format_(format) {
+    if (file_ == nullptr) {
+      fprintf(stderr, "cannot open --stats_file %s\n", path);
+      exit(1);
+    }
+    if (format_ == 0) {
+      fprintf(file_, "benchmark,kind,timestamp_us,elapsed_s,ops,ops_per_sec,"
+              "op,count,avg_us,p50_us,p99_us,p99.9_us,p99.99_us,max_us\n");
+    }
+  }
+
+  ~StatsFile() { fclose(file_); }
+
+  // "kind" is "interval" or "total"; "seconds" is the time covered by
+  // "hists", one per OperationType.
+  void Write(const Slice& benchmark, const char* kind, uint64_t timestamp,
+             double elapsed, double seconds, const HdrHistogram* hists) {
+    HdrHistogram all;
+    for (int i = 0; i < kNumOperationTypes; i++) {
+      all.Merge(hists[i]);
+    }
+    const double rate = seconds > 0 ? all.Count() / seconds : 0;
+    if (format_ == 0) {
+      WriteCSVRow(benchmark, kind, timestamp, elapsed, rate, "all", all);
+      for (int i = 0; i < kNumOperationTypes; i++) {
+        if (hists[i].Count() > 0) {
+          WriteCSVRow(benchmark, kind, timestamp, elapsed, rate,
+                      kOperationTypeNames[i], hists[i]);
+        }
+      }
+    } else {
+      fprintf(file_, "{\"benchmark\":\"%s\",\"kind\":\"%s\","
+              "\"timestamp_us\":%llu,\"elapsed_s\":%.3f,\"ops\":%llu,"
+              "\"ops_per_sec\":%.1f,\"latency_us\":{",
+              benchmark.ToString().c_str(), kind,
+              static_cast<unsigned long long>(timestamp), elapsed,
+              static_cast<unsigned long long>(all.Count()), rate);
+      WriteJSONLatency("all", all);
+      for (int i = 0; i < kNumOperationTypes; i++) {
+        if (hists[i].Count() > 0) {
+          fputc(',', file_);
+          WriteJSONLatency(kOperationTypeNames[i], hists[i]);
+        }
+      }
+      fprintf(file_, "}}\n");
+    }
+    fflush(file_);
+  }
+
+ private:
+  void WriteCSVRow(const Slice& benchmark, const char* kind,
+                   uint64_t timestamp, double elapsed, double rate,
+                   const char* op, const HdrHistogram& h) {
+    fprintf(file_, "%s,%s,%llu,%.3f,%llu,%.1f,%s,%llu,"
+            "%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+            benchmark.ToString().c_str(), kind,
+            static_cast<unsigned long long>(timestamp), elapsed,
+            static_cast<unsigned long long>(h.Count()), rate, op,
+            static_cast<unsigned long long>(h.Count()), h.Average() / 1e3,
+            h.Percentile(50) / 1e3, h.Percentile(99) / 1e3,
+            h.Percentile(99.9) / 1e3, h.Percentile(99.99) / 1e3,
+            h.Max() / 1e3);
+  }
+
+  void WriteJSONLatency(const char* op, const HdrHistogram& h) {
+    fprintf(file_, "\"%s\":{\"count\":%llu,\"avg\":%.3f,\"p50\":%.3f,"
+            "\"p99\":%.3f,\"p99.9\":%.3f,\"p99.99\":%.3f,\"max\":%.3f}",
+            op, static_cast<unsigned long long>(h.Count()),
+            h.Average() / 1e3, h.Percentile(50) / 1e3,
+            h.Percentile(99) / 1e3, h.Percentile(99.9) / 1e3,
+            h.Percentile(99.99) / 1e3, h.Max() / 1e3);
+  }
+
+  FILE* file_;
+  const int format_;
+};
+
+StatsFile* g_stats_file = nullptr;
+
+// Prints (and writes to g_stats_file) the throughput and latency
+// percentiles of all threads of a benchmark every
+// --stats_interval_seconds, from a thread of its own so that intervals in
+// which every thread is stalled (e.g. in MakeRoomForWrite) still show up.
+// Threads hand over their timings with Merge() a few times a second.
+class IntervalReporter {
+ public:
+  explicit IntervalReporter(const Slice& name)
+      : name_(name.ToString()), cv_(&mu_), stop_(false), running_(false) { }
+
+  void Start() {
+    start_ = last_ = g_env->NowMicros();
+    running_ = true;
+    g_env->StartThread(&IntervalReporter::ThreadBody, this);
+  }
+
+  void Stop() {
+    MutexLock l(&mu_);
+    stop_ = true;
+    while (running_) {
+      cv_.Wait();
+    }
+  }
+
+  // Add "hists", one per OperationType, to the current interval.
+  void Merge(const HdrHistogram* hists) {
+    MutexLock l(&mu_);
+    for (int i = 0; i < kNumOperationTypes; i++) {
+      hists_[i].Merge(hists[i]);
+    }
+  }
+
+ private:
+  static void ThreadBody(void* arg) {
+    reinterpret_cast<IntervalReporter*>(arg)->Run();
+  }
+
+  void Run() {
+    const uint64_t interval = FLAGS_stats_interval_seconds * 1000000ull;
+    uint64_t next = start_ + interval;
+    mu_.Lock();
+    while (!stop_) {
+      mu_.Unlock();
+      g_env->SleepForMicroseconds(interval < 100000 ? interval : 100000);
+      mu_.Lock();
+      const uint64_t now = g_env->NowMicros();
+      if (now >= next) {
+        Report(now);
+        for (int i = 0; i < kNumOperationTypes; i++) {
+          hists_[i].Clear();
+        }
+        last_ = now;
+        next += interval;
+      }
+    }
+    running_ = false;
+    cv_.SignalAll();
+    mu_.Unlock();
+  }
+
+  void Report(uint64_t now) EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const double seconds = (now - last_) * 1e-6;
+    const double elapsed = (now - start_) * 1e-6;
+    uint64_t ops = 0;
+    std::string latency;
+    for (int i = 0; i < kNumOperationTypes; i++) {
+      const HdrHistogram& h = hists_[i];
+      if (h.Count() == 0) continue;
+      ops += h.Count();
+      char buf[200];
+      snprintf(buf, sizeof(buf),
+               "; %s P50 %.1f P99 %.1f P99.9 %.1f P99.99 %.1f",
+               kOperationTypeNames[i], h.Percentile(50) / 1e3,
+               h.Percentile(99) / 1e3, h.Percentile(99.9) / 1e3,
+               h.Percentile(99.99) / 1e3);
+      latency.append(buf);
+    }
+    fprintf(stdout, "%-12s : %8.1f s %11.0f ops/s%s\n",
+            name_.c_str(), elapsed, ops / seconds, latency.c_str());
+    fflush(stdout);
+    if (g_stats_file != nullptr) {
+      g_stats_file->Write(name_, "interval", now, elapsed, seconds, hists_);
+    }
+  }
+
+  const std::string name_;
+  port::Mutex mu_;
+  port::CondVar cv_ GUARDED_BY(mu_);
+  bool stop_ GUARDED_BY(mu_);
+  bool running_ GUARDED_BY(mu_);
+  uint64_t start_;
+  uint64_t last_ GUARDED_BY(mu_);
+  HdrHistogram hists_[kNumOperationTypes] GUARDED_BY(mu_);
+};
+
 class Stats {
  private:
   double start_;
@@ -180,17 +643,36 @@ class Stats {
   int done_;
   int next_report_;
   int64_t bytes_;
-  double last_op_finish_;
+  uint64_t last_op_finish_;  // NowNanos()
   Histogram hist_;
+  HdrHistogram op_hist_[kNumOperationTypes];
   std::string message_;
+  // Timings not yet handed to the interval reporter, if any
+  IntervalReporter* reporter_;
+  HdrHistogram interval_hist_[kNumOperationTypes];
+  uint64_t next_flush_;
+
+  void FlushInterval() {
+    reporter_->Merge(interval_hist_);
+    for (int i = 0; i < kNumOperationTypes; i++) {
+      interval_hist_[i].Clear();
+    }
+  }
 
  public:
-  Stats() { Start(); }
+  Stats() : reporter_(nullptr) { Start(); }
+
+  void SetReporter(IntervalReporter* reporter) { reporter_ = reporter; }
 
   void Start() {
     next_report_ = 100;
-    last_op_finish_ = start_;
+    last_op_finish_ = NowNanos();
+    next_flush_ = last_op_finish_ + 100000000;  // 100ms
     hist_.Clear();
+    for (int i = 0; i < kNumOperationTypes; i++) {
+      op_hist_[i].Clear();
+      interval_hist_[i].Clear();
+    }
     done_ = 0;
     bytes_ = 0;
     seconds_ = 0;
@@ -201,6 +683,9 @@ class Stats {
 
   void Merge(const Stats& other) {
     hist_.Merge(other.hist_);
+    for (int i = 0; i < kNumOperationTypes; i++) {
+      op_hist_[i].Merge(other.op_hist_[i]);
+    }
     done_ += other.done_;
     bytes_ += other.bytes_;
     seconds_ += other.seconds_;
@@ -214,20 +699,32 @@ class Stats {
   void Stop() {
     finish_ = g_env->NowMicros();
     seconds_ = (finish_ - start_) * 1e-6;
+    if (reporter_ != nullptr) FlushInterval();
   }
 
   void AddMessage(Slice msg) {
     AppendWithSpace(&message_, msg);
   }
 
-  void FinishedSingleOp() {
-    if (FLAGS_histogram) {
-      double now = g_env->NowMicros();
-      double micros = now - last_op_finish_;
-      hist_.Add(micros);
-      if (micros > 20000) {
-        fprintf(stderr, "long op: %.1f micros%30s\r", micros, "");
-        fflush(stderr);
+  void FinishedSingleOp(OperationType type = kOthers) {
+    if (MeasureLatency()) {
+      uint64_t now = NowNanos();
+      uint64_t nanos = now - last_op_finish_;
+      op_hist_[type].Add(nanos);
+      if (reporter_ != nullptr) {
+        interval_hist_[type].Add(nanos);
+        if (now >= next_flush_) {
+          FlushInterval();
+          next_flush_ = now + 100000000;
+        }
+      }
+      if (FLAGS_histogram) {
+        double micros = nanos * 1e-3;
+        hist_.Add(micros);
+        if (micros > 20000) {
+          fprintf(stderr, "long op: %.1f micros%30s\r", micros, "");
+          fflush(stderr);
+        }
       }
       last_op_finish_ = now;
     }
@@ -275,6 +772,17 @@ class Stats {
     if (FLAGS_histogram) {
       fprintf(stdout, "Microseconds per op:\n%s\n", hist_.ToString().c_str());
     }
+    if (MeasureLatency()) {
+      for (int i = 0; i < kNumOperationTypes; i++) {
+        if (op_hist_[i].Count() == 0) continue;
+        fprintf(stdout, "%-12s   %-6s micros: %s\n", "",
+                kOperationTypeNames[i], op_hist_[i].ToString(1e3).c_str());
+      }
+      if (g_stats_file != nullptr) {
+        g_stats_file->Write(name, "total", finish_, (finish_ - start_) * 1e-6,
+                            (finish_ - start_) * 1e-6, op_hist_);
+      }
+    }
     fflush(stdout);
     //std::cout << "+++++XD+++++" << std::endl;
   }
@@ -319,7 +827,9 @@ struct ThreadState {
 class Benchmark {
  private:
   Cache* cache_;
+  Cache* pmem_row_cache_;
   const FilterPolicy* filter_policy_;
+  Statistics* statistics_;
   DB* db_;
   int num_;
   int value_size_;
@@ -327,6 +837,11 @@ class Benchmark {
   WriteOptions write_options_;
   int reads_;
   int heap_counter_;
+  // YCSB: workload of the running ycsb* benchmark, the zipfian generator
+  // threads start from, and keys inserted past FLAGS_num so far
+  YCSBWorkload ycsb_workload_;
+  ZipfianGenerator* ycsb_zipfian_;
+  std::atomic<int64_t> ycsb_inserted_;
 
   void PrintHeader() {
     const int kKeySize = 16;
@@ -342,6 +857,18 @@ class Benchmark {
     fprintf(stdout, "FileSize:   %.1f MB (estimated)\n",
             (((kKeySize + FLAGS_value_size * FLAGS_compression_ratio) * num_)
              / 1048576.0));
+    if (FLAGS_sst_type == kPmemSST) {
+      fprintf(stdout, "Tables:     pmem %s, tiering %s, buffer %s\n",
+              kDSTypeNames[FLAGS_ds_type], kTieringNames[FLAGS_tiering],
+              FLAGS_use_pmem_buffer ? "on" : "off");
+    } else {
+      fprintf(stdout, "Tables:     sst\n");
+    }
+    fprintf(stdout, "PMEM pools: %s (buffer %.0f MB x %d, skiplist %.0f MB x %d)\n",
+            FLAGS_pmem_dir != nullptr ? FLAGS_pmem_dir : "pmem/layout.h paths",
+            static_cast<double>(BUFFER_POOL_SIZE) / 1048576.0, NUM_OF_BUFFER,
+            static_cast<double>(SKIPLIST_MANAGER_POOL_SIZE) / 1048576.0,
+            NUM_OF_SKIPLIST_MANAGER);
     PrintWarnings();
     fprintf(stdout, "------------------------------------------------\n");
   }
@@ -405,15 +932,22 @@ class Benchmark {
  public:
   Benchmark()
   : cache_(FLAGS_cache_size >= 0 ? NewLRUCache(FLAGS_cache_size) : nullptr),
+    pmem_row_cache_(FLAGS_pmem_row_cache_size > 0
+                    ? NewLRUCache(FLAGS_pmem_row_cache_size)
+                    : nullptr),
     filter_policy_(FLAGS_bloom_bits >= 0
                    ? NewBloomFilterPolicy(FLAGS_bloom_bits)
                    : nullptr),
+    statistics_(FLAGS_statistics ? NewStatistics() : nullptr),
     db_(nullptr),
     num_(FLAGS_num),
     value_size_(FLAGS_value_size),
     entries_per_batch_(1),
     reads_(FLAGS_reads < 0 ? FLAGS_num : FLAGS_reads),
-    heap_counter_(0) {
+    heap_counter_(0),
+    ycsb_workload_(kYCSBWorkloads[0]),
+    ycsb_zipfian_(nullptr),
+    ycsb_inserted_(0) {
     std::vector<std::string> files;
     g_env->GetChildren(FLAGS_db, &files);
     for (size_t i = 0; i < files.size(); i++) {
@@ -429,7 +963,10 @@ class Benchmark {
   ~Benchmark() {
     delete db_;
     delete cache_;
+    delete pmem_row_cache_;
     delete filter_policy_;
+    delete statistics_;
+    delete ycsb_zipfian_;
   }
 
   void Run() {
@@ -518,12 +1055,20 @@ class Benchmark {
         method = &Benchmark::SnappyCompress;
       } else if (name == Slice("snappyuncomp")) {
         method = &Benchmark::SnappyUncompress;
+      } else if (name.starts_with("ycsb") && SetYCSBWorkload(name)) {
+        method = &Benchmark::YCSB;
       } else if (name == Slice("heapprofile")) {
         HeapProfile();
       } else if (name == Slice("stats")) {
         PrintStats("leveldb.stats");
       } else if (name == Slice("sstables")) {
         PrintStats("leveldb.sstables");
+      } else if (name == Slice("tierstats")) {
+        PrintStats("leveldb.tier-stats");
+      } else if (name == Slice("pmemstats")) {
+        PrintStats("leveldb.pmem-stats");
+      } else if (name == Slice("amplification")) {
+        PrintStats("leveldb.amplification");
       } else {
         if (name != Slice()) {  // No error message for empty name
           fprintf(stderr, "unknown benchmark '%s'\n", name.ToString().c_str());
@@ -539,12 +1084,16 @@ class Benchmark {
           delete db_;
           db_ = nullptr;
           DestroyDB(FLAGS_db, Options());
+          ycsb_inserted_ = 0;
           Open();
         }
       }
 
       if (method != nullptr) {
         RunBenchmark(num_threads, name, method);
+        if (FLAGS_tier_stats && db_ != nullptr) {
+          PrintStats("leveldb.tier-stats");
+        }
       }
     }
   }
@@ -572,9 +1121,15 @@ class Benchmark {
       }
     }
 
+    SetPerfLevel(static_cast<PerfLevel>(FLAGS_perf_level));
+    GetPerfContext()->Reset();
     thread->stats.Start();
     (arg->bm->*(arg->method))(thread);
     thread->stats.Stop();
+    if (FLAGS_perf_level > kPerfDisabled) {
+      fprintf(stdout, "thread %d perf: %s\n", thread->tid,
+              GetPerfContext()->ToString().c_str());
+    }
 
     {
       MutexLock l(&shared->mu);
@@ -588,6 +1143,10 @@ class Benchmark {
   void RunBenchmark(int n, Slice name,
                     void (Benchmark::*method)(ThreadState*)) {
     SharedState shared(n);
+    IntervalReporter* reporter = nullptr;
+    if (FLAGS_stats_interval_seconds > 0) {
+      reporter = new IntervalReporter(name);
+    }
 
     ThreadArg* arg = new ThreadArg[n];
     for (int i = 0; i < n; i++) {
@@ -596,6 +1155,7 @@ class Benchmark {
       arg[i].shared = &shared;
       arg[i].thread = new ThreadState(i);
       arg[i].thread->shared = &shared;
+      arg[i].thread->stats.SetReporter(reporter);
       g_env->StartThread(ThreadBody, &arg[i]);
     }
 
@@ -604,12 +1164,17 @@ class Benchmark {
       shared.cv.Wait();
     }
 
+    if (reporter != nullptr) reporter->Start();
     shared.start = true;
     shared.cv.SignalAll();
     while (shared.num_done < n) {
       shared.cv.Wait();
     }
     shared.mu.Unlock();
+    if (reporter != nullptr) {
+      reporter->Stop();
+      delete reporter;
+    }
 
     for (int i = 1; i < n; i++) {
       arg[0].thread->stats.Merge(arg[i].thread->stats);
@@ -716,6 +1281,20 @@ class Benchmark {
     options.max_open_files = FLAGS_open_files;
     options.filter_policy = filter_policy_;
     options.reuse_logs = FLAGS_reuse_logs;
+    options.sst_type = FLAGS_sst_type;
+    options.ds_type = FLAGS_ds_type;
+    options.tiering_option = FLAGS_tiering;
+    options.use_pmem_buffer = FLAGS_use_pmem_buffer;
+    options.skiplist_cache = FLAGS_skiplist_cache;
+    options.use_pmem_log = FLAGS_use_pmem_log;
+    options.use_pmem_memtable = FLAGS_use_pmem_memtable;
+    options.pmem_value_compression = FLAGS_pmem_value_compression;
+    options.pmem_key_restart_interval = FLAGS_pmem_key_restart_interval;
+    options.pmem_row_cache = pmem_row_cache_;
+    options.statistics = statistics_;
+    if (FLAGS_pmem_dir != nullptr) {
+      options.pmem_dir = FLAGS_pmem_dir;
+    }
     Status s = DB::Open(options, FLAGS_db, &db_);
     if (!s.ok()) {
       fprintf(stderr, "open error: %s\n", s.ToString().c_str());
@@ -758,7 +1337,7 @@ class Benchmark {
         snprintf(key, sizeof(key), "%016d", k);
         batch.Put(key, gen.Generate(value_size_));
         bytes += value_size_ + strlen(key);
-        thread->stats.FinishedSingleOp();
+        thread->stats.FinishedSingleOp(kWrite);
       }
       s = db_->Write(write_options_, &batch);
       if (!s.ok()) {
@@ -775,7 +1354,7 @@ class Benchmark {
     int64_t bytes = 0;
     for (iter->SeekToFirst(); i < reads_ && iter->Valid(); iter->Next()) {
       bytes += iter->key().size() + iter->value().size();
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
       ++i;
     }
     delete iter;
@@ -793,7 +1372,7 @@ class Benchmark {
     for (iter->SeekToLast(); i < reads_ && iter->Valid(); iter->Prev()) {
       //std::cout << "read reverse key" << std::endl; 
       bytes += iter->key().size() + iter->value().size();
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
       ++i;
     }
     delete iter;
@@ -817,7 +1396,7 @@ class Benchmark {
         printf("Cannot seek key:'%s'\n", key);
       }
       */
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
     }
     char msg[100];
     snprintf(msg, sizeof(msg), "(%d of %d found)", found, num_);
@@ -832,7 +1411,7 @@ class Benchmark {
       const int k = thread->rand.Next() % FLAGS_num;
       snprintf(key, sizeof(key), "%016d.", k);
       db_->Get(options, key, &value);
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
     }
   }
 
@@ -845,7 +1424,7 @@ class Benchmark {
       const int k = thread->rand.Next() % range;
       snprintf(key, sizeof(key), "%016d", k);
       db_->Get(options, key, &value);
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kRead);
     }
   }
 
@@ -860,13 +1439,127 @@ class Benchmark {
       iter->Seek(key);
       if (iter->Valid() && iter->key() == key) found++;
       delete iter;
-      thread->stats.FinishedSingleOp();
+      thread->stats.FinishedSingleOp(kSeek);
     }
     char msg[100];
     snprintf(msg, sizeof(msg), "(%d of %d found)", found, num_);
     thread->stats.AddMessage(msg);
   }
 
+  // Set ycsb_workload_ to the workload called "name" with the --ycsb_*
+  // overrides applied.  Returns false if there is no such workload.
+  bool SetYCSBWorkload(const Slice& name) {
+    for (size_t i = 0; i < sizeof(kYCSBWorkloads) / sizeof(kYCSBWorkloads[0]);
+         i++) {
+      if (name != Slice(kYCSBWorkloads[i].name)) continue;
+      YCSBWorkload w = kYCSBWorkloads[i];
+      if (FLAGS_ycsb_read_proportion >= 0) w.read = FLAGS_ycsb_read_proportion;
+      if (FLAGS_ycsb_update_proportion >= 0) {
+        w.update = FLAGS_ycsb_update_proportion;
+      }
+      if (FLAGS_ycsb_insert_proportion >= 0) {
+        w.insert = FLAGS_ycsb_insert_proportion;
+      }
+      if (FLAGS_ycsb_scan_proportion >= 0) w.scan = FLAGS_ycsb_scan_proportion;
+      if (FLAGS_ycsb_rmw_proportion >= 0) w.rmw = FLAGS_ycsb_rmw_proportion;
+      if (FLAGS_ycsb_distribution >= 0) {
+        w.distribution = static_cast<YCSBDistribution>(FLAGS_ycsb_distribution);
+      }
+      const double total = w.read + w.update + w.insert + w.scan + w.rmw;
+      if (total <= 0) {
+        fprintf(stderr, "%s: operation proportions sum to zero\n", w.name);
+        exit(1);
+      }
+      w.read /= total;
+      w.update /= total;
+      w.insert /= total;
+      w.scan /= total;
+      w.rmw /= total;
+      ycsb_workload_ = w;
+
+      // Compute the zeta constant once, outside the timed section
+      if (ycsb_zipfian_ == nullptr) {
+        ycsb_zipfian_ = new ZipfianGenerator(FLAGS_ycsb_zipfian_constant);
+      }
+      ycsb_zipfian_->Prepare(FLAGS_num + ycsb_inserted_.load());
+      return true;
+    }
+    return false;
+  }
+
+  // Runs reads_ operations of ycsb_workload_ in each thread.  Inserts add
+  // keys after the FLAGS_num loaded ones, and later operations (and later
+  // ycsb* benchmarks) choose among those too.
+  void YCSB(ThreadState* thread) {
+    const YCSBWorkload& w = ycsb_workload_;
+    YCSBKeyChooser chooser(w.distribution, *ycsb_zipfian_);
+    RandomGenerator gen;
+    ReadOptions options;
+    std::string value;
+    int64_t bytes = 0;
+    int reads = 0;
+    int found = 0;
+    char key[100];
+    for (int i = 0; i < reads_; i++) {
+      const uint64_t items = FLAGS_num + ycsb_inserted_.load();
+      const double op = RandomDouble(&thread->rand);
+      OperationType type;
+      Status s;
+      if (op < w.read + w.rmw) {
+        type = op < w.read ? kRead : kRMW;
+        const uint64_t k = chooser.Next(&thread->rand, items);
+        snprintf(key, sizeof(key), "%016llu",
+                 static_cast<unsigned long long>(k));
+        reads++;
+        if (db_->Get(options, key, &value).ok()) {
+          found++;
+          bytes += value.size();
+        }
+        if (op >= w.read) {
+          // Read-modify-write
+          s = db_->Put(write_options_, key, gen.Generate(value_size_));
+          bytes += value_size_ + strlen(key);
+        }
+      } else if (op < w.read + w.rmw + w.update) {
+        type = kWrite;
+        const uint64_t k = chooser.Next(&thread->rand, items);
+        snprintf(key, sizeof(key), "%016llu",
+                 static_cast<unsigned long long>(k));
+        s = db_->Put(write_options_, key, gen.Generate(value_size_));
+        bytes += value_size_ + strlen(key);
+      } else if (op < w.read + w.rmw + w.update + w.insert) {
+        type = kWrite;
+        const uint64_t k = FLAGS_num + ycsb_inserted_.fetch_add(1);
+        snprintf(key, sizeof(key), "%016llu",
+                 static_cast<unsigned long long>(k));
+        s = db_->Put(write_options_, key, gen.Generate(value_size_));
+        bytes += value_size_ + strlen(key);
+      } else {
+        type = kScan;
+        const uint64_t k = chooser.Next(&thread->rand, items);
+        snprintf(key, sizeof(key), "%016llu",
+                 static_cast<unsigned long long>(k));
+        const int length = 1 + thread->rand.Uniform(FLAGS_ycsb_max_scan_length);
+        Iterator* iter = db_->NewIterator(options);
+        iter->Seek(key);
+        for (int j = 0; j < length && iter->Valid(); j++) {
+          bytes += iter->key().size() + iter->value().size();
+          iter->Next();
+        }
+        delete iter;
+      }
+      if (!s.ok()) {
+        fprintf(stderr, "put error: %s\n", s.ToString().c_str());
+        exit(1);
+      }
+      thread->stats.FinishedSingleOp(type);
+    }
+    thread->stats.AddBytes(bytes);
+    char msg[100];
+    snprintf(msg, sizeof(msg), "(%d of %d found)", found, reads);
+    thread->stats.AddMessage(msg);
+  }
+
   void DoDelete(ThreadState* thread, bool seq) {
     RandomGenerator gen;
     WriteBatch batch;
@@ -878,7 +1571,7 @@ class Benchmark {
         char key[100];
         snprintf(key, sizeof(key), "%016d", k);
         batch.Delete(key);
-        thread->stats.FinishedSingleOp();
+        thread->stats.FinishedSingleOp(kDelete);
       }
       s = db_->Write(write_options_, &batch);
       if (!s.ok()) {
@@ -967,6 +1660,16 @@ int main(int argc, char** argv) {
   FLAGS_max_file_size = leveldb::Options().max_file_size;
   FLAGS_block_size = leveldb::Options().block_size;
   FLAGS_open_files = leveldb::Options().max_open_files;
+  FLAGS_sst_type = leveldb::Options().sst_type;
+  FLAGS_ds_type = leveldb::Options().ds_type;
+  FLAGS_tiering = leveldb::Options().tiering_option;
+  FLAGS_use_pmem_buffer = leveldb::Options().use_pmem_buffer;
+  FLAGS_skiplist_cache = leveldb::Options().skiplist_cache;
+  FLAGS_use_pmem_log = leveldb::Options().use_pmem_log;
+  FLAGS_use_pmem_memtable = leveldb::Options().use_pmem_memtable;
+  FLAGS_pmem_value_compression = leveldb::Options().pmem_value_compression;
+  FLAGS_pmem_key_restart_interval =
+      leveldb::Options().pmem_key_restart_interval;
   std::string default_db_path;
 
   for (int i = 1; i < argc; i++) {
@@ -980,6 +1683,15 @@ int main(int argc, char** argv) {
     } else if (sscanf(argv[i], "--histogram=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_histogram = n;
+    } else if (sscanf(argv[i], "--stats_interval_seconds=%d%c",
+                      &n, &junk) == 1 && n >= 0) {
+      FLAGS_stats_interval_seconds = n;
+    } else if (strncmp(argv[i], "--stats_file=", 13) == 0) {
+      FLAGS_stats_file = argv[i] + 13;
+    } else if (strncmp(argv[i], "--stats_format=", 15) == 0 &&
+               leveldb::ParseEnumFlag(argv[i] + 15, leveldb::kStatsFormatNames,
+                                      2, &n)) {
+      FLAGS_stats_format = n;
     } else if (sscanf(argv[i], "--use_existing_db=%d%c", &n, &junk) == 1 &&
                (n == 0 || n == 1)) {
       FLAGS_use_existing_db = n;
@@ -1008,6 +1720,84 @@ int main(int argc, char** argv) {
       FLAGS_open_files = n;
     } else if (strncmp(argv[i], "--db=", 5) == 0) {
       FLAGS_db = argv[i] + 5;
+    } else if (strncmp(argv[i], "--sst_type=", 11) == 0 &&
+               leveldb::ParseEnumFlag(argv[i] + 11, leveldb::kSSTTypeNames,
+                                      2, &n)) {
+      FLAGS_sst_type = static_cast<leveldb::SSTMakerType>(n);
+    } else if (strncmp(argv[i], "--ds_type=", 10) == 0 &&
+               leveldb::ParseEnumFlag(argv[i] + 10, leveldb::kDSTypeNames,
+                                      2, &n)) {
+      FLAGS_ds_type = static_cast<leveldb::PmemDataStructrueType>(n);
+    } else if (strncmp(argv[i], "--tiering=", 10) == 0 &&
+               leveldb::ParseEnumFlag(argv[i] + 10, leveldb::kTieringNames,
+                                      4, &n)) {
+      FLAGS_tiering = static_cast<leveldb::TieringOption>(n);
+    } else if (strncmp(argv[i], "--pmem_value_compression=", 25) == 0 &&
+               leveldb::ParseEnumFlag(argv[i] + 25,
+                                      leveldb::kCompressionNames, 4, &n)) {
+      FLAGS_pmem_value_compression = static_cast<leveldb::CompressionType>(n);
+    } else if (sscanf(argv[i], "--use_pmem_buffer=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_use_pmem_buffer = n;
+    } else if (sscanf(argv[i], "--skiplist_cache=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_skiplist_cache = n;
+    } else if (sscanf(argv[i], "--use_pmem_log=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_use_pmem_log = n;
+    } else if (sscanf(argv[i], "--use_pmem_memtable=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_use_pmem_memtable = n;
+    } else if (sscanf(argv[i], "--pmem_key_restart_interval=%d%c",
+                      &n, &junk) == 1) {
+      FLAGS_pmem_key_restart_interval = n;
+    } else if (sscanf(argv[i], "--pmem_row_cache_size=%d%c", &n, &junk) == 1) {
+      FLAGS_pmem_row_cache_size = n;
+    } else if (strncmp(argv[i], "--pmem_dir=", 11) == 0) {
+      FLAGS_pmem_dir = argv[i] + 11;
+    } else if (sscanf(argv[i], "--tier_stats=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_tier_stats = n;
+    } else if (sscanf(argv[i], "--statistics=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_statistics = n;
+    } else if (sscanf(argv[i], "--perf_level=%d%c", &n, &junk) == 1 &&
+               n >= leveldb::kPerfDisabled && n <= leveldb::kPerfEnableTime) {
+      FLAGS_perf_level = n;
+    } else if (strncmp(argv[i], "--trace_file=", 13) == 0) {
+      FLAGS_trace_file = argv[i] + 13;
+    } else if (sscanf(argv[i], "--ycsb_read_proportion=%lf%c",
+                      &d, &junk) == 1) {
+      FLAGS_ycsb_read_proportion = d;
+    } else if (sscanf(argv[i], "--ycsb_update_proportion=%lf%c",
+                      &d, &junk) == 1) {
+      FLAGS_ycsb_update_proportion = d;
+    } else if (sscanf(argv[i], "--ycsb_insert_proportion=%lf%c",
+                      &d, &junk) == 1) {
+      FLAGS_ycsb_insert_proportion = d;
+    } else if (sscanf(argv[i], "--ycsb_scan_proportion=%lf%c",
+                      &d, &junk) == 1) {
+      FLAGS_ycsb_scan_proportion = d;
+    } else if (sscanf(argv[i], "--ycsb_rmw_proportion=%lf%c",
+                      &d, &junk) == 1) {
+      FLAGS_ycsb_rmw_proportion = d;
+    } else if (strncmp(argv[i], "--ycsb_distribution=", 20) == 0 &&
+               leveldb::ParseEnumFlag(argv[i] + 20,
+                                      leveldb::kYCSBDistributionNames,
+                                      5, &n)) {
+      FLAGS_ycsb_distribution = n;
+    } else if (sscanf(argv[i], "--ycsb_zipfian_constant=%lf%c",
+                      &d, &junk) == 1 && d > 0 && d < 1) {
+      FLAGS_ycsb_zipfian_constant = d;
+    } else if (sscanf(argv[i], "--ycsb_max_scan_length=%d%c",
+                      &n, &junk) == 1 && n > 0) {
+      FLAGS_ycsb_max_scan_length = n;
+    } else if (sscanf(argv[i], "--ycsb_hotspot_data_fraction=%lf%c",
+                      &d, &junk) == 1 && d >= 0 && d <= 1) {
+      FLAGS_ycsb_hotspot_data_fraction = d;
+    } else if (sscanf(argv[i], "--ycsb_hotspot_op_fraction=%lf%c",
+                      &d, &junk) == 1 && d >= 0 && d <= 1) {
+      FLAGS_ycsb_hotspot_op_fraction = d;
     } else {
       fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
       exit(1);
@@ -1023,7 +1813,28 @@ int main(int argc, char** argv) {
       FLAGS_db = default_db_path.c_str();
   }
 
+  if (FLAGS_stats_file != nullptr) {
+    leveldb::g_stats_file =
+        new leveldb::StatsFile(FLAGS_stats_file, FLAGS_stats_format);
+  }
+
+  if (FLAGS_trace_file != nullptr) {
+    leveldb::Status s = leveldb::StartTrace(leveldb::Env::Default(),
+                                            FLAGS_trace_file);
+    if (!s.ok()) {
+      fprintf(stderr, "trace: %s\n", s.ToString().c_str());
+      exit(1);
+    }
+  }
+
   leveldb::Benchmark benchmark;
   benchmark.Run();
+  if (FLAGS_trace_file != nullptr) {
+    leveldb::Status s = leveldb::EndTrace();
+    if (!s.ok()) {
+      fprintf(stderr, "trace: %s\n", s.ToString().c_str());
+    }
+  }
+  delete leveldb::g_stats_file;
   return 0;
 }
@@ -6,6 +6,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <time.h>
 
 #include <algorithm>
 #include <set>
@@ -15,6 +16,7 @@
 #include "db/builder.h"
 #include "db/db_iter.h"
 #include "db/dbformat.h"
+#include "db/event_log.h"
 #include "db/filename.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
@@ -22,8 +24,11 @@
 #include "db/table_cache.h"
 #include "db/version_set.h"
 #include "db/write_batch_internal.h"
+#include "pmem/pmem_log.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "leveldb/listener.h"
+#include "leveldb/statistics.h"
 #include "leveldb/status.h"
 #include "leveldb/table.h"
 #include "leveldb/table_builder.h"
@@ -34,12 +39,26 @@
 #include "util/coding.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
+#include "util/perf_context_imp.h"
+#include "util/trace_imp.h"
 
 
 namespace leveldb {
 
 const int kNumNonTableCacheFiles = 10;
 
+static_assert(Statistics::kNumLevels == config::kNumLevels,
+              "level tickers must cover every level");
+
+// CPU time consumed by the calling thread
+static uint64_t ThreadCpuMicros() {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
 // Information kept for every waiting writer
 struct DBImpl::Writer {
   Status status;
@@ -64,6 +83,7 @@ struct DBImpl::CompactionState {
   struct Output {
     uint64_t number;
     uint64_t file_size;
+    uint64_t pmem_bytes;  // Bytes written to the pmem-buffer (PMEM tables)
     InternalKey smallest, largest;
   };
   /*----------------------------------*/
@@ -99,6 +119,15 @@ static void ClipToRange(T* ptr, V minvalue, V maxvalue) {
   if (static_cast<V>(*ptr) > maxvalue) *ptr = maxvalue;
   if (static_cast<V>(*ptr) < minvalue) *ptr = minvalue;
 }
+// Largest batch group BuildBatchGroup() forms from several writers
+static const size_t kMaxBatchGroupBytes = 1 << 20;
+
+// Upper bound on the bytes log::Writer::AddRecord appends for a record of
+// n bytes: a header in every block it touches plus one block trailer.
+static uint64_t MaxLogRecordBytes(uint64_t n) {
+  return n + (n / (log::kBlockSize - log::kHeaderSize) + 2) * log::kHeaderSize;
+}
+
 Options SanitizeOptions(const std::string& dbname,
                         const InternalKeyComparator* icmp,
                         const InternalFilterPolicy* ipolicy,
@@ -122,6 +151,9 @@ Options SanitizeOptions(const std::string& dbname,
   }
   if (result.block_cache == nullptr) {
     result.block_cache = NewLRUCache(8 << 20);
+  }
+  if (result.statistics == nullptr) {
+    result.statistics = NewStatistics();
   }
     // SOLVE: JH
   if (result.sst_type == kPmemSST) {
@@ -129,19 +161,19 @@ Options SanitizeOptions(const std::string& dbname,
       // DS_Option1: Skiplist
       case kSkiplist:
         result.pmem_skiplist = new PmemSkiplist*[NUM_OF_SKIPLIST_MANAGER];
-        result.pmem_skiplist[0] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_0);
-        result.pmem_skiplist[1] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_1);
-        result.pmem_skiplist[2] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_2);
-        result.pmem_skiplist[3] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_3);
-        result.pmem_skiplist[4] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_4);
-        result.pmem_skiplist[5] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_5);
-        result.pmem_skiplist[6] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_6);
-        result.pmem_skiplist[7] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_7);
-        result.pmem_skiplist[8] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_8);
-        result.pmem_skiplist[9] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_9);
-
-        // result.pmem_skiplist[10] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_10);
-        // result.pmem_skiplist[11] = new PmemSkiplist(SKIPLIST_MANAGER_PATH_11);
+        result.pmem_skiplist[0] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_0));
+        result.pmem_skiplist[1] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_1));
+        result.pmem_skiplist[2] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_2));
+        result.pmem_skiplist[3] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_3));
+        result.pmem_skiplist[4] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_4));
+        result.pmem_skiplist[5] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_5));
+        result.pmem_skiplist[6] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_6));
+        result.pmem_skiplist[7] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_7));
+        result.pmem_skiplist[8] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_8));
+        result.pmem_skiplist[9] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_9));
+
+        // result.pmem_skiplist[10] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_10));
+        // result.pmem_skiplist[11] = new PmemSkiplist(PmemPoolPath(result.pmem_dir, SKIPLIST_MANAGER_PATH_11));
         
         // Initialize
         for (int i=0; i<NUM_OF_SKIPLIST_MANAGER; i++) {
@@ -169,16 +201,16 @@ Options SanitizeOptions(const std::string& dbname,
       // DS_Option2: Hashmap
       case kHashmap:
         result.pmem_hashmap = new PmemHashmap*[NUM_OF_HASHMAP];
-        result.pmem_hashmap[0] = new PmemHashmap(HASHMAP_PATH_0);
-        result.pmem_hashmap[1] = new PmemHashmap(HASHMAP_PATH_1);
-        result.pmem_hashmap[2] = new PmemHashmap(HASHMAP_PATH_2);
-        result.pmem_hashmap[3] = new PmemHashmap(HASHMAP_PATH_3);
-        result.pmem_hashmap[4] = new PmemHashmap(HASHMAP_PATH_4);
-        result.pmem_hashmap[5] = new PmemHashmap(HASHMAP_PATH_5);
-        result.pmem_hashmap[6] = new PmemHashmap(HASHMAP_PATH_6);
-        result.pmem_hashmap[7] = new PmemHashmap(HASHMAP_PATH_7);
-        result.pmem_hashmap[8] = new PmemHashmap(HASHMAP_PATH_8);
-        result.pmem_hashmap[9] = new PmemHashmap(HASHMAP_PATH_9);
+        result.pmem_hashmap[0] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_0));
+        result.pmem_hashmap[1] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_1));
+        result.pmem_hashmap[2] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_2));
+        result.pmem_hashmap[3] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_3));
+        result.pmem_hashmap[4] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_4));
+        result.pmem_hashmap[5] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_5));
+        result.pmem_hashmap[6] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_6));
+        result.pmem_hashmap[7] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_7));
+        result.pmem_hashmap[8] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_8));
+        result.pmem_hashmap[9] = new PmemHashmap(PmemPoolPath(result.pmem_dir, HASHMAP_PATH_9));
 
         // Initialize
         for (int i=0; i<NUM_OF_HASHMAP; i++) {
@@ -205,28 +237,48 @@ Options SanitizeOptions(const std::string& dbname,
   if (result.use_pmem_buffer) {
     // PROGRESS:
     result.pmem_buffer = new PmemBuffer*[NUM_OF_BUFFER]; 
-    result.pmem_buffer[0] = new PmemBuffer(BUFFER_PATH_0);
-    result.pmem_buffer[1] = new PmemBuffer(BUFFER_PATH_1);
-    result.pmem_buffer[2] = new PmemBuffer(BUFFER_PATH_2);
-    result.pmem_buffer[3] = new PmemBuffer(BUFFER_PATH_3);
-    result.pmem_buffer[4] = new PmemBuffer(BUFFER_PATH_4);
-    result.pmem_buffer[5] = new PmemBuffer(BUFFER_PATH_5);
-    result.pmem_buffer[6] = new PmemBuffer(BUFFER_PATH_6);
-    result.pmem_buffer[7] = new PmemBuffer(BUFFER_PATH_7);
-    result.pmem_buffer[8] = new PmemBuffer(BUFFER_PATH_8);
-    result.pmem_buffer[9] = new PmemBuffer(BUFFER_PATH_9);
-
-    // result.pmem_buffer[10] = new PmemBuffer(BUFFER_PATH_10);
-    // result.pmem_buffer[11] = new PmemBuffer(BUFFER_PATH_11);
-    // result.pmem_buffer[12] = new PmemBuffer(BUFFER_PATH_12);
-    // result.pmem_buffer[13] = new PmemBuffer(BUFFER_PATH_13);
-    // result.pmem_buffer[14] = new PmemBuffer(BUFFER_PATH_14);
+    result.pmem_buffer[0] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_0));
+    result.pmem_buffer[1] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_1));
+    result.pmem_buffer[2] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_2));
+    result.pmem_buffer[3] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_3));
+    result.pmem_buffer[4] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_4));
+    result.pmem_buffer[5] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_5));
+    result.pmem_buffer[6] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_6));
+    result.pmem_buffer[7] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_7));
+    result.pmem_buffer[8] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_8));
+    result.pmem_buffer[9] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_9));
+
+    // result.pmem_buffer[10] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_10));
+    // result.pmem_buffer[11] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_11));
+    // result.pmem_buffer[12] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_12));
+    // result.pmem_buffer[13] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_13));
+    // result.pmem_buffer[14] = new PmemBuffer(PmemPoolPath(result.pmem_dir, BUFFER_PATH_14));
 
     // Initialize
     for (int i=0; i<NUM_OF_BUFFER; i++) {
       result.pmem_buffer[i]->ClearAll();
     }
   }
+  if (result.use_pmem_memtable) {
+    result.pmem_memtable_buffer = new PmemBuffer(PmemPoolPath(result.pmem_dir, MEMTABLE_BUFFER_PATH));
+    result.pmem_memtable_buffer->ClearAll();
+  }
+  if (result.use_pmem_log) {
+    // Not cleared here: the segments are replayed by Recover()
+    result.pmem_log = new PmemLog(PmemPoolPath(result.pmem_dir, PMEM_LOG_PATH));
+    // A memtable's log must fit in one segment.  Leave room for the
+    // record framing and for the batch group that may push the memtable
+    // past write_buffer_size; larger batches roll over in Write().
+    const uint64_t framing =
+        LOG_SEGMENT_SIZE / log::kBlockSize * 2 * log::kHeaderSize;
+    ClipToRange(&result.write_buffer_size, uint64_t(64<<10),
+                LOG_SEGMENT_SIZE - framing - kMaxBatchGroupBytes);
+  } else {
+    // Open an existing pool anyway so that Recover() can replay the
+    // segments written while use_pmem_log was on.
+    const std::string path = PmemPoolPath(result.pmem_dir, PMEM_LOG_PATH);
+    result.pmem_log = file_exists(path) ? new PmemLog(path) : nullptr;
+  }
   return result;
 }
 
@@ -243,6 +295,8 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
                                &internal_filter_policy_, raw_options)),
       owns_info_log_(options_.info_log != raw_options.info_log),
       owns_cache_(options_.block_cache != raw_options.block_cache),
+      owns_statistics_(options_.statistics != raw_options.statistics),
+      statistics_(options_.statistics),
       dbname_(dbname),
       table_cache_(new TableCache(dbname_, options_, TableCacheSize(options_))),
       db_lock_(nullptr),
@@ -262,7 +316,7 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
       // JH
       total_delayed_micros(0),
       tiering_stats_{},
-      preserve_flag(false)
+      next_job_id_(0)
       {
   has_imm_.Release_Store(nullptr);
 }
@@ -336,6 +390,10 @@ DBImpl::~DBImpl() {
   delete tmp_batch_;
   delete log_;
   delete logfile_;
+  delete options_.pmem_log;
+  if (options_.use_pmem_memtable) {
+    delete options_.pmem_memtable_buffer;
+  }
   delete table_cache_;
 
   if (owns_info_log_) {
@@ -344,6 +402,9 @@ DBImpl::~DBImpl() {
   if (owns_cache_) {
     delete options_.block_cache;
   }
+  if (owns_statistics_) {
+    delete options_.statistics;
+  }
 }
 
 Status DBImpl::NewDB() {
@@ -387,6 +448,30 @@ void DBImpl::MaybeIgnoreError(Status* s) const {
   }
 }
 
+MemTable* DBImpl::NewMemTable() {
+  if (options_.use_pmem_memtable) {
+    // Leave room for the batch that pushes the memtable over the limit
+    MemTable* mem = new MemTable(internal_comparator_,
+                                 options_.pmem_memtable_buffer,
+                                 options_.write_buffer_size + (1 << 20));
+    if (!mem->HasExtent()) {
+      // Extents come back as the PMEM tables linking them are compacted
+      // away, so later memtables may get one again
+      Log(options_.info_log,
+          "pmem memtable pool is full; memtable entries go to DRAM");
+    }
+    return mem;
+  }
+  return new MemTable(internal_comparator_);
+}
+
+Status DBImpl::NewLogFile(uint64_t number, WritableFile** result) {
+  if (options_.use_pmem_log) {
+    return options_.pmem_log->NewLogWriter(number, result);
+  }
+  return env_->NewWritableFile(LogFileName(dbname_, number), result);
+}
+
 void DBImpl::DeleteObsoleteFiles() {
   mutex_.AssertHeld();
 
@@ -444,8 +529,32 @@ void DBImpl::DeleteObsoleteFiles() {
       }
     }
   }
-  
-
+  if (options_.pmem_log != nullptr) {
+    std::vector<uint64_t> pmem_logs;
+    options_.pmem_log->GetLogNumbers(&pmem_logs);
+    for (size_t i = 0; i < pmem_logs.size(); i++) {
+      number = pmem_logs[i];
+      if (number < versions_->LogNumber() &&
+          number != versions_->PrevLogNumber()) {
+        Log(options_.info_log, "Delete pmem log #%lld\n",
+            static_cast<unsigned long long>(number));
+        options_.pmem_log->DeleteLog(number);
+      }
+    }
+  }
+  if (options_.use_pmem_memtable) {
+    size_t kept = 0;
+    for (size_t i = 0; i < pending_extent_unlinks_.size(); i++) {
+      number = pending_extent_unlinks_[i];
+      if (live.find(number) == live.end() ||
+          tiering_stats_.IsInFileSet(number)) {
+        options_.pmem_memtable_buffer->UnlinkExtents(number);
+      } else {
+        pending_extent_unlinks_[kept++] = number;
+      }
+    }
+    pending_extent_unlinks_.resize(kept);
+  }
 }
 
 Status DBImpl::Recover(VersionEdit* edit, bool *save_manifest) {
@@ -467,6 +576,11 @@ Status DBImpl::Recover(VersionEdit* edit, bool *save_manifest) {
       if (!s.ok()) {
         return s;
       }
+      if (options_.pmem_log != nullptr) {
+        // Segments left behind by a destroyed database must not be
+        // replayed into this one.
+        options_.pmem_log->ClearAll();
+      }
     } else {
       return Status::InvalidArgument(
           dbname_, "does not exist (create_if_missing is false)");
@@ -502,12 +616,24 @@ Status DBImpl::Recover(VersionEdit* edit, bool *save_manifest) {
   versions_->AddLiveFiles(&expected);
   uint64_t number;
   FileType type;
-  std::vector<uint64_t> logs;
+  // Log numbers paired with whether they are a pmem_log segment; both kinds
+  // are replayed whatever use_pmem_log is now, since it may have changed.
+  std::vector<std::pair<uint64_t, bool> > logs;
   for (size_t i = 0; i < filenames.size(); i++) {
     if (ParseFileName(filenames[i], &number, &type)) {
       expected.erase(number);
       if (type == kLogFile && ((number >= min_log) || (number == prev_log)))
-        logs.push_back(number);
+        logs.push_back(std::make_pair(number, false));
+    }
+  }
+  if (options_.pmem_log != nullptr) {
+    std::vector<uint64_t> pmem_logs;
+    options_.pmem_log->GetLogNumbers(&pmem_logs);
+    for (size_t i = 0; i < pmem_logs.size(); i++) {
+      number = pmem_logs[i];
+      if ((number >= min_log) || (number == prev_log)) {
+        logs.push_back(std::make_pair(number, true));
+      }
     }
   }
   if (!expected.empty()) {
@@ -520,8 +646,8 @@ Status DBImpl::Recover(VersionEdit* edit, bool *save_manifest) {
   // Recover in the order in which the logs were generated
   std::sort(logs.begin(), logs.end());
   for (size_t i = 0; i < logs.size(); i++) {
-    s = RecoverLogFile(logs[i], (i == logs.size() - 1), save_manifest, edit,
-                       &max_sequence);
+    s = RecoverLogFile(logs[i].first, logs[i].second, (i == logs.size() - 1),
+                       save_manifest, edit, &max_sequence);
     if (!s.ok()) {
       return s;
     }
@@ -529,7 +655,7 @@ Status DBImpl::Recover(VersionEdit* edit, bool *save_manifest) {
     // The previous incarnation may not have written any MANIFEST
     // records after allocating this log number.  So we manually
     // update the file number allocation counter in VersionSet.
-    versions_->MarkFileNumberUsed(logs[i]);
+    versions_->MarkFileNumberUsed(logs[i].first);
   }
 
   if (versions_->LastSequence() < max_sequence) {
@@ -539,8 +665,9 @@ Status DBImpl::Recover(VersionEdit* edit, bool *save_manifest) {
   return Status::OK();
 }
 
-Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
-                              bool* save_manifest, VersionEdit* edit,
+Status DBImpl::RecoverLogFile(uint64_t log_number, bool pmem_segment,
+                              bool last_log, bool* save_manifest,
+                              VersionEdit* edit,
                               SequenceNumber* max_sequence) {
   struct LogReporter : public log::Reader::Reporter {
     Env* env;
@@ -560,7 +687,13 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
   // Open the log file
   std::string fname = LogFileName(dbname_, log_number);
   SequentialFile* file;
-  Status status = env_->NewSequentialFile(fname, &file);
+  Status status;
+  if (pmem_segment) {
+    // Replayed straight from the mapped segment
+    status = options_.pmem_log->NewLogReader(log_number, &file);
+  } else {
+    status = env_->NewSequentialFile(fname, &file);
+  }
   if (!status.ok()) {
     MaybeIgnoreError(&status);
     return status;
@@ -597,7 +730,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
     WriteBatchInternal::SetContents(&batch, record);
 
     if (mem == nullptr) {
-      mem = new MemTable(internal_comparator_);
+      mem = NewMemTable();
       mem->Ref();
     }
     status = WriteBatchInternal::InsertInto(&batch, mem);
@@ -629,7 +762,8 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
   delete file;
 
   // See if we should keep reusing the last log file.
-  if (status.ok() && options_.reuse_logs && last_log && compactions == 0) {
+  if (status.ok() && options_.reuse_logs && !options_.use_pmem_log &&
+      !pmem_segment && last_log && compactions == 0) {
     assert(logfile_ == nullptr);
     assert(log_ == nullptr);
     assert(mem_ == nullptr);
@@ -644,7 +778,7 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
         mem = nullptr;
       } else {
         // mem can be nullptr if lognum exists but was empty.
-        mem_ = new MemTable(internal_comparator_);
+        mem_ = NewMemTable();
         mem_->Ref();
       }
     }
@@ -666,20 +800,34 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
                                 Version* base) {
   mutex_.AssertHeld();
   const uint64_t start_micros = env_->NowMicros();
+  const uint64_t start_cpu_micros = ThreadCpuMicros();
   FileMetaData meta;
   meta.number = versions_->NewFileNumber();
   pending_outputs_.insert(meta.number);
+  FlushJobInfo info;
+  info.job_id = next_job_id_++;
+  info.memtable_bytes = mem->ApproximateMemoryUsage();
+  NotifyFlush(info, false);
   Iterator* iter = mem->NewIterator();
   Log(options_.info_log, "Level-0 table #%llu: started",
       (unsigned long long) meta.number);
 
   Status s;
+  uint64_t pmem_bytes = 0;
   {
     mutex_.Unlock();
     /*
      * SOLVE: Write file based on pmem
      */
-    s = BuildTable(dbname_, env_, options_, table_cache_, iter, &meta, &tiering_stats_);
+    s = BuildTable(dbname_, env_, options_, table_cache_, iter, &meta,
+                   &tiering_stats_, &pmem_bytes);
+    // A PMEM table links the entries of the memtable's pmem extent in
+    // place; make them durable before the table goes into the manifest.
+    // SST outputs copied them, so there is nothing to persist.
+    if (s.ok() && meta.file_size > 0 &&
+        tiering_stats_.IsInSkiplistSet(meta.number)) {
+      mem->SealExtent();
+    }
     mutex_.Lock();
   }
 
@@ -705,13 +853,60 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
                   meta.smallest, meta.largest);
   }
 
+  const bool in_pmem = !tiering_stats_.IsInFileSet(meta.number);
   CompactionStats stats;
   stats.micros = env_->NowMicros() - start_micros;
-  stats.bytes_written = meta.file_size;
+  stats.AddWritten(in_pmem, in_pmem ? pmem_bytes : meta.file_size);
+  // Entries of a pmem memtable were written to PMEM as they were added;
+  // charge them to the flush, whichever tier its output went to.
+  const uint64_t extent_bytes = mem->ExtentUsage();
+  if (extent_bytes > 0) {
+    stats.AddWritten(true, extent_bytes);
+    statistics_->RecordTick(kPmemBytesWritten, extent_bytes);
+  }
   stats_[level].Add(stats);
+
+  info.output.number = meta.number;
+  info.output.level = level;
+  info.output.in_pmem = in_pmem;
+  info.output.size = meta.file_size;
+  info.micros = stats.micros;
+  info.cpu_micros = ThreadCpuMicros() - start_cpu_micros;
+  info.status = s;
+  NotifyFlush(info, true);
   return s;
 }
 
+void DBImpl::NotifyFlush(const FlushJobInfo& info, bool finished) {
+  mutex_.AssertHeld();
+  Log(options_.info_log, "EVENT %s",
+      FlushEventToJSON(info, finished).c_str());
+  if (options_.listener != nullptr) {
+    mutex_.Unlock();
+    if (finished) {
+      options_.listener->OnFlushCompleted(info);
+    } else {
+      options_.listener->OnFlushBegin(info);
+    }
+    mutex_.Lock();
+  }
+}
+
+void DBImpl::NotifyCompaction(const CompactionJobInfo& info, bool finished) {
+  mutex_.AssertHeld();
+  Log(options_.info_log, "EVENT %s",
+      CompactionEventToJSON(info, finished).c_str());
+  if (options_.listener != nullptr) {
+    mutex_.Unlock();
+    if (finished) {
+      options_.listener->OnCompactionCompleted(info);
+    } else {
+      options_.listener->OnCompactionBegin(info);
+    }
+    mutex_.Lock();
+  }
+}
+
 void DBImpl::CompactMemTable() {
   mutex_.AssertHeld();
   assert(imm_ != nullptr);
@@ -1022,6 +1217,7 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact,
     pending_outputs_.insert(file_number);
     CompactionState::Output out;
     out.number = file_number;
+    out.pmem_bytes = 0;
     out.smallest.Clear();
     out.largest.Clear();
     /*-----------------------------*/
@@ -1038,10 +1234,12 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact,
   Status s;
   if (options_.sst_type == kFileDescriptorSST || is_file_creation) {
     std::string fname = TableFileName(dbname_, file_number);
-    s = env_->NewWritableFile(fname, &compact->outfile);
+    s = NewTableFile(env_, options_, fname, &compact->outfile);
     if (s.ok()) {
       //std::cout << "[open] SST: " << file_number<< std::endl; // print hotcomp
-      compact->builder = new TableBuilder(options_, compact->outfile);
+      compact->builder = new TableBuilder(
+          TableOptionsForLevel(options_, compact->compaction->level() + 1),
+          compact->outfile);
     }
   } else if (options_.sst_type == kPmemSST) {
       /*--------------------------*/
@@ -1116,13 +1314,13 @@ Status DBImpl::FinishCompactionOutputFile(CompactionState* compact,
     // zewei_comp
     if (creat_option==kWarm){
          //std::cout << "insert into skiplist [warm]:" << output_number << ", entrries :" << compact->builder->NumEntries() << std::endl;
-	 s = compact->builder->FinishPmem();
-    	 tiering_stats_.InsertIntoSkiplistSet(output_number);
+	 if (s.ok()) s = compact->builder->FinishPmem();
+    	 if (s.ok()) tiering_stats_.InsertIntoSkiplistSet(output_number);
     }
     else if (creat_option==kHot && current_entries_hot>0){
          //std::cout << "insert into skiplist [hot]:" << output_number << ", entrries :" << compact->builder_hot->NumEntries() << std::endl;
-	 s = compact->builder_hot->FinishPmem();
-    	 tiering_stats_.InsertIntoSkiplistSet(output_number);
+	 if (s.ok()) s = compact->builder_hot->FinishPmem();
+    	 if (s.ok()) tiering_stats_.InsertIntoSkiplistSet(output_number);
     }
     /*---------------*/ 
     
@@ -1140,6 +1338,7 @@ Status DBImpl::FinishCompactionOutputFile(CompactionState* compact,
 
     current_bytes = compact->builder->FileSize();
     compact->current_output()->file_size = current_bytes;
+    compact->current_output()->pmem_bytes = compact->builder->PmemBytesWritten();
     // printf("[DEBUG][num_entries %d][filesize %d]\n", current_entries, current_bytes);
     compact->total_bytes += current_bytes;
     delete compact->builder;
@@ -1154,6 +1353,8 @@ Status DBImpl::FinishCompactionOutputFile(CompactionState* compact,
         //std::cout << "[finish-hot] reserve: " << output_number << std::endl;
         current_bytes = compact->builder_hot->FileSize();
       	compact->current_output_hot()->file_size = current_bytes;
+        compact->current_output_hot()->pmem_bytes =
+            compact->builder_hot->PmemBytesWritten();
       	compact->total_bytes += current_bytes;
       }
       else{
@@ -1293,6 +1494,24 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   assert(versions_->NumLevelFiles(compact->compaction->level()) > 0);
   assert(compact->builder == nullptr);
   assert(compact->outfile == nullptr);
+
+  const uint64_t start_cpu_micros = ThreadCpuMicros();
+  const uint64_t start_delayed_micros = total_delayed_micros;
+  CompactionJobInfo info;
+  info.job_id = next_job_id_++;
+  info.level = compact->compaction->level();
+  for (int which = 0; which < 2; which++) {
+    for (int i = 0; i < compact->compaction->num_input_files(which); i++) {
+      const FileMetaData* f = compact->compaction->input(which, i);
+      JobFileInfo file;
+      file.number = f->number;
+      file.level = info.level + which;
+      file.in_pmem = !tiering_stats_.IsInFileSet(f->number);
+      file.size = f->file_size;
+      info.inputs.push_back(file);
+    }
+  }
+  NotifyCompaction(info, false);
   
   //std::cout << "step1:" << std::endl; //print hotcomp
   //=================================================
@@ -1313,6 +1532,8 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
 
   //std::cout << "step3:" << std::endl; //print hotcomp
   //=================================================
+  // Covers the merge and the outputs it writes, up to the install
+  TRACE_SPAN("compaction.merge");
   input->SeekToFirst();
   // printf("SeekToFirst2\n");
   Status status;
@@ -1339,6 +1560,8 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   
   int comp_level = compact->compaction->level();
   bool hotcomp =  (comp_level==0 || comp_level == 1);
+  uint64_t warm_entries = 0;  // stats
+  uint64_t hot_entries = 0;
   /*--------------------------*/
 
   if (options_.ds_type == kSkiplist) {
@@ -1394,6 +1617,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
     //std::cout << "step3.2:" << std::endl; //print hotcomp
     //===================================
     Slice key = input->key();
+    info.input_entries++;
     /*-------------------------*/
     // zewei_hotcomp
     if (compact->compaction->ShouldStopBefore(key)) {
@@ -1498,6 +1722,9 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         compact->compaction->IsBaseLevelForKey(ikey.user_key),
         (int)last_sequence_for_key, (int)compact->smallest_snapshot);
 #endif
+    if (drop) {
+      info.dropped_entries++;
+    }
 
 
     //std::cout << "step3.4:" << std::endl; //print hotcomp
@@ -1565,11 +1792,17 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
                   meta.file_size = 0;
                   std::string fname = TableFileName(dbname_, meta.number);
                   WritableFile* file;
-                  Status s = env_->NewWritableFile(fname, &file);
+                  Status s = NewTableFile(env_, options_, fname, &file);
                   if (!s.ok()) {
-                    return s;
+                    // The table stays in PMEM; end the job with the error
+                    tiering_stats_.PushToNumberListInPmem(
+                        evicted_level_number.level, evicted_level_number.number);
+                    status = s;
+                    break;
                   }
-                  TableBuilder* builder = new TableBuilder(options_, file);
+                  TableBuilder* builder = new TableBuilder(
+                      TableOptionsForLevel(options_, evicted_level_number.level),
+                      file);
                   // printf("Compaction meta %d\n", meta.number);
                   PmemIterator* pmem_iterator = new PmemIterator(meta.number, 
                     options_.pmem_skiplist[meta.number % NUM_OF_SKIPLIST_MANAGER]);
@@ -1588,6 +1821,9 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
                     meta.file_size = builder->FileSize();
                     assert(meta.file_size > 0);
                     lru_flushed_bytes_written += meta.file_size; // stats
+                    statistics_->RecordTick(kTieringMigratedTables);
+                    statistics_->RecordTick(kTieringMigratedBytes,
+                                            meta.file_size);
                   }
                   delete builder;
 
@@ -1608,11 +1844,18 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
                     s = it->status();
                     delete it;
                   }
+                  if (!s.ok()) {
+                    tiering_stats_.PushToNumberListInPmem(
+                        evicted_level_number.level, evicted_level_number.number);
+                    status = s;
+                    break;
+                  }
                   /* 3) Stats */
                   // NOTE: pending delete file from pmem_skiplist and tiering_stats
                   // pending_deleted_number_in_pmem.push_back(evicted_level_number.number);
                   mutex_.Lock();
                   pmem_skiplist->DeleteFileWithCheckRef(evicted_level_number.number);
+                  pending_extent_unlinks_.push_back(evicted_level_number.number);
                   tiering_stats_.DeleteFromSkiplistSet(evicted_level_number.number);
                   tiering_stats_.InsertIntoFileSet(evicted_level_number.number);
                   mutex_.Unlock();
@@ -1638,6 +1881,9 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
             } 
           break;
         }
+        if (!status.ok()) {
+          break;
+        }
 	//std::cout << "debug 2" << std::endl; //print hotcomp
         maintain_flag = true;
         status = OpenCompactionOutputFile(compact, file_number, need_file_creation, kWarm /*zewei_comp*/);
@@ -1713,6 +1959,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
            	    compact->current_output()->largest.DecodeFrom(key);
            	    //-------
        
+		    warm_entries++;
 		    uint16_t file_number_warm = compact->current_output()->number;
                     PmemSkiplist* pmem_skiplist_warm;
                     pmem_skiplist_warm = options_.pmem_skiplist[file_number_warm % NUM_OF_SKIPLIST_MANAGER];
@@ -1758,6 +2005,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
                     }
                     compact->current_output_hot()->largest.DecodeFrom(key);
                     /*----------------------------------------------------------------------------*/
+      		    hot_entries++;
       		    uint16_t file_number_hot = compact->current_output_hot()->number;
                     PmemSkiplist* pmem_skiplist_hot;
                     pmem_skiplist_hot = options_.pmem_skiplist[file_number_hot % NUM_OF_SKIPLIST_MANAGER];
@@ -1942,6 +2190,11 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   // Make compaction-stats
   CompactionStats stats;
   stats.micros = env_->NowMicros() - start_micros - imm_micros;
+  statistics_->RecordTick(kCompactionWarmEntries, warm_entries);
+  statistics_->RecordTick(kCompactionHotEntries, hot_entries);
+  if (!owns_statistics_) {
+    statistics_->MeasureTime(kCompactionMicros, stats.micros);
+  }
   for (int which = 0; which < 2; which++) {
     for (int i = 0; i < compact->compaction->num_input_files(which); i++) {
       stats.bytes_read += compact->compaction->input(which, i)->file_size;
@@ -1951,13 +2204,12 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   for (size_t i = 0; i < compact->outputs.size(); i++) {
     uint64_t number = compact->outputs[i].number;
     if (tiering_stats_.IsInFileSet(number)) {
-      stats.bytes_written += compact->outputs[i].file_size;
+      stats.AddWritten(false, compact->outputs[i].file_size);
     } else if (tiering_stats_.IsInSkiplistSet(number)) {
-      uint64_t estimated_written = (compact->outputs[i].file_size / 120) * 8; // pointer = 8bytes
-      stats.bytes_written += estimated_written;
+      stats.AddWritten(true, compact->outputs[i].pmem_bytes);
     } else {
       printf("[WARN][BGCompaction][Stats] % is not in both fileset and skiplistset\n", number);
-      stats.bytes_written += compact->outputs[i].file_size;
+      stats.AddWritten(false, compact->outputs[i].file_size);
     }
   }
 
@@ -1970,17 +2222,16 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
           uint64_t number = compact->outputs_hot[i].number;
           // SST
           if (tiering_stats_.IsInFileSet(number)) {
-              stats_hot.bytes_written += compact->outputs_hot[i].file_size;
+              stats_hot.AddWritten(false, compact->outputs_hot[i].file_size);
           }
           // pmem skiplist
           else if (tiering_stats_.IsInSkiplistSet(number)) {
-              uint64_t estimated_written = (compact->outputs_hot[i].file_size / 120) * 8; // pointer = 8bytes
-              stats_hot.bytes_written += estimated_written;
+              stats_hot.AddWritten(true, compact->outputs_hot[i].pmem_bytes);
           }
           // wrong
           else {
               printf("hotcomp wrong estimation, um...maybe not wrong:D :\n", number);
-              stats.bytes_written += compact->outputs_hot[i].file_size;
+              stats.AddWritten(false, compact->outputs_hot[i].file_size);
           }
       }
   }
@@ -1989,7 +2240,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
 
 
   // LRU stats
-  stats.bytes_written += lru_flushed_bytes_written;
+  stats.AddWritten(false, lru_flushed_bytes_written);
 
   mutex_.Lock();
   stats_[compact->compaction->level() + 1].Add(stats);
@@ -2039,6 +2290,7 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         PmemSkiplist* pmem_skiplist = 
                 options_.pmem_skiplist[file_number % NUM_OF_SKIPLIST_MANAGER];
         pmem_skiplist->DeleteFile(file_number);
+        pending_extent_unlinks_.push_back(file_number);
 
         // PROGRESS: Cold_data, LRU => evict from tiering_stats
         if (options_.tiering_option == kColdDataTiering ||
@@ -2051,6 +2303,31 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
       }
     }
   }
+
+  // Outputs are still in the tiering sets; only the inputs left them
+  for (int hot = 0; hot < 2; hot++) {
+    const std::vector<CompactionState::Output>& outputs =
+        hot ? compact->outputs_hot : compact->outputs;
+    for (size_t i = 0; i < outputs.size(); i++) {
+      JobFileInfo file;
+      file.number = outputs[i].number;
+      file.level = hot ? 0 : info.level + 1;
+      file.in_pmem = !tiering_stats_.IsInFileSet(file.number);
+      file.hot = hot;
+      file.size = outputs[i].file_size;
+      info.outputs.push_back(file);
+    }
+  }
+  info.bytes_read = stats.bytes_read;
+  info.bytes_written = stats.bytes_written + stats_hot.bytes_written;
+  info.lru_flushed_bytes = lru_flushed_bytes_written;
+  info.hot_entries = hot_entries;
+  info.warm_entries = warm_entries;
+  info.micros = stats.micros;
+  info.cpu_micros = ThreadCpuMicros() - start_cpu_micros;
+  info.stall_micros = total_delayed_micros - start_delayed_micros;
+  info.status = status;
+  NotifyCompaction(info, true);
   //std::cout << "---end compaction---" << std::endl;// print hotcomp
   // printf("End background compaction\n");
   return status;
@@ -2065,6 +2342,13 @@ struct IterState {
   MemTable* const mem GUARDED_BY(mu);
   MemTable* const imm GUARDED_BY(mu);
 
+  // Internal-key forms of ReadOptions::iterate_lower_bound/upper_bound.
+  // The child iterators point into these for the iterator's lifetime.
+  std::string lower_bound;
+  std::string upper_bound;
+  Slice lower_bound_slice;
+  Slice upper_bound_slice;
+
   IterState(port::Mutex* mutex, MemTable* mem, MemTable* imm, Version* version)
       : mu(mutex), version(version), mem(mem), imm(imm) { }
 };
@@ -2095,11 +2379,31 @@ Iterator* DBImpl::NewInternalIterator(const ReadOptions& options,
     list.push_back(imm_->NewIterator());
     imm_->Ref();
   }
-  versions_->current()->AddIterators(options, &list, &tiering_stats_, fileSet, skiplistSet,preserve_flag);
-  Iterator* internal_iter =
-      NewMergingIterator(&internal_comparator_, &list[0], list.size());
   versions_->current()->Ref();
   IterState* cleanup = new IterState(&mutex_, mem_, imm_, versions_->current());
+
+  // Table and pmem iterators compare internal keys, so hand them the
+  // smallest internal key of each user-key bound.
+  ReadOptions internal_options = options;
+  if (options.iterate_lower_bound != nullptr) {
+    AppendInternalKey(&cleanup->lower_bound,
+                      ParsedInternalKey(*options.iterate_lower_bound,
+                                        kMaxSequenceNumber,
+                                        kValueTypeForSeek));
+    cleanup->lower_bound_slice = cleanup->lower_bound;
+    internal_options.iterate_lower_bound = &cleanup->lower_bound_slice;
+  }
+  if (options.iterate_upper_bound != nullptr) {
+    AppendInternalKey(&cleanup->upper_bound,
+                      ParsedInternalKey(*options.iterate_upper_bound,
+                                        kMaxSequenceNumber,
+                                        kValueTypeForSeek));
+    cleanup->upper_bound_slice = cleanup->upper_bound;
+    internal_options.iterate_upper_bound = &cleanup->upper_bound_slice;
+  }
+  versions_->current()->AddIterators(internal_options, &list, &tiering_stats_);
+  Iterator* internal_iter =
+      NewMergingIterator(&internal_comparator_, &list[0], list.size());
   internal_iter->RegisterCleanup(CleanupIteratorState, cleanup, nullptr);
 
   *seed = ++seed_;
@@ -2122,6 +2426,8 @@ Status DBImpl::Get(const ReadOptions& options,
                    const Slice& key,
                    std::string* value) {
   Status s;
+  // Latency histograms are only kept for user-supplied statistics
+  const uint64_t start_micros = owns_statistics_ ? 0 : env_->NowMicros();
   MutexLock l(&mutex_);
   SequenceNumber snapshot;
   if (options.snapshot != nullptr) {
@@ -2146,15 +2452,35 @@ Status DBImpl::Get(const ReadOptions& options,
     mutex_.Unlock();
     // First look in the memtable, then in the immutable memtable (if any).
     LookupKey lkey(key, snapshot);
-    if (mem->Get(lkey, value, &s)) {
-      // Done
-    } else if (imm != nullptr && imm->Get(lkey, value, &s)) {
+    bool in_memtable;
+    {
+      PERF_TIMER_GUARD(get_memtable_nanos);
+      in_memtable = mem->Get(lkey, value, &s) ||
+                    (imm != nullptr && imm->Get(lkey, value, &s));
+    }
+    if (in_memtable) {
       // Done
+      statistics_->RecordTick(kMemtableHits);
     } else {
+      PERF_TIMER_GUARD(get_from_files_nanos);
       /* SOLVE: Get based on pmem */
       // s = current->Get(options, lkey, value, &stats);
       s = current->Get(options_, options, lkey, value, &stats, &tiering_stats_);
       have_stat_update = true;
+      if (stats.hit_level < 0) {
+        statistics_->RecordTick(kGetMisses);
+      } else if (stats.hit_in_pmem) {
+        statistics_->RecordLevelTick(kPmemHits, stats.hit_level);
+        if (s.ok()) {
+          statistics_->RecordTick(kPmemBytesRead, value->size());
+        }
+      } else {
+        statistics_->RecordLevelTick(kSstHits, stats.hit_level);
+      }
+    }
+    if (!owns_statistics_) {
+      statistics_->MeasureTime(kGetMicros,
+                               env_->NowMicros() - start_micros);
     }
     mutex_.Lock();
   }
@@ -2178,7 +2504,9 @@ Iterator* DBImpl::NewIterator(const ReadOptions& options) {
       (options.snapshot != nullptr
        ? static_cast<const SnapshotImpl*>(options.snapshot)->sequence_number()
        : latest_snapshot),
-      seed);
+      seed,
+      options.iterate_lower_bound,
+      options.iterate_upper_bound);
 }
 
 void DBImpl::RecordReadSample(Slice key) {
@@ -2213,6 +2541,8 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
   w.batch = my_batch;
   w.sync = options.sync;
   w.done = false;
+  const bool measure = !owns_statistics_ && my_batch != nullptr;
+  const uint64_t start_micros = measure ? env_->NowMicros() : 0;
 
   MutexLock l(&mutex_);
   writers_.push_back(&w);
@@ -2220,14 +2550,29 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
     w.cv.Wait();
   }
   if (w.done) {
+    if (measure) {
+      statistics_->MeasureTime(kWriteMicros,
+                               env_->NowMicros() - start_micros);
+    }
     return w.status;
   }
   // May temporarily unlock and wait.
   Status status = MakeRoomForWrite(my_batch == nullptr);
   uint64_t last_sequence = versions_->LastSequence();
   Writer* last_writer = &w;
+  WriteBatch* updates = nullptr;
   if (status.ok() && my_batch != nullptr) {  // nullptr batch is for compactions
-    WriteBatch* updates = BuildBatchGroup(&last_writer);
+    updates = BuildBatchGroup(&last_writer);
+    if (options_.use_pmem_log && log_->BytesWritten() > 0 &&
+        log_->BytesWritten() +
+                MaxLogRecordBytes(WriteBatchInternal::ByteSize(updates)) >
+            LOG_SEGMENT_SIZE) {
+      // The group does not fit in the rest of this log's segment: switch
+      // to a new log (and memtable) before appending it.
+      status = MakeRoomForWrite(true);
+    }
+  }
+  if (status.ok() && updates != nullptr) {
     WriteBatchInternal::SetSequence(updates, last_sequence + 1);
     last_sequence += WriteBatchInternal::Count(updates);
 
@@ -2237,7 +2582,15 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
     // into mem_.
     {
       mutex_.Unlock();
-      status = log_->AddRecord(WriteBatchInternal::Contents(updates));
+      const uint64_t log_bytes = log_->BytesWritten();
+      {
+        TRACE_SPAN("wal.append");
+        status = log_->AddRecord(WriteBatchInternal::Contents(updates));
+      }
+      statistics_->RecordTick(kUserBytesWritten,
+                              WriteBatchInternal::ByteSize(updates));
+      statistics_->RecordTick(kWalBytesWritten,
+                              log_->BytesWritten() - log_bytes);
       bool sync_error = false;
       if (status.ok() && options.sync) {
         status = logfile_->Sync();
@@ -2246,6 +2599,7 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
         }
       }
       if (status.ok()) {
+        TRACE_SPAN("memtable.insert");
         status = WriteBatchInternal::InsertInto(updates, mem_);
       }
       mutex_.Lock();
@@ -2256,10 +2610,9 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
         RecordBackgroundError(status);
       }
     }
-    if (updates == tmp_batch_) tmp_batch_->Clear();
-
     versions_->SetLastSequence(last_sequence);
   }
+  if (updates == tmp_batch_) tmp_batch_->Clear();
 
   while (true) {
     Writer* ready = writers_.front();
@@ -2277,6 +2630,10 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* my_batch) {
     writers_.front()->cv.Signal();
   }
 
+  if (measure) {
+    statistics_->MeasureTime(kWriteMicros,
+                             env_->NowMicros() - start_micros);
+  }
   return status;
 }
 
@@ -2294,7 +2651,7 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
   // Allow the group to grow up to a maximum size, but if the
   // original write is small, limit the growth so we do not slow
   // down the small write too much.
-  size_t max_size = 1 << 20;
+  size_t max_size = kMaxBatchGroupBytes;
   if (size <= (128<<10)) {
     max_size = size + (128<<10);
   }
@@ -2382,7 +2739,7 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       uint64_t new_log_number = versions_->NewFileNumber();
       WritableFile* lfile = nullptr;
       // printf("[DEBUG %d] log_num\n", new_log_number);
-      s = env_->NewWritableFile(LogFileName(dbname_, new_log_number), &lfile);
+      s = NewLogFile(new_log_number, &lfile);
       if (!s.ok()) {
         // Avoid chewing through file number space in a tight loop.
         versions_->ReuseFileNumber(new_log_number);
@@ -2395,7 +2752,7 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       log_ = new log::Writer(lfile);
       imm_ = mem_;
       has_imm_.Release_Store(imm_);
-      mem_ = new MemTable(internal_comparator_);
+      mem_ = NewMemTable();
       mem_->Ref();
       force = false;   // Do not force another compaction if have room
       // printf("33]\n");
@@ -2404,6 +2761,10 @@ Status DBImpl::MakeRoomForWrite(bool force) {
   }
   if (delayed_micros != 0) {
     total_delayed_micros += delayed_micros;
+    statistics_->RecordTick(kWriteStallMicros, delayed_micros);
+    if (!owns_statistics_) {
+      statistics_->MeasureTime(kWriteStallHistogram, delayed_micros);
+    }
     // Log(options_.info_log, "[MakeRoomForWrite] delayed_micros: %lld\n", delayed_micros);
     // Log(options_.info_log, "[MakeRoomForWrite] total_delayed_micros: %lld\n", total_delayed_micros);
   }
@@ -2456,6 +2817,109 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value) {
       }
     }
     return true;
+  } else if (in == "tier-stats") {
+    char buf[200];
+    snprintf(buf, sizeof(buf),
+             "                Tier hits\n"
+             "Level  PMEM-hits   SST-hits\n"
+             "---------------------------\n");
+    value->append(buf);
+    for (int level = 0; level < config::kNumLevels; level++) {
+      uint64_t pmem_hits = statistics_->GetLevelTickerCount(kPmemHits,
+                                                             level);
+      uint64_t sst_hits = statistics_->GetLevelTickerCount(kSstHits, level);
+      if (pmem_hits > 0 || sst_hits > 0) {
+        snprintf(buf, sizeof(buf), "%3d %12llu %10llu\n", level,
+                 static_cast<unsigned long long>(pmem_hits),
+                 static_cast<unsigned long long>(sst_hits));
+        value->append(buf);
+      }
+    }
+    uint64_t pmem_bytes_written = 0;
+    if (options_.use_pmem_buffer) {
+      for (int i = 0; i < NUM_OF_BUFFER; i++) {
+        pmem_bytes_written += options_.pmem_buffer[i]->BytesWritten();
+      }
+    }
+    if (options_.use_pmem_memtable) {
+      pmem_bytes_written += options_.pmem_memtable_buffer->BytesWritten();
+    }
+    snprintf(buf, sizeof(buf),
+             "Memtable hits: %llu\n"
+             "Misses: %llu\n"
+             "PMEM buffer written(MB): %.1f\n"
+             "Tiering migrations: %llu tables, %.1f MB\n",
+             static_cast<unsigned long long>(
+                 statistics_->GetTickerCount(kMemtableHits)),
+             static_cast<unsigned long long>(
+                 statistics_->GetTickerCount(kGetMisses)),
+             pmem_bytes_written / 1048576.0,
+             static_cast<unsigned long long>(
+                 statistics_->GetTickerCount(kTieringMigratedTables)),
+             statistics_->GetTickerCount(kTieringMigratedBytes) /
+                 1048576.0);
+    value->append(buf);
+    return true;
+  } else if (in == "pmem-stats") {
+    *value = statistics_->ToString();
+    return true;
+  } else if (in == "pmem-stats-json") {
+    *value = statistics_->ToJSON();
+    return true;
+  } else if (in == "amplification") {
+    // Write amplification counts every byte put on the device (WAL,
+    // flushes, compaction outputs and LRU migrations) per user byte.
+    // Space amplification compares the live bytes of the whole tree to
+    // those of its last non-empty level, which approximates the size of
+    // the unique data when that level holds most of the keys.
+    char buf[300];
+    snprintf(buf, sizeof(buf),
+             "                      Amplification\n"
+             "Level  Live-PMEM(MB)  Live-SST(MB)  Write-PMEM(MB)  "
+             "Write-SST(MB)\n"
+             "------------------------------------------------------"
+             "-------------\n");
+    value->append(buf);
+    int64_t live_total = 0;
+    int64_t live_last_level = 0;
+    int64_t pmem_written = 0;
+    int64_t sst_written = 0;
+    for (int level = 0; level < config::kNumLevels; level++) {
+      int64_t live_pmem, live_sst;
+      versions_->NumLevelBytesByTier(level, &tiering_stats_, &live_pmem,
+                                     &live_sst);
+      live_total += live_pmem + live_sst;
+      if (live_pmem + live_sst > 0) {
+        live_last_level = live_pmem + live_sst;
+      }
+      pmem_written += stats_[level].pmem_bytes_written;
+      sst_written += stats_[level].sst_bytes_written;
+      if (live_pmem + live_sst > 0 || stats_[level].bytes_written > 0) {
+        snprintf(buf, sizeof(buf), "%3d %14.1f %13.1f %15.1f %14.1f\n",
+                 level, live_pmem / 1048576.0, live_sst / 1048576.0,
+                 stats_[level].pmem_bytes_written / 1048576.0,
+                 stats_[level].sst_bytes_written / 1048576.0);
+        value->append(buf);
+      }
+    }
+    const uint64_t user_bytes = statistics_->GetTickerCount(
+        kUserBytesWritten);
+    const uint64_t wal_bytes = statistics_->GetTickerCount(
+        kWalBytesWritten);
+    const double user = user_bytes > 0 ? user_bytes : 1;
+    snprintf(buf, sizeof(buf),
+             "User written(MB): %.1f\n"
+             "WAL written(MB): %.1f\n"
+             "Write amplification: %.2f (PMEM %.2f, SST %.2f, WAL %.2f)\n"
+             "Space amplification: %.2f\n",
+             user_bytes / 1048576.0, wal_bytes / 1048576.0,
+             (wal_bytes + pmem_written + sst_written) / user,
+             pmem_written / user, sst_written / user, wal_bytes / user,
+             live_last_level > 0
+                 ? static_cast<double>(live_total) / live_last_level
+                 : 0.0);
+    value->append(buf);
+    return true;
   } else if (in == "sstables") {
     *value = versions_->current()->DebugString();
     return true;
@@ -2532,15 +2996,19 @@ Status DB::Open(const Options& options, const std::string& dbname,
     // Create new log and a corresponding memtable.
     uint64_t new_log_number = impl->versions_->NewFileNumber();
     WritableFile* lfile;
-    s = options.env->NewWritableFile(LogFileName(dbname, new_log_number),
-                                     &lfile);
+    s = impl->NewLogFile(new_log_number, &lfile);
     if (s.ok()) {
       edit.SetLogNumber(new_log_number);
       impl->logfile_ = lfile;
       impl->logfile_number_ = new_log_number;
       impl->log_ = new log::Writer(lfile);
-      impl->mem_ = new MemTable(impl->internal_comparator_);
+      impl->mem_ = impl->NewMemTable();
       impl->mem_->Ref();
+      if (impl->options_.pmem_log != nullptr) {
+        // Record the new log number so DeleteObsoleteFiles() can return
+        // the replayed segments to the ring.
+        save_manifest = true;
+      }
     }
   }
   if (s.ok() && save_manifest) {
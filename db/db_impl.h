@@ -21,6 +21,9 @@
 namespace leveldb {
 
 class MemTable;
+struct CompactionJobInfo;
+struct FlushJobInfo;
+class Statistics;
 class TableCache;
 class Version;
 class VersionEdit;
@@ -67,11 +70,6 @@ class DBImpl : public DB {
   // bytes.
   void RecordReadSample(Slice key);
 
-  // Customized by JH for DBIter
-  std::vector<FileMetaData *> fileSet[config::kNumLevels];
-  std::vector<FileMetaData *> skiplistSet[config::kNumLevels];
-  bool preserve_flag;
-
  private:
   friend class DB;
   struct CompactionState;
@@ -91,6 +89,13 @@ class DBImpl : public DB {
 
   void MaybeIgnoreError(Status* s) const;
 
+  // Create a memtable, pmem-resident if options_.use_pmem_memtable.
+  MemTable* NewMemTable();
+
+  // Create the writable file backing log "number", either a *.log file
+  // or a segment of options_.pmem_log.
+  Status NewLogFile(uint64_t number, WritableFile** result);
+
   // Delete any unneeded files and stale in-memory entries.
   void DeleteObsoleteFiles() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
@@ -99,8 +104,11 @@ class DBImpl : public DB {
   // Errors are recorded in bg_error_.
   void CompactMemTable() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  Status RecoverLogFile(uint64_t log_number, bool last_log, bool* save_manifest,
-                        VersionEdit* edit, SequenceNumber* max_sequence)
+  // Replay log "log_number", a pmem_log segment if "pmem_segment" and a
+  // *.log file otherwise.
+  Status RecoverLogFile(uint64_t log_number, bool pmem_segment, bool last_log,
+                        bool* save_manifest, VersionEdit* edit,
+                        SequenceNumber* max_sequence)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   Status WriteLevel0Table(MemTable* mem, VersionEdit* edit, Version* base)
@@ -131,6 +139,12 @@ class DBImpl : public DB {
                                     bool is_file_creation, CreatOption creat_option /*zewei_comp*/);
   Status InstallCompactionResults(CompactionState* compact)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Log a flush/compaction event to the info log and pass it to
+  // options_.listener, with mutex_ released.
+  void NotifyFlush(const FlushJobInfo& info, bool finished)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void NotifyCompaction(const CompactionJobInfo& info, bool finished)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 /*------------------------------------------------------------------------------------*/
   // Constant after construction
   Env* const env_;
@@ -139,6 +153,8 @@ class DBImpl : public DB {
   const Options options_;  // options_.comparator == &internal_comparator_
   const bool owns_info_log_;
   const bool owns_cache_;
+  const bool owns_statistics_;
+  Statistics* const statistics_;  // == options_.statistics, never null
   const std::string dbname_;
 
   // table_cache_ provides its own synchronization
@@ -169,6 +185,12 @@ class DBImpl : public DB {
   // part of ongoing compactions.
   std::set<uint64_t> pending_outputs_ GUARDED_BY(mutex_);
 
+  // JH
+  // PMEM tables dropped by compaction or moved to SST by tiering whose
+  // references on memtable extents (PmemBuffer::LinkExtent) are released
+  // by DeleteObsoleteFiles() once no live version holds them in PMEM.
+  std::vector<uint64_t> pending_extent_unlinks_ GUARDED_BY(mutex_);
+
   // Has a background compaction been scheduled or is running?
   bool background_compaction_scheduled_ GUARDED_BY(mutex_);
 
@@ -193,13 +215,29 @@ class DBImpl : public DB {
     int64_t micros;
     int64_t bytes_read;
     int64_t bytes_written;
+    // bytes_written split by the tier of the output
+    int64_t pmem_bytes_written;
+    int64_t sst_bytes_written;
 
-    CompactionStats() : micros(0), bytes_read(0), bytes_written(0) { }
+    CompactionStats() : micros(0), bytes_read(0), bytes_written(0),
+                        pmem_bytes_written(0), sst_bytes_written(0) { }
 
     void Add(const CompactionStats& c) {
       this->micros += c.micros;
       this->bytes_read += c.bytes_read;
       this->bytes_written += c.bytes_written;
+      this->pmem_bytes_written += c.pmem_bytes_written;
+      this->sst_bytes_written += c.sst_bytes_written;
+    }
+
+    // Count "n" bytes written to "pmem" or SST outputs
+    void AddWritten(bool pmem, int64_t n) {
+      this->bytes_written += n;
+      if (pmem) {
+        this->pmem_bytes_written += n;
+      } else {
+        this->sst_bytes_written += n;
+      }
     }
   };
   CompactionStats stats_[config::kNumLevels] GUARDED_BY(mutex_);
@@ -215,6 +253,7 @@ class DBImpl : public DB {
   /* stat */
   uint64_t total_delayed_micros;
   Tiering_stats tiering_stats_;
+  int next_job_id_ GUARDED_BY(mutex_);  // of flushes and compactions
 };
 
 // Sanitize db options.  The caller should delete result.info_log if
@@ -12,6 +12,7 @@
 #include "port/port.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
+#include "util/perf_context_imp.h"
 #include "util/random.h"
 
 namespace leveldb {
@@ -49,11 +50,13 @@ class DBIter: public Iterator {
   };
 
   DBIter(DBImpl* db, const Comparator* cmp, Iterator* iter, SequenceNumber s,
-         uint32_t seed)
+         uint32_t seed, const Slice* lower_bound, const Slice* upper_bound)
       : db_(db),
         user_comparator_(cmp),
         iter_(iter),
         sequence_(s),
+        lower_bound_(lower_bound),
+        upper_bound_(upper_bound),
         direction_(kForward),
         valid_(false),
         rnd_(seed),
@@ -103,6 +106,16 @@ class DBIter: public Iterator {
   void FindPrevUserEntry();
   bool ParseKey(ParsedInternalKey* key);
 
+  inline bool PastUpperBound(const Slice& user_key) const {
+    return (upper_bound_ != nullptr &&
+            user_comparator_->Compare(user_key, *upper_bound_) >= 0);
+  }
+
+  inline bool BeforeLowerBound(const Slice& user_key) const {
+    return (lower_bound_ != nullptr &&
+            user_comparator_->Compare(user_key, *lower_bound_) < 0);
+  }
+
   inline void SaveKey(const Slice& k, std::string* dst) {
     dst->assign(k.data(), k.size());
   }
@@ -125,6 +138,8 @@ class DBIter: public Iterator {
   const Comparator* const user_comparator_;
   Iterator* const iter_;
   SequenceNumber const sequence_;
+  const Slice* const lower_bound_;  // May be nullptr
+  const Slice* const upper_bound_;  // May be nullptr
 
   Status status_;
   std::string saved_key_;     // == current key when direction_==kReverse
@@ -189,18 +204,25 @@ void DBIter::FindNextUserEntry(bool skipping, std::string* skip) {
   assert(direction_ == kForward);
   do {
     ParsedInternalKey ikey;
-    if (ParseKey(&ikey) && ikey.sequence <= sequence_) {
+    const bool parsed = ParseKey(&ikey);
+    if (parsed && PastUpperBound(ikey.user_key)) {
+      // Everything from here on is outside the iteration range
+      break;
+    }
+    if (parsed && ikey.sequence <= sequence_) {
       switch (ikey.type) {
         case kTypeDeletion:
           // Arrange to skip all upcoming entries for this key since
           // they are hidden by this deletion.
           SaveKey(ikey.user_key, skip);
           skipping = true;
+          PERF_COUNTER_ADD(internal_delete_skipped_count, 1);
           break;
         case kTypeValue:
           if (skipping &&
               user_comparator_->Compare(ikey.user_key, *skip) <= 0) {
             // Entry hidden
+            PERF_COUNTER_ADD(internal_key_skipped_count, 1);
           } else {
             valid_ = true;
             saved_key_.clear();
@@ -251,7 +273,12 @@ void DBIter::FindPrevUserEntry() {
     do {
       //printf("F1\n");
       ParsedInternalKey ikey;
-      if (ParseKey(&ikey) && ikey.sequence <= sequence_) {
+      const bool parsed = ParseKey(&ikey);
+      if (parsed && BeforeLowerBound(ikey.user_key)) {
+        // Everything from here on is outside the iteration range
+        break;
+      }
+      if (parsed && ikey.sequence <= sequence_) {
         if ((value_type != kTypeDeletion) &&
             user_comparator_->Compare(ikey.user_key, saved_key_) < 0) {
           // We encountered a non-deleted value in entries for previous keys,
@@ -295,9 +322,13 @@ void DBIter::Seek(const Slice& target) {
   direction_ = kForward;
   ClearSavedValue();
   saved_key_.clear();
+  const Slice& start = BeforeLowerBound(target) ? *lower_bound_ : target;
   AppendInternalKey(
-      &saved_key_, ParsedInternalKey(target, sequence_, kValueTypeForSeek));
-  iter_->Seek(saved_key_);
+      &saved_key_, ParsedInternalKey(start, sequence_, kValueTypeForSeek));
+  {
+    PERF_TIMER_GUARD(iter_seek_nanos);
+    iter_->Seek(saved_key_);
+  }
   if (iter_->Valid()) {
     FindNextUserEntry(false, &saved_key_ /* temporary storage */);
   } else {
@@ -306,9 +337,16 @@ void DBIter::Seek(const Slice& target) {
 }
 
 void DBIter::SeekToFirst() {
+  if (lower_bound_ != nullptr) {
+    Seek(*lower_bound_);
+    return;
+  }
   direction_ = kForward;
   ClearSavedValue();
-  iter_->SeekToFirst();
+  {
+    PERF_TIMER_GUARD(iter_seek_nanos);
+    iter_->SeekToFirst();
+  }
   if (iter_->Valid()) {
     FindNextUserEntry(false, &saved_key_ /* temporary storage */);
   } else {
@@ -328,7 +366,22 @@ void DBIter::SeekToLast() {
   //std::cout << "-2" << saved_key_ <<", "<< saved_value_ << std::endl;
   ClearSavedValue();
   //std::cout << "-3" << saved_key_ << ", " << saved_value_ << std::endl;
-  iter_->SeekToLast();
+  if (upper_bound_ != nullptr) {
+    // Position just before the first entry at or past the upper bound
+    saved_key_.clear();
+    AppendInternalKey(&saved_key_,
+                      ParsedInternalKey(*upper_bound_, kMaxSequenceNumber,
+                                        kValueTypeForSeek));
+    iter_->Seek(saved_key_);
+    saved_key_.clear();
+    if (iter_->Valid()) {
+      iter_->Prev();
+    } else {
+      iter_->SeekToLast();
+    }
+  } else {
+    iter_->SeekToLast();
+  }
   //std::cout << "-4" << std::endl;
   FindPrevUserEntry();
   //std::cout << "-5" << std::endl;
@@ -367,8 +420,11 @@ Iterator* NewDBIterator(
     const Comparator* user_key_comparator,
     Iterator* internal_iter,
     SequenceNumber sequence,
-    uint32_t seed) {
-  return new DBIter(db, user_key_comparator, internal_iter, sequence, seed);
+    uint32_t seed,
+    const Slice* lower_bound,
+    const Slice* upper_bound) {
+  return new DBIter(db, user_key_comparator, internal_iter, sequence, seed,
+                    lower_bound, upper_bound);
 }
 
 }  // namespace leveldb
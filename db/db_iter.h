@@ -15,12 +15,15 @@ class DBImpl;
 
 // Return a new iterator that converts internal keys (yielded by
 // "*internal_iter") that were live at the specified "sequence" number
-// into appropriate user keys.
+// into appropriate user keys.  Only user keys in
+// [*lower_bound, *upper_bound) are yielded; either bound may be nullptr.
 Iterator* NewDBIterator(DBImpl* db,
                         const Comparator* user_key_comparator,
                         Iterator* internal_iter,
                         SequenceNumber sequence,
-                        uint32_t seed);
+                        uint32_t seed,
+                        const Slice* lower_bound,
+                        const Slice* upper_bound);
 
 }  // namespace leveldb
 
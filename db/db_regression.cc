@@ -0,0 +1,510 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Regression driver for db_bench.  Runs a fixed matrix of workloads
+// against each storage mode, --repeats times, and writes the mean and
+// standard deviation of throughput and p99 latency of every cell to
+// --output as JSON.  With --baseline (a file written by an earlier run) it
+// also compares every cell against the baseline and exits with status 1 if
+// any of them regressed:
+//
+//   ./db_regression --output=base.json                 # on the old tree
+//   ./db_regression --baseline=base.json --output=new.json
+//
+// A cell regressed if its throughput fell, or its p99 latency rose, by
+// more than the threshold and by more than --noise_sigmas standard
+// deviations of the difference, so noisy cells need a larger change.
+//
+// Everything (DBs and PMEM pools) lives under --dir, by default on tmpfs,
+// so that any Linux box can run it without a PMEM device; PMDK is told to
+// treat the pools as persistent memory (PMEM_IS_PMEM_FORCE) unless the
+// environment already says otherwise.  PMDK allocates a pool's full size
+// when it creates it, so the stock pmem/layout.h sizes need ~40GB free
+// under --dir; build with -DLEVELDB_SMALL_PMEM_POOLS=ON to run on an
+// ordinary box.  The pools of a mode are removed after each run, and the
+// driver refuses to start if --dir cannot hold the largest mode.
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/statvfs.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+#include "leveldb/status.h"
+#include "pmem/layout.h"
+
+// db_bench binary to run (default: next to this binary)
+static const char* FLAGS_db_bench = nullptr;
+
+// Directory for the DBs, PMEM pools, db_bench logs and stats files
+static const char* FLAGS_dir = "/dev/shm/leveldb_regression";
+
+// Comma-separated storage modes to run: "sst", "pmem" and/or "tiering"
+static const char* FLAGS_modes = "sst,pmem,tiering";
+
+// Workloads run against every mode, in this order in one db_bench process.
+// The fill* benchmarks start from a fresh DB; the others read the DB the
+// last fill loaded (ycsb* expect one loaded with fillseq).
+static const char* FLAGS_benchmarks =
+    "fillrandom,fillseq,readrandom,readseq,seekrandom,ycsba,ycsbc,ycsbe";
+
+// Number of key/values per DB, and reads/operations per read benchmark
+static int FLAGS_num = 200000;
+static int FLAGS_reads = 100000;
+
+// Size of each value
+static int FLAGS_value_size = 100;
+
+// Runs of every mode; the spread of the runs is the noise estimate
+static int FLAGS_repeats = 3;
+
+// Write the results to this file (default: --dir/results.json)
+static const char* FLAGS_output = nullptr;
+
+// Compare against the results in this file
+static const char* FLAGS_baseline = nullptr;
+
+// Smallest relative change (percent) of throughput and of p99 latency
+// reported as a regression
+static double FLAGS_threshold = 5;
+static double FLAGS_latency_threshold = 20;
+
+// ... which must also exceed this many standard deviations of the change
+static double FLAGS_noise_sigmas = 2;
+
+namespace leveldb {
+
+namespace {
+
+struct Mode {
+  const char* name;
+  const char* flags;  // db_bench flags selecting the mode
+  bool skiplist_pools;  // Whether the flags create the skiplist pools
+  bool buffer_pools;    // ... and the pmem buffer pools
+};
+
+static const Mode kModes[] = {
+  { "sst", "--sst_type=sst --use_pmem_buffer=0 --tiering=none",
+    false, false },
+  { "pmem", "--sst_type=pmem --ds_type=skiplist --use_pmem_buffer=1 "
+            "--tiering=none", true, true },
+  { "tiering", "--sst_type=pmem --ds_type=skiplist --use_pmem_buffer=1 "
+               "--tiering=lru", true, true },
+};
+
+// Bytes a run of "mode" needs under --dir: its PMEM pools plus a
+// generous allowance for the DB, which the fill* benchmarks rewrite.
+static uint64_t SpaceNeeded(const Mode& mode) {
+  uint64_t bytes = 4ull * FLAGS_num * (FLAGS_value_size + 32);
+  if (mode.skiplist_pools) {
+    bytes += uint64_t(NUM_OF_SKIPLIST_MANAGER) * SKIPLIST_MANAGER_POOL_SIZE;
+  }
+  if (mode.buffer_pools) {
+    bytes += uint64_t(NUM_OF_BUFFER) * BUFFER_POOL_SIZE;
+  }
+  return bytes;
+}
+
+// Remove the files directly under "dir" (the pools of an earlier run)
+static void ClearDir(Env* env, const std::string& dir) {
+  std::vector<std::string> children;
+  if (env->GetChildren(dir, &children).ok()) {
+    for (size_t i = 0; i < children.size(); i++) {
+      if (children[i] != "." && children[i] != "..") {
+        env->DeleteFile(dir + "/" + children[i]);
+      }
+    }
+  }
+}
+
+// Mean and standard deviation of the runs of a cell
+struct Summary {
+  double mean;
+  double stddev;
+
+  Summary() : mean(0), stddev(0) { }
+};
+
+static Summary Summarize(const std::vector<double>& samples) {
+  Summary s;
+  if (samples.empty()) return s;
+  for (size_t i = 0; i < samples.size(); i++) {
+    s.mean += samples[i];
+  }
+  s.mean /= samples.size();
+  if (samples.size() > 1) {
+    double sq = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+      sq += (samples[i] - s.mean) * (samples[i] - s.mean);
+    }
+    s.stddev = sqrt(sq / (samples.size() - 1));
+  }
+  return s;
+}
+
+struct Cell {
+  std::vector<double> ops_per_sec;
+  std::vector<double> p99_us;
+  Summary throughput;
+  Summary p99;
+};
+
+// "mode/benchmark" -> cell, ordered for stable output
+typedef std::map<std::string, Cell> Results;
+
+static std::vector<std::string> Split(const char* list) {
+  std::vector<std::string> result;
+  std::string s = list;
+  size_t start = 0;
+  while (start <= s.size()) {
+    size_t comma = s.find(',', start);
+    if (comma == std::string::npos) comma = s.size();
+    if (comma > start) {
+      result.push_back(s.substr(start, comma - start));
+    }
+    start = comma + 1;
+  }
+  return result;
+}
+
+// Parse the value following "key" in "line" as a double
+static bool FindNumber(const char* line, const char* key, double* value) {
+  const char* p = strstr(line, key);
+  return p != nullptr && sscanf(p + strlen(key), "%lf", value) == 1;
+}
+
+// Add the "total" records of a db_bench --stats_format=json file to
+// "results" under "mode"
+static Status ParseStatsFile(const std::string& fname, const char* mode,
+                             Results* results) {
+  std::string contents;
+  Status s = ReadFileToString(Env::Default(), fname, &contents);
+  if (!s.ok()) return s;
+  size_t start = 0;
+  while (start < contents.size()) {
+    size_t end = contents.find('\n', start);
+    if (end == std::string::npos) end = contents.size();
+    std::string line = contents.substr(start, end - start);
+    start = end + 1;
+    if (line.find("\"kind\":\"total\"") == std::string::npos) continue;
+
+    static const char kBenchmark[] = "{\"benchmark\":\"";
+    size_t name_start = line.find(kBenchmark);
+    size_t name_end = line.find('"', name_start + sizeof(kBenchmark) - 1);
+    double ops_per_sec, p99;
+    const char* all = strstr(line.c_str(), "\"all\":{");
+    if (name_start != 0 || name_end == std::string::npos ||
+        !FindNumber(line.c_str(), "\"ops_per_sec\":", &ops_per_sec) ||
+        all == nullptr || !FindNumber(all, "\"p99\":", &p99)) {
+      return Status::Corruption("bad stats record", line);
+    }
+    std::string name = line.substr(sizeof(kBenchmark) - 1,
+                                   name_end - (sizeof(kBenchmark) - 1));
+    Cell* cell = &(*results)[std::string(mode) + "/" + name];
+    cell->ops_per_sec.push_back(ops_per_sec);
+    cell->p99_us.push_back(p99);
+  }
+  return Status::OK();
+}
+
+static Status RunMode(const Mode& mode, int repeat, Results* results) {
+  Env* env = Env::Default();
+  const std::string dir = std::string(FLAGS_dir) + "/" + mode.name;
+  const std::string pmem_dir = dir + "/pmem";
+  env->CreateDir(dir);
+  env->CreateDir(pmem_dir);
+  ClearDir(env, pmem_dir);
+  const std::string stats_file = dir + "/stats.json";
+  char log_name[100];
+  snprintf(log_name, sizeof(log_name), "/db_bench.%d.log", repeat);
+  const std::string log_file = dir + log_name;
+  env->DeleteFile(stats_file);
+
+  char cmd[4096];
+  snprintf(cmd, sizeof(cmd),
+           "'%s' %s --benchmarks=%s --num=%d --reads=%d --value_size=%d "
+           "--db='%s/db' --pmem_dir='%s' --stats_file='%s' "
+           "--stats_format=json > '%s' 2>&1",
+           FLAGS_db_bench, mode.flags, FLAGS_benchmarks, FLAGS_num,
+           FLAGS_reads, FLAGS_value_size, dir.c_str(), pmem_dir.c_str(),
+           stats_file.c_str(), log_file.c_str());
+  fprintf(stderr, "%-8s run %d/%d ... ", mode.name, repeat + 1,
+          FLAGS_repeats);
+  const double start = env->NowMicros();
+  const int rc = system(cmd);
+  // Free the pools before the next run creates its own
+  ClearDir(env, pmem_dir);
+  if (rc != 0) {
+    fprintf(stderr, "failed\n");
+    return Status::IOError("db_bench failed, see", log_file);
+  }
+  fprintf(stderr, "%.1fs\n", (env->NowMicros() - start) * 1e-6);
+  return ParseStatsFile(stats_file, mode.name, results);
+}
+
+static std::string ResultsToJSON(const Results& results) {
+  std::string r;
+  char buf[400];
+  snprintf(buf, sizeof(buf),
+           "{\"num\": %d, \"reads\": %d, \"value_size\": %d, "
+           "\"repeats\": %d, \"results\": [\n",
+           FLAGS_num, FLAGS_reads, FLAGS_value_size, FLAGS_repeats);
+  r.append(buf);
+  // One cell per line, which is what ParseResults expects
+  for (Results::const_iterator it = results.begin(); it != results.end();
+       ++it) {
+    snprintf(buf, sizeof(buf),
+             "%s{\"cell\": \"%s\", \"ops_per_sec\": %.1f, "
+             "\"ops_per_sec_stddev\": %.1f, \"p99_us\": %.3f, "
+             "\"p99_us_stddev\": %.3f}",
+             it == results.begin() ? "" : ",\n", it->first.c_str(),
+             it->second.throughput.mean, it->second.throughput.stddev,
+             it->second.p99.mean, it->second.p99.stddev);
+    r.append(buf);
+  }
+  r.append("\n]}\n");
+  return r;
+}
+
+// Read a file written by ResultsToJSON
+static Status ParseResults(const std::string& fname, Results* results) {
+  std::string contents;
+  Status s = ReadFileToString(Env::Default(), fname, &contents);
+  if (!s.ok()) return s;
+  size_t start = 0;
+  while (start < contents.size()) {
+    size_t end = contents.find('\n', start);
+    if (end == std::string::npos) end = contents.size();
+    std::string line = contents.substr(start, end - start);
+    start = end + 1;
+    if (line.find("{\"cell\": ") == std::string::npos) continue;
+
+    char name[200];
+    Cell cell;
+    if (sscanf(line.c_str(),
+               "{\"cell\": \"%199[^\"]\", \"ops_per_sec\": %lf, "
+               "\"ops_per_sec_stddev\": %lf, \"p99_us\": %lf, "
+               "\"p99_us_stddev\": %lf}",
+               name, &cell.throughput.mean, &cell.throughput.stddev,
+               &cell.p99.mean, &cell.p99.stddev) != 5) {
+      return Status::Corruption("bad baseline record", line);
+    }
+    (*results)[name] = cell;
+  }
+  return Status::OK();
+}
+
+// Relative change of "cur" against "base" in percent, and whether it is
+// larger than both "threshold" and the noise of the two summaries
+static bool Exceeds(const Summary& base, const Summary& cur,
+                    double threshold, double* change) {
+  if (base.mean <= 0) {
+    *change = 0;
+    return false;
+  }
+  *change = (cur.mean - base.mean) / base.mean * 100;
+  const double noise =
+      FLAGS_noise_sigmas *
+      sqrt(base.stddev * base.stddev + cur.stddev * cur.stddev) /
+      base.mean * 100;
+  const double limit = threshold > noise ? threshold : noise;
+  return fabs(*change) > limit;
+}
+
+// Print the comparison and return the number of regressed cells
+static int Compare(const Results& baseline, const Results& results) {
+  int regressions = 0;
+  fprintf(stdout, "%-24s %14s %9s %12s %9s\n", "cell", "ops/sec",
+          "change", "p99(us)", "change");
+  for (Results::const_iterator it = results.begin(); it != results.end();
+       ++it) {
+    const Cell& cur = it->second;
+    Results::const_iterator base = baseline.find(it->first);
+    if (base == baseline.end()) {
+      fprintf(stdout, "%-24s %14.1f %9s %12.3f %9s\n", it->first.c_str(),
+              cur.throughput.mean, "new", cur.p99.mean, "new");
+      continue;
+    }
+    double throughput_change, p99_change;
+    const bool slower = Exceeds(base->second.throughput, cur.throughput,
+                                FLAGS_threshold, &throughput_change) &&
+                        throughput_change < 0;
+    const bool laggier = Exceeds(base->second.p99, cur.p99,
+                                 FLAGS_latency_threshold, &p99_change) &&
+                         p99_change > 0;
+    fprintf(stdout, "%-24s %14.1f %+8.1f%% %12.3f %+8.1f%%%s\n",
+            it->first.c_str(), cur.throughput.mean, throughput_change,
+            cur.p99.mean, p99_change,
+            (slower || laggier) ? "  REGRESSION" : "");
+    if (slower || laggier) {
+      regressions++;
+    }
+  }
+  return regressions;
+}
+
+}  // namespace
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  std::string default_db_bench;
+  std::string default_output;
+  for (int i = 1; i < argc; i++) {
+    double d;
+    int n;
+    char junk;
+    if (leveldb::Slice(argv[i]).starts_with("--db_bench=")) {
+      FLAGS_db_bench = argv[i] + strlen("--db_bench=");
+    } else if (leveldb::Slice(argv[i]).starts_with("--dir=")) {
+      FLAGS_dir = argv[i] + strlen("--dir=");
+    } else if (leveldb::Slice(argv[i]).starts_with("--modes=")) {
+      FLAGS_modes = argv[i] + strlen("--modes=");
+    } else if (leveldb::Slice(argv[i]).starts_with("--benchmarks=")) {
+      FLAGS_benchmarks = argv[i] + strlen("--benchmarks=");
+    } else if (sscanf(argv[i], "--num=%d%c", &n, &junk) == 1 && n > 0) {
+      FLAGS_num = n;
+    } else if (sscanf(argv[i], "--reads=%d%c", &n, &junk) == 1 && n > 0) {
+      FLAGS_reads = n;
+    } else if (sscanf(argv[i], "--value_size=%d%c", &n, &junk) == 1 &&
+               n > 0) {
+      FLAGS_value_size = n;
+    } else if (sscanf(argv[i], "--repeats=%d%c", &n, &junk) == 1 && n > 0) {
+      FLAGS_repeats = n;
+    } else if (leveldb::Slice(argv[i]).starts_with("--output=")) {
+      FLAGS_output = argv[i] + strlen("--output=");
+    } else if (leveldb::Slice(argv[i]).starts_with("--baseline=")) {
+      FLAGS_baseline = argv[i] + strlen("--baseline=");
+    } else if (sscanf(argv[i], "--threshold=%lf%c", &d, &junk) == 1 &&
+               d >= 0) {
+      FLAGS_threshold = d;
+    } else if (sscanf(argv[i], "--latency_threshold=%lf%c", &d, &junk) == 1 &&
+               d >= 0) {
+      FLAGS_latency_threshold = d;
+    } else if (sscanf(argv[i], "--noise_sigmas=%lf%c", &d, &junk) == 1 &&
+               d >= 0) {
+      FLAGS_noise_sigmas = d;
+    } else {
+      fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+      exit(1);
+    }
+  }
+
+  if (FLAGS_db_bench == nullptr) {
+    default_db_bench = argv[0];
+    const size_t slash = default_db_bench.rfind('/');
+    default_db_bench = (slash == std::string::npos)
+                           ? "./db_bench"
+                           : default_db_bench.substr(0, slash) + "/db_bench";
+    FLAGS_db_bench = default_db_bench.c_str();
+  }
+  if (FLAGS_output == nullptr) {
+    default_output = std::string(FLAGS_dir) + "/results.json";
+    FLAGS_output = default_output.c_str();
+  }
+  // Pools on tmpfs: skip the msync() PMDK would otherwise do per flush
+  setenv("PMEM_IS_PMEM_FORCE", "1", 0);
+
+  leveldb::Env* env = leveldb::Env::Default();
+  env->CreateDir(FLAGS_dir);
+
+  // Read the baseline first so that a bad path fails before the runs
+  leveldb::Results baseline;
+  if (FLAGS_baseline != nullptr) {
+    leveldb::Status s = leveldb::ParseResults(FLAGS_baseline, &baseline);
+    if (!s.ok()) {
+      fprintf(stderr, "baseline: %s\n", s.ToString().c_str());
+      exit(1);
+    }
+  }
+
+  std::vector<std::string> modes = leveldb::Split(FLAGS_modes);
+  std::vector<const leveldb::Mode*> selected;
+  uint64_t needed = 0;
+  for (size_t m = 0; m < modes.size(); m++) {
+    const leveldb::Mode* mode = nullptr;
+    for (size_t i = 0; i < sizeof(leveldb::kModes) / sizeof(leveldb::kModes[0]);
+         i++) {
+      if (modes[m] == leveldb::kModes[i].name) {
+        mode = &leveldb::kModes[i];
+      }
+    }
+    if (mode == nullptr) {
+      fprintf(stderr, "unknown mode '%s'\n", modes[m].c_str());
+      exit(1);
+    }
+    selected.push_back(mode);
+    // Pools of leftover runs would count against the free space
+    leveldb::ClearDir(env, std::string(FLAGS_dir) + "/" + mode->name +
+                               "/pmem");
+    if (leveldb::SpaceNeeded(*mode) > needed) {
+      needed = leveldb::SpaceNeeded(*mode);
+    }
+  }
+
+  // Modes run one at a time and free their pools, so the largest one
+  // must fit.  Creating a pool on a full tmpfs fails late and can take
+  // the box into swap, so check up front.
+  struct statvfs fs;
+  if (statvfs(FLAGS_dir, &fs) != 0) {
+    fprintf(stderr, "%s: cannot stat: %s\n", FLAGS_dir, strerror(errno));
+    exit(1);
+  }
+  const uint64_t available = uint64_t(fs.f_bavail) * fs.f_frsize;
+  if (available < needed) {
+    fprintf(stderr,
+            "%s: %.1f MB free, the selected modes need %.1f MB "
+            "(PMEM pools of %.1f MB x %d skiplist, %.1f MB x %d buffer); "
+            "use a larger --dir or a -DLEVELDB_SMALL_PMEM_POOLS=ON build\n",
+            FLAGS_dir, available / 1048576.0, needed / 1048576.0,
+            SKIPLIST_MANAGER_POOL_SIZE / 1048576.0, NUM_OF_SKIPLIST_MANAGER,
+            BUFFER_POOL_SIZE / 1048576.0, NUM_OF_BUFFER);
+    exit(1);
+  }
+
+  leveldb::Results results;
+  for (size_t m = 0; m < selected.size(); m++) {
+    const leveldb::Mode* mode = selected[m];
+    for (int r = 0; r < FLAGS_repeats; r++) {
+      leveldb::Status s = leveldb::RunMode(*mode, r, &results);
+      if (!s.ok()) {
+        fprintf(stderr, "%s: %s\n", mode->name, s.ToString().c_str());
+        exit(1);
+      }
+    }
+  }
+  for (leveldb::Results::iterator it = results.begin(); it != results.end();
+       ++it) {
+    it->second.throughput = leveldb::Summarize(it->second.ops_per_sec);
+    it->second.p99 = leveldb::Summarize(it->second.p99_us);
+  }
+
+  leveldb::Status s = leveldb::WriteStringToFile(
+      env, leveldb::ResultsToJSON(results), FLAGS_output);
+  if (!s.ok()) {
+    fprintf(stderr, "output: %s\n", s.ToString().c_str());
+    exit(1);
+  }
+  fprintf(stderr, "Results written to %s\n", FLAGS_output);
+
+  if (FLAGS_baseline == nullptr) {
+    leveldb::Results empty;
+    leveldb::Compare(empty, results);
+    return 0;
+  }
+  const int regressions = leveldb::Compare(baseline, results);
+  if (regressions > 0) {
+    fprintf(stdout, "%d of %d cells regressed against %s\n", regressions,
+            static_cast<int>(results.size()), FLAGS_baseline);
+    return 1;
+  }
+  return 0;
+}
@@ -10,6 +10,10 @@
 #include "db/write_batch_internal.h"
 #include "leveldb/cache.h"
 #include "leveldb/env.h"
+#include "leveldb/listener.h"
+#include "leveldb/perf_context.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/statistics.h"
 #include "leveldb/table.h"
 #include "port/port.h"
 #include "port/thread_annotations.h"
@@ -613,6 +617,220 @@ TEST(DBTest, GetMemUsage) {
   } while (ChangeOptions());
 }
 
+TEST(DBTest, GetTierStats) {
+  ASSERT_OK(Put("foo", "v1"));
+  ASSERT_EQ("v1", Get("foo"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("missing"));
+  std::string val;
+  ASSERT_TRUE(db_->GetProperty("leveldb.tier-stats", &val));
+  ASSERT_TRUE(val.find("Memtable hits: 1\n") != std::string::npos) << val;
+  ASSERT_TRUE(val.find("Misses: 1\n") != std::string::npos) << val;
+}
+
+TEST(DBTest, GetPmemStats) {
+  Statistics* statistics = NewStatistics();
+  Options options = CurrentOptions();
+  options.statistics = statistics;
+  Reopen(&options);
+
+  ASSERT_OK(Put("foo", "v1"));
+  ASSERT_EQ("v1", Get("foo"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("missing"));
+  ASSERT_EQ(1, statistics->GetTickerCount(kMemtableHits));
+  ASSERT_EQ(1, statistics->GetTickerCount(kGetMisses));
+  uint64_t level_hits = 0;
+  for (int level = 0; level < config::kNumLevels; level++) {
+    level_hits += statistics->GetLevelTickerCount(kPmemHits, level) +
+                  statistics->GetLevelTickerCount(kSstHits, level);
+  }
+  ASSERT_EQ(1, level_hits);
+  // Latency histograms are kept for user-supplied statistics
+  ASSERT_EQ(3, statistics->GetHistogramCount(kGetMicros));
+  ASSERT_EQ(1, statistics->GetHistogramCount(kWriteMicros));
+
+  std::string val;
+  ASSERT_TRUE(db_->GetProperty("leveldb.pmem-stats", &val));
+  ASSERT_TRUE(val.find("memtable.hits") != std::string::npos) << val;
+  ASSERT_TRUE(db_->GetProperty("leveldb.pmem-stats-json", &val));
+  ASSERT_TRUE(val.find("\"memtable.hits\": 1") != std::string::npos) << val;
+  ASSERT_TRUE(val.find("\"get.micros\": {\"count\": 3") !=
+              std::string::npos) << val;
+
+  Close();
+  delete statistics;
+}
+
+TEST(DBTest, GetAmplification) {
+  Statistics* statistics = NewStatistics();
+  Options options = CurrentOptions();
+  options.statistics = statistics;
+  Reopen(&options);
+
+  ASSERT_OK(Put("foo", std::string(1000, 'v')));
+  ASSERT_OK(Put("bar", std::string(1000, 'w')));
+  const uint64_t user_bytes = statistics->GetTickerCount(kUserBytesWritten);
+  ASSERT_GE(user_bytes, 2000);
+  // Each record is framed by the log, so the WAL writes at least as much
+  ASSERT_GE(statistics->GetTickerCount(kWalBytesWritten), user_bytes);
+
+  dbfull()->TEST_CompactMemTable();
+  std::string val;
+  ASSERT_TRUE(db_->GetProperty("leveldb.amplification", &val));
+  ASSERT_TRUE(val.find("Write amplification") != std::string::npos) << val;
+  ASSERT_TRUE(val.find("Space amplification: 1.00") != std::string::npos)
+      << val;
+
+  Close();
+  delete statistics;
+}
+
+TEST(DBTest, GetAmplificationPmemMemTable) {
+  Statistics* statistics = NewStatistics();
+  Options options = CurrentOptions();
+  options.statistics = statistics;
+  options.use_pmem_memtable = true;
+  Reopen(&options);
+
+  for (int i = 0; i < 200; i++) {
+    ASSERT_OK(Put("key" + NumberToString(i), std::string(1000, 'v')));
+  }
+  dbfull()->TEST_CompactMemTable();
+  const uint64_t user_bytes = statistics->GetTickerCount(kUserBytesWritten);
+  // Every entry went into the memtable extent once, framing included
+  ASSERT_GE(statistics->GetTickerCount(kPmemBytesWritten), user_bytes);
+
+  std::string val;
+  ASSERT_TRUE(db_->GetProperty("leveldb.amplification", &val));
+  const size_t pos = val.find("Write amplification: ");
+  ASSERT_TRUE(pos != std::string::npos) << val;
+  double total, pmem, sst, wal;
+  ASSERT_EQ(4, sscanf(val.c_str() + pos,
+                      "Write amplification: %lf (PMEM %lf, SST %lf, WAL %lf)",
+                      &total, &pmem, &sst, &wal)) << val;
+  ASSERT_GE(pmem, 1.0) << val;
+  ASSERT_GE(total, pmem + wal) << val;
+
+  Close();
+  delete statistics;
+}
+
+TEST(DBTest, PerfContext) {
+  ASSERT_OK(Put("foo", "v1"));
+  ASSERT_OK(Put("bar", "b1"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_OK(Put("baz", "z1"));
+
+  // Disabled by default
+  PerfContext* perf = GetPerfContext();
+  perf->Reset();
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("", perf->ToString());
+
+  SetPerfLevel(kPerfEnableTime);
+  perf->Reset();
+  ASSERT_EQ("z1", Get("baz"));
+  ASSERT_GT(perf->get_memtable_nanos, 0);
+  ASSERT_EQ(0, perf->get_from_files_nanos);
+
+  perf->Reset();
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_GT(perf->get_from_files_nanos, 0);
+  ASSERT_EQ(1, perf->sst_probe_count + perf->pmem_probe_count)
+      << perf->ToString();
+
+  // Deleted and overwritten entries stepped over by an iterator
+  perf->Reset();
+  ASSERT_OK(Delete("bar"));
+  ASSERT_OK(Put("foo", "v2"));
+  ASSERT_EQ("(baz->z1)(foo->v2)", Contents());
+  ASSERT_EQ(1, perf->internal_delete_skipped_count) << perf->ToString();
+  ASSERT_GE(perf->internal_key_skipped_count, 2) << perf->ToString();
+
+  SetPerfLevel(kPerfDisabled);
+}
+
+namespace {
+
+class RecordingListener : public EventListener {
+ public:
+  port::Mutex mu;
+  std::vector<FlushJobInfo> flushes GUARDED_BY(mu);
+  std::vector<CompactionJobInfo> compactions GUARDED_BY(mu);
+  int flushes_begun GUARDED_BY(mu) = 0;
+  int compactions_begun GUARDED_BY(mu) = 0;
+
+  virtual void OnFlushBegin(const FlushJobInfo& info) {
+    MutexLock l(&mu);
+    flushes_begun++;
+  }
+  virtual void OnFlushCompleted(const FlushJobInfo& info) {
+    MutexLock l(&mu);
+    flushes.push_back(info);
+  }
+  virtual void OnCompactionBegin(const CompactionJobInfo& info) {
+    MutexLock l(&mu);
+    compactions_begun++;
+  }
+  virtual void OnCompactionCompleted(const CompactionJobInfo& info) {
+    MutexLock l(&mu);
+    compactions.push_back(info);
+  }
+};
+
+}  // namespace
+
+TEST(DBTest, EventListener) {
+  RecordingListener listener;
+  Options options = CurrentOptions();
+  options.listener = &listener;
+  Reopen(&options);
+
+  ASSERT_OK(Put("a", "v1"));
+  ASSERT_OK(Put("b", "v1"));
+  dbfull()->TEST_CompactMemTable();
+  {
+    MutexLock l(&listener.mu);
+    ASSERT_EQ(1, listener.flushes_begun);
+    ASSERT_EQ(1, listener.flushes.size());
+    const FlushJobInfo& flush = listener.flushes[0];
+    ASSERT_OK(flush.status);
+    ASSERT_GT(flush.output.number, 0);
+    ASSERT_GT(flush.output.size, 0);
+    ASSERT_GT(flush.memtable_bytes, 0);
+  }
+
+  // Overwrite "a" and delete "b" so that compactions drop entries
+  ASSERT_OK(Put("a", "v2"));
+  ASSERT_OK(Delete("b"));
+  dbfull()->TEST_CompactMemTable();
+  dbfull()->CompactRange(nullptr, nullptr);
+  {
+    MutexLock l(&listener.mu);
+    ASSERT_GE(listener.compactions.size(), 1);
+    ASSERT_EQ(listener.compactions_begun, listener.compactions.size());
+    uint64_t dropped = 0;
+    for (size_t i = 0; i < listener.compactions.size(); i++) {
+      const CompactionJobInfo& c = listener.compactions[i];
+      ASSERT_OK(c.status);
+      ASSERT_GT(c.inputs.size(), 0);
+      ASSERT_GE(c.input_entries, c.dropped_entries);
+      ASSERT_LE(c.hot_entries + c.warm_entries,
+                c.input_entries - c.dropped_entries);
+      ASSERT_NE(listener.flushes[0].job_id, c.job_id);
+      dropped += c.dropped_entries;
+    }
+    ASSERT_GE(dropped, 2);
+  }
+  ASSERT_EQ("v2", Get("a"));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+
+  Close();
+}
+
 TEST(DBTest, GetSnapshot) {
   do {
     // Try with both a short key and a long key
@@ -631,6 +849,46 @@ TEST(DBTest, GetSnapshot) {
   } while (ChangeOptions());
 }
 
+TEST(DBTest, PmemRowCache) {
+  Cache* row_cache = NewLRUCache(1 << 20);
+  Options options = CurrentOptions();
+  options.pmem_row_cache = row_cache;
+  Reopen(&options);
+
+  ASSERT_OK(Put("foo", "v1"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("v1", Get("foo"));  // Served from the row cache
+
+  // A newer table must shadow the cached entry, while a snapshot
+  // still sees the old value.
+  const Snapshot* s1 = db_->GetSnapshot();
+  ASSERT_OK(Put("foo", "v2"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("v2", Get("foo"));
+  ASSERT_EQ("v2", Get("foo"));
+  ASSERT_EQ("v1", Get("foo", s1));
+
+  ASSERT_OK(Delete("foo"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+  ASSERT_EQ("v1", Get("foo", s1));
+  db_->ReleaseSnapshot(s1);
+
+  // Compaction moves the data into new tables; stale entries must not
+  // be used.
+  ASSERT_OK(Put("bar", "b1"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_EQ("b1", Get("bar"));
+  dbfull()->CompactRange(nullptr, nullptr);
+  ASSERT_EQ("b1", Get("bar"));
+  ASSERT_EQ("NOT_FOUND", Get("foo"));
+
+  Close();
+  delete row_cache;
+}
+
 TEST(DBTest, GetIdenticalSnapshots) {
   do {
     // Try with both a short key and a long key
@@ -935,6 +1193,42 @@ TEST(DBTest, IterSmallAndLargeMix) {
   delete iter;
 }
 
+TEST(DBTest, IterBounds) {
+  ASSERT_OK(Put("a", "va"));
+  ASSERT_OK(Put("b", "vb"));
+  dbfull()->TEST_CompactMemTable();
+  ASSERT_OK(Put("c", "vc"));
+  ASSERT_OK(Put("d", "vd"));
+
+  Slice lower("b");
+  Slice upper("d");
+  ReadOptions options;
+  options.iterate_lower_bound = &lower;
+  options.iterate_upper_bound = &upper;
+  Iterator* iter = db_->NewIterator(options);
+
+  iter->SeekToFirst();
+  ASSERT_EQ(IterStatus(iter), "b->vb");
+  iter->Next();
+  ASSERT_EQ(IterStatus(iter), "c->vc");
+  iter->Next();
+  ASSERT_EQ(IterStatus(iter), "(invalid)");
+
+  iter->SeekToLast();
+  ASSERT_EQ(IterStatus(iter), "c->vc");
+  iter->Prev();
+  ASSERT_EQ(IterStatus(iter), "b->vb");
+  iter->Prev();
+  ASSERT_EQ(IterStatus(iter), "(invalid)");
+
+  iter->Seek("a");
+  ASSERT_EQ(IterStatus(iter), "b->vb");
+  iter->Seek("d");
+  ASSERT_EQ(IterStatus(iter), "(invalid)");
+
+  delete iter;
+}
+
 TEST(DBTest, IterMultiWithDelete) {
   do {
     ASSERT_OK(Put("a", "va"));
@@ -1015,6 +1309,80 @@ static std::string Key(int i) {
   return std::string(buf);
 }
 
+TEST(DBTest, PmemMemTable) {
+  Options options = CurrentOptions();
+  options.use_pmem_memtable = true;
+  options.write_buffer_size = 100000;  // Small write buffer
+  Reopen(&options);
+
+  // More than one memtable worth of data, with overwrites and deletions
+  for (int i = 0; i < 2000; i++) {
+    ASSERT_OK(Put(Key(i % 500), Key(i)));
+  }
+  ASSERT_OK(Delete(Key(7)));
+  dbfull()->TEST_CompactMemTable();
+  for (int i = 0; i < 500; i++) {
+    if (i == 7) {
+      ASSERT_EQ("NOT_FOUND", Get(Key(i)));
+    } else {
+      ASSERT_EQ(Key(1500 + i), Get(Key(i)));
+    }
+  }
+
+  Iterator* iter = db_->NewIterator(ReadOptions());
+  int count = 0;
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    count++;
+  }
+  ASSERT_EQ(499, count);
+  delete iter;
+}
+
+TEST(DBTest, RecoverAcrossPmemLogSwitch) {
+  Options options = CurrentOptions();
+  options.use_pmem_log = false;
+  Reopen(&options);
+  ASSERT_OK(Put("foo", "v1"));
+  ASSERT_OK(Put("bar", "v2"));
+
+  // Unflushed writes in a *.log file survive turning the pmem log on
+  options.use_pmem_log = true;
+  Reopen(&options);
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("v2", Get("bar"));
+  ASSERT_OK(Put("baz", "v3"));
+
+  // ... and those in a pmem log segment survive turning it off again
+  options.use_pmem_log = false;
+  Reopen(&options);
+  ASSERT_EQ("v1", Get("foo"));
+  ASSERT_EQ("v2", Get("bar"));
+  ASSERT_EQ("v3", Get("baz"));
+}
+
+TEST(DBTest, DirectIOAndRateLimitedTableWrites) {
+  RateLimiter* limiter = NewRateLimiter(100 << 20);
+  Options options = CurrentOptions();
+  options.sst_type = kFileDescriptorSST;
+  options.use_direct_io_for_flush_and_compaction = true;
+  options.rate_limiter = limiter;
+  options.write_buffer_size = 100000;  // Small write buffer
+  Reopen(&options);
+
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_OK(Put(Key(i), Key(i) + std::string(100, 'v')));
+  }
+  dbfull()->TEST_CompactMemTable();
+  dbfull()->TEST_CompactRange(0, nullptr, nullptr);
+  ASSERT_GT(limiter->GetTotalBytesThrough(), 100000);
+  for (int i = 0; i < 1000; i++) {
+    ASSERT_EQ(Key(i) + std::string(100, 'v'), Get(Key(i)));
+  }
+
+  Close();
+  delete limiter;
+}
+
 TEST(DBTest, MinorCompactionsHappen) {
   Options options = CurrentOptions();
   options.write_buffer_size = 10000;
@@ -0,0 +1,113 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/event_log.h"
+
+#include <stdio.h>
+
+namespace leveldb {
+
+EventListener::~EventListener() { }
+
+namespace {
+
+void AppendNumber(std::string* r, const char* name, uint64_t value) {
+  char buf[100];
+  snprintf(buf, sizeof(buf), ", \"%s\": %llu", name,
+           static_cast<unsigned long long>(value));
+  r->append(buf);
+}
+
+void AppendStatus(std::string* r, const Status& s) {
+  r->append(", \"status\": \"");
+  // Status messages may hold file names and keys; keep the JSON valid
+  for (char c : s.ToString()) {
+    if (c == '"' || c == '\\') {
+      r->push_back('\\');
+      r->push_back(c);
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      r->push_back(' ');
+    } else {
+      r->push_back(c);
+    }
+  }
+  r->push_back('"');
+}
+
+void AppendFile(std::string* r, const JobFileInfo& f) {
+  char buf[200];
+  snprintf(buf, sizeof(buf),
+           "{\"number\": %llu, \"level\": %d, \"tier\": \"%s\", "
+           "\"hot\": %s, \"size\": %llu}",
+           static_cast<unsigned long long>(f.number), f.level,
+           f.in_pmem ? "pmem" : "sst", f.hot ? "true" : "false",
+           static_cast<unsigned long long>(f.size));
+  r->append(buf);
+}
+
+void AppendFiles(std::string* r, const char* name,
+                 const std::vector<JobFileInfo>& files) {
+  r->append(", \"");
+  r->append(name);
+  r->append("\": [");
+  for (size_t i = 0; i < files.size(); i++) {
+    if (i > 0) r->append(", ");
+    AppendFile(r, files[i]);
+  }
+  r->push_back(']');
+}
+
+void AppendHeader(std::string* r, const char* event, int job_id) {
+  char buf[100];
+  snprintf(buf, sizeof(buf), "{\"event\": \"%s\", \"job\": %d", event,
+           job_id);
+  r->append(buf);
+}
+
+}  // namespace
+
+std::string FlushEventToJSON(const FlushJobInfo& info, bool finished) {
+  std::string r;
+  AppendHeader(&r, finished ? "flush_finished" : "flush_started",
+               info.job_id);
+  AppendNumber(&r, "memtable_bytes", info.memtable_bytes);
+  if (finished) {
+    r.append(", \"output\": ");
+    AppendFile(&r, info.output);
+    AppendNumber(&r, "micros", info.micros);
+    AppendNumber(&r, "cpu_micros", info.cpu_micros);
+    AppendStatus(&r, info.status);
+  }
+  r.push_back('}');
+  return r;
+}
+
+std::string CompactionEventToJSON(const CompactionJobInfo& info,
+                                  bool finished) {
+  std::string r;
+  AppendHeader(&r, finished ? "compaction_finished" : "compaction_started",
+               info.job_id);
+  char buf[50];
+  snprintf(buf, sizeof(buf), ", \"level\": %d", info.level);
+  r.append(buf);
+  AppendFiles(&r, "inputs", info.inputs);
+  if (finished) {
+    AppendFiles(&r, "outputs", info.outputs);
+    AppendNumber(&r, "bytes_read", info.bytes_read);
+    AppendNumber(&r, "bytes_written", info.bytes_written);
+    AppendNumber(&r, "lru_flushed_bytes", info.lru_flushed_bytes);
+    AppendNumber(&r, "input_entries", info.input_entries);
+    AppendNumber(&r, "dropped_entries", info.dropped_entries);
+    AppendNumber(&r, "hot_entries", info.hot_entries);
+    AppendNumber(&r, "warm_entries", info.warm_entries);
+    AppendNumber(&r, "micros", info.micros);
+    AppendNumber(&r, "cpu_micros", info.cpu_micros);
+    AppendNumber(&r, "stall_micros", info.stall_micros);
+    AppendStatus(&r, info.status);
+  }
+  r.push_back('}');
+  return r;
+}
+
+}  // namespace leveldb
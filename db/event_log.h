@@ -0,0 +1,23 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// JSON encoding of the flush and compaction events in leveldb/listener.h,
+// one object per event, for the info log.
+
+#ifndef STORAGE_LEVELDB_DB_EVENT_LOG_H_
+#define STORAGE_LEVELDB_DB_EVENT_LOG_H_
+
+#include <string>
+#include "leveldb/listener.h"
+
+namespace leveldb {
+
+// A "*_started" event, or a "*_finished" one with the job's results
+std::string FlushEventToJSON(const FlushJobInfo& info, bool finished);
+std::string CompactionEventToJSON(const CompactionJobInfo& info,
+                                  bool finished);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_EVENT_LOG_H_
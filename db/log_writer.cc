@@ -21,12 +21,14 @@ static void InitTypeCrc(uint32_t* type_crc) {
 
 Writer::Writer(WritableFile* dest)
     : dest_(dest),
-      block_offset_(0) {
+      block_offset_(0),
+      bytes_written_(0) {
   InitTypeCrc(type_crc_);
 }
 
 Writer::Writer(WritableFile* dest, uint64_t dest_length)
-    : dest_(dest), block_offset_(dest_length % kBlockSize) {
+    : dest_(dest), block_offset_(dest_length % kBlockSize),
+      bytes_written_(0) {
   InitTypeCrc(type_crc_);
 }
 
@@ -51,6 +53,7 @@ Status Writer::AddRecord(const Slice& slice) {
         // Fill the trailer (literal below relies on kHeaderSize being 7)
         assert(kHeaderSize == 7);
         dest_->Append(Slice("\x00\x00\x00\x00\x00\x00", leftover));
+        bytes_written_ += leftover;
       }
       block_offset_ = 0;
     }
@@ -105,6 +108,7 @@ Status Writer::EmitPhysicalRecord(RecordType t, const char* ptr, size_t n) {
     }
   }
   block_offset_ += kHeaderSize + n;
+  bytes_written_ += kHeaderSize + n;
   return s;
 }
 
@@ -32,9 +32,14 @@ class Writer {
 
   Status AddRecord(const Slice& slice);
 
+  // Bytes appended to "*dest" by this writer, including record headers
+  // and block trailers
+  uint64_t BytesWritten() const { return bytes_written_; }
+
  private:
   WritableFile* dest_;
   int block_offset_;       // Current offset in block
+  uint64_t bytes_written_;
 
   // crc32c values for all supported record types.  These are
   // pre-computed to reduce the overhead of computing the crc of the
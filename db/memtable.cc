@@ -7,6 +7,7 @@
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/iterator.h"
+#include "pmem/pmem_buffer.h"
 #include "util/coding.h"
 
 namespace leveldb {
@@ -21,14 +22,52 @@ static Slice GetLengthPrefixedSlice(const char* data) {
 MemTable::MemTable(const InternalKeyComparator& cmp)
     : comparator_(cmp),
       refs_(0),
-      table_(comparator_, &arena_) {
+      table_(comparator_, &arena_),
+      pmem_buffer_(nullptr),
+      extent_(nullptr),
+      extent_size_(0),
+      extent_used_(0) {
+}
+
+MemTable::MemTable(const InternalKeyComparator& cmp,
+                   PmemBuffer* pmem_buffer, size_t extent_size)
+    : comparator_(cmp),
+      refs_(0),
+      table_(comparator_, &arena_),
+      pmem_buffer_(pmem_buffer),
+      extent_(pmem_buffer->AllocateExtent(extent_size)),
+      extent_size_(extent_ != nullptr ? extent_size : 0),
+      extent_used_(0) {
 }
 
 MemTable::~MemTable() {
   assert(refs_ == 0);
+  if (extent_ != nullptr) {
+    // PMEM tables linking its entries keep the extent until they are gone
+    pmem_buffer_->UnrefExtent(extent_);
+  }
+}
+
+size_t MemTable::ApproximateMemoryUsage() {
+  return arena_.MemoryUsage() +
+         reinterpret_cast<uintptr_t>(extent_used_.NoBarrier_Load());
 }
 
-size_t MemTable::ApproximateMemoryUsage() { return arena_.MemoryUsage(); }
+char* MemTable::AllocateEntry(size_t encoded_len) {
+  const size_t used = reinterpret_cast<uintptr_t>(extent_used_.NoBarrier_Load());
+  if (used + encoded_len <= extent_size_) {
+    extent_used_.NoBarrier_Store(reinterpret_cast<void*>(used + encoded_len));
+    return extent_ + used;
+  }
+  return arena_.Allocate(encoded_len);
+}
+
+void MemTable::SealExtent() {
+  const size_t used = reinterpret_cast<uintptr_t>(extent_used_.NoBarrier_Load());
+  if (used > 0) {
+    pmem_buffer_->Persist(extent_, used);
+  }
+}
 
 int MemTable::KeyComparator::operator()(const char* aptr, const char* bptr)
     const {
@@ -50,7 +89,8 @@ static const char* EncodeKey(std::string* scratch, const Slice& target) {
 
 class MemTableIterator: public Iterator {
  public:
-  explicit MemTableIterator(MemTable::Table* table) : iter_(table) { }
+  MemTableIterator(const MemTable* mem, MemTable::Table* table)
+      : mem_(mem), iter_(table) { }
 
   virtual bool Valid() const { return iter_.Valid(); }
   virtual void Seek(const Slice& k) { iter_.Seek(EncodeKey(&tmp_, k)); }
@@ -72,11 +112,18 @@ class MemTableIterator: public Iterator {
   virtual uint16_t refTimes(){ return iter_.refTimes(); }
   
   /*-----------------------------------------------------------*/
+
+  // JH: Entries in the pmem extent can be linked into a PMEM table as is
+  virtual char* buffer_ptr() const {
+    const char* entry = iter_.key();
+    return mem_->InExtent(entry) ? const_cast<char*>(entry) : nullptr;
+  }
  
  
   virtual Status status() const { return Status::OK(); }
 
  private:
+  const MemTable* mem_;
   MemTable::Table::Iterator iter_;
   std::string tmp_;       // For passing to EncodeKey
 
@@ -86,7 +133,7 @@ class MemTableIterator: public Iterator {
 };
 
 Iterator* MemTable::NewIterator() {
-  return new MemTableIterator(&table_);
+  return new MemTableIterator(this, &table_);
 }
 
 void MemTable::Add(SequenceNumber s, ValueType type,
@@ -103,7 +150,7 @@ void MemTable::Add(SequenceNumber s, ValueType type,
   const size_t encoded_len =
       VarintLength(internal_key_size) + internal_key_size +
       VarintLength(val_size) + val_size;
-  char* buf = arena_.Allocate(encoded_len);
+  char* buf = AllocateEntry(encoded_len);
   char* p = EncodeVarint32(buf, internal_key_size);
   memcpy(p, key.data(), key_size);
   p += key_size;
@@ -15,6 +15,7 @@ namespace leveldb {
 
 class InternalKeyComparator;
 class MemTableIterator;
+class PmemBuffer;
 
 class MemTable {
  public:
@@ -22,6 +23,14 @@ class MemTable {
   // is zero and the caller must call Ref() at least once.
   explicit MemTable(const InternalKeyComparator& comparator);
 
+  // JH: Same as above, but entries are stored in an extent of
+  // "extent_size" bytes reserved from "pmem_buffer" (the skiplist index
+  // stays in DRAM).  Once sealed, a PMEM table can point at the entries
+  // in place instead of copying them.  Entries that do not fit fall back
+  // to the DRAM arena.
+  MemTable(const InternalKeyComparator& comparator,
+           PmemBuffer* pmem_buffer, size_t extent_size);
+
   // Increase reference count.
   void Ref() { ++refs_; }
 
@@ -59,6 +68,20 @@ class MemTable {
   // Else, return false.
   bool Get(const LookupKey& key, std::string* value, Status* s);
 
+  // Make every entry written to the pmem extent durable.  Called once the
+  // memtable is immutable, before a PMEM table that links its entries is
+  // installed.  REQUIRES: DBImpl::mutex_ not held (persists the extent).
+  void SealExtent();
+
+  // True if entries go into a pmem extent, false if the pool was full (or
+  // pmem memtables are off) and they go into the DRAM arena
+  bool HasExtent() const { return extent_ != nullptr; }
+
+  // Bytes of entries written to the pmem extent so far
+  size_t ExtentUsage() const {
+    return reinterpret_cast<uintptr_t>(extent_used_.NoBarrier_Load());
+  }
+
  private:
   ~MemTable();  // Private since only Unref() should be used to delete it
 
@@ -72,11 +95,22 @@ class MemTable {
 
   typedef SkipList<const char*, KeyComparator> Table;
 
+  char* AllocateEntry(size_t encoded_len);
+  bool InExtent(const char* entry) const {
+    return entry >= extent_ && entry < extent_ + extent_size_;
+  }
+
   KeyComparator comparator_;
   int refs_;
   Arena arena_;
   Table table_;
 
+  // Pmem extent holding the entries (nullptr if DRAM only)
+  PmemBuffer* const pmem_buffer_;
+  char* extent_;
+  size_t extent_size_;
+  port::AtomicPointer extent_used_;
+
   // No copying allowed
   MemTable(const MemTable&);
   void operator=(const MemTable&);
@@ -166,7 +166,7 @@ class SkipList {
 template <typename Key, class Comparator>
 struct SkipList<Key, Comparator>::Node {
   /*-----------------*/
-  explicit Node(const Key& k) : key(k), ref_times(0) {}
+  explicit Node(const Key& k) : ref_times(0), key(k) {}
   /*-----------------*/
   // zewei
   uint16_t ref_times;  // unsigned short 
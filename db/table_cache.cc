@@ -8,6 +8,8 @@
 #include "leveldb/env.h"
 #include "leveldb/table.h"
 #include "util/coding.h"
+#include "util/perf_context_imp.h"
+#include "util/trace_imp.h"
 
 // JH
 #include <chrono>
@@ -44,10 +46,12 @@ TableCache::TableCache(const std::string& dbname,
     : env_(options.env),
       dbname_(dbname),
       options_(options),
-      cache_(NewLRUCache(entries)) {
+      cache_(NewLRUCache(entries)),
+      pmem_cache_(NewLRUCache(entries)) {
 }
 
 TableCache::~TableCache() {
+  delete pmem_cache_;
   delete cache_;
 }
 
@@ -93,12 +97,12 @@ Status TableCache::FindSkiplist(uint64_t file_number, Cache::Handle** handle) {
   char buf[sizeof(file_number)];
   EncodeFixed64(buf, file_number);
   Slice key(buf, sizeof(buf));
-  *handle = cache_->Lookup(key);
+  *handle = pmem_cache_->Lookup(key);
   if (*handle == nullptr) {
     // printf("Cache Insert %d\n", file_number);
     PmemSkiplist* pmem_skiplist = options_.pmem_skiplist[file_number % NUM_OF_SKIPLIST_MANAGER];
     PmemIterator* pmem_iterator = new PmemIterator(file_number, pmem_skiplist); 
-    *handle = cache_->Insert(key, 
+    *handle = pmem_cache_->Insert(key, 
           pmem_iterator, 
           1, 
           &DeletePmemEntry);
@@ -111,7 +115,8 @@ Status TableCache::FindSkiplist(uint64_t file_number, Cache::Handle** handle) {
 Iterator* TableCache::NewIterator(const ReadOptions& options,
                                   uint64_t file_number,
                                   uint64_t file_size,
-                                  Table** tableptr) {
+                                  Table** tableptr,
+                                  bool for_compaction) {
   if (tableptr != nullptr) {
     *tableptr = nullptr;
   }
@@ -123,6 +128,11 @@ Iterator* TableCache::NewIterator(const ReadOptions& options,
   }
 
   Table* table = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+  if (for_compaction) {
+    // Compaction inputs read the whole table in order; let the device
+    // work ahead of the iterator.
+    table->PrefetchAll(file_size);
+  }
   Iterator* result = table->NewIterator(options);
   result->RegisterCleanup(&UnrefEntry, cache_, handle);
   if (tableptr != nullptr) {
@@ -146,14 +156,22 @@ Iterator* TableCache::NewIteratorFromPmem(const ReadOptions& options,
     Cache::Handle* handle = nullptr;
     Status s = FindSkiplist(file_number, &handle); 
 
-    result = reinterpret_cast<Iterator*>(cache_->Value(handle));
+    PmemIterator* pmem_iterator =
+        reinterpret_cast<PmemIterator*>(pmem_cache_->Value(handle));
+    pmem_iterator->SetChecksumVerification(
+        options.verify_checksums ? options_.pmem_buffer : nullptr);
+    result = pmem_iterator;
     result->SeekToFirst();
     
-    result->RegisterCleanup(&UnrefEntry, cache_, handle);
+    result->RegisterCleanup(&UnrefEntry, pmem_cache_, handle);
 
   } else {
     PmemSkiplist* pmem_skiplist = options_.pmem_skiplist[file_number % NUM_OF_SKIPLIST_MANAGER];
-    result = new PmemIterator(file_number, pmem_skiplist);
+    PmemIterator* pmem_iterator = new PmemIterator(file_number, pmem_skiplist);
+    if (options.verify_checksums) {
+      pmem_iterator->SetChecksumVerification(options_.pmem_buffer);
+    }
+    result = pmem_iterator;
     result->SeekToFirst();
   }
   DelayPmemReadNtimes(1);
@@ -168,8 +186,11 @@ Status TableCache::Get(const ReadOptions& options,
                        void (*saver)(void*, const Slice&, const Slice&)) {
 	// std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
                   
+  TRACE_SPAN("table_cache.get");
   Cache::Handle* handle = nullptr;
+  PERF_TIMER_GUARD(find_table_nanos);
   Status s = FindTable(file_number, file_size, &handle);
+  PERF_TIMER_STOP(find_table_nanos);
   if (s.ok()) {
     Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
     s = t->InternalGet(options, k, arg, saver);
@@ -183,10 +204,12 @@ Status TableCache::Get(const ReadOptions& options,
 // JH
 /* SOLVE: Get based on pmem */
 Status TableCache::GetFromPmem(const Options& options,
+                   bool verify_checksums,
                    uint64_t file_number,
                    const Slice& k,
                    void* arg,
                    void (*saver)(void*, const Slice&, const Slice&)) {
+  TRACE_SPAN("table_cache.get_from_pmem");
   Status s; 
 	// std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
   // printf("Start GetFromPmem\n");
@@ -198,21 +221,28 @@ Status TableCache::GetFromPmem(const Options& options,
     s = FindSkiplist(file_number, &handle); 
 
     PmemIterator* pmem_iterator = 
-                          reinterpret_cast<PmemIterator*>(cache_->Value(handle));
+                          reinterpret_cast<PmemIterator*>(pmem_cache_->Value(handle));
     pmem_iterator->Seek(k);
     (*saver)(arg, pmem_iterator->key(), pmem_iterator->value());
-    cache_->Release(handle);
+    pmem_cache_->Release(handle);
 
   } else {
     // if (options_.skiplist_cache) {
       PmemIterator* pmem_iterator = options.pmem_internal_iterator[file_number % NUM_OF_SKIPLIST_MANAGER]; 
       // pmem_iterator->Ref(file_number);
       pmem_iterator->SetIndex(file_number);
+      pmem_iterator->SetChecksumVerification(
+          verify_checksums ? options.pmem_buffer : nullptr);
+      PERF_TIMER_GUARD(pmem_seek_nanos);
       pmem_iterator->Seek(k);
       Slice res_key = pmem_iterator->key();
       Slice res_value = pmem_iterator->value();
+      PERF_TIMER_STOP(pmem_seek_nanos);
       // pmem_iterator->UnRef(file_number);
-      (*saver)(arg, res_key, res_value);
+      s = pmem_iterator->status();
+      if (s.ok()) {
+        (*saver)(arg, res_key, res_value);
+      }
     // } else {
     //   PmemIterator* pmem_iterator = new PmemIterator(file_number, options.pmem_skiplist[file_number % NUM_OF_SKIPLIST_MANAGER]);
     //   pmem_iterator->Seek(k);
@@ -235,10 +265,22 @@ Status TableCache::GetFromPmem(const Options& options,
 }
 
 
+void TableCache::Prefetch(uint64_t file_number, uint64_t file_size,
+                          const Slice& k) {
+  Cache::Handle* handle = nullptr;
+  Status s = FindTable(file_number, file_size, &handle);
+  if (s.ok()) {
+    Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+    t->Prefetch(k);
+    cache_->Release(handle);
+  }
+}
+
 void TableCache::Evict(uint64_t file_number) {
   char buf[sizeof(file_number)];
   EncodeFixed64(buf, file_number);
   cache_->Erase(Slice(buf, sizeof(buf)));
+  pmem_cache_->Erase(Slice(buf, sizeof(buf)));
 }
 
 }  // namespace leveldb
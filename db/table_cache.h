@@ -29,11 +29,13 @@ class TableCache {
   // underlying the returned iterator, or to nullptr if no Table object
   // underlies the returned iterator.  The returned "*tableptr" object is owned
   // by the cache and should not be deleted, and is valid for as long as the
-  // returned iterator is live.
+  // returned iterator is live.  "for_compaction" marks a compaction input,
+  // which is read start to end, so the whole file is prefetched.
   Iterator* NewIterator(const ReadOptions& options,
                         uint64_t file_number,
                         uint64_t file_size,
-                        Table** tableptr = nullptr);
+                        Table** tableptr = nullptr,
+                        bool for_compaction = false);
   // JH
   Iterator* NewIteratorFromPmem(const ReadOptions& options,
                         uint64_t file_number,
@@ -49,12 +51,19 @@ class TableCache {
              void* arg,
              void (*handle_result)(void*, const Slice&, const Slice&));
   // JH
+  // If "verify_checksums", the pmem-buffer chunk holding the entry found
+  // is checked first (see PmemBuffer::VerifyChunk).
   Status GetFromPmem(const Options& options,
+                     bool verify_checksums,
                      uint64_t file_number,
                      const Slice& k,
                      void* arg,
                      void (*handle_result)(void*, const Slice&, const Slice&));
 
+  // Start fetching the block of the specified file that may hold "k"
+  // (see Table::Prefetch).
+  void Prefetch(uint64_t file_number, uint64_t file_size, const Slice& k);
+
   // Evict any entry for the specified file number
   void Evict(uint64_t file_number);
 
@@ -63,6 +72,9 @@ class TableCache {
   const std::string dbname_;
   const Options& options_;
   Cache* cache_;
+  // JH: PmemIterator handles live in their own cache so that hot PMEM
+  // iterators are not evicted by SST table churn (and vice versa).
+  Cache* pmem_cache_;
 
   Status FindTable(uint64_t file_number, uint64_t file_size, Cache::Handle**);
   // JH 
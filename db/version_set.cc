@@ -17,6 +17,8 @@
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
 #include "util/logging.h"
+#include "util/perf_context_imp.h"
+#include "util/trace_imp.h"
 
 namespace leveldb {
 
@@ -81,6 +83,10 @@ Version::~Version() {
       }
     }
   }
+
+  for (size_t i = 0; i < tier_partitions_.size(); i++) {
+    delete tier_partitions_[i];
+  }
 }
 
 int FindFile(const InternalKeyComparator& icmp,
@@ -155,28 +161,78 @@ bool SomeFileOverlapsRange(
   return !BeforeFile(ucmp, largest_user_key, files[index]);
 }
 
+// Narrow [*begin, *end) to the files of a sorted, disjoint level that
+// may hold keys inside options.iterate_lower_bound/iterate_upper_bound.
+// The bounds are internal keys here (see DBImpl::NewInternalIterator).
+static void FindFilesInBounds(const InternalKeyComparator& icmp,
+                              const std::vector<FileMetaData*>& files,
+                              const ReadOptions& options,
+                              uint32_t* begin, uint32_t* end) {
+  *begin = 0;
+  *end = files.size();
+  if (options.iterate_lower_bound != nullptr) {
+    *begin = FindFile(icmp, files, *options.iterate_lower_bound);
+  }
+  if (options.iterate_upper_bound != nullptr) {
+    uint32_t index = FindFile(icmp, files, *options.iterate_upper_bound);
+    // files[index] ends at or after the bound but may start before it
+    if (index < files.size() &&
+        icmp.Compare(files[index]->smallest.Encode(),
+                     *options.iterate_upper_bound) < 0) {
+      index++;
+    }
+    *end = index;
+  }
+  if (*end < *begin) {
+    *end = *begin;
+  }
+}
+
+// Returns true iff *f may hold keys inside the iterate bounds of "options".
+static bool FileInBounds(const InternalKeyComparator& icmp,
+                         const FileMetaData* f,
+                         const ReadOptions& options) {
+  if (options.iterate_lower_bound != nullptr &&
+      icmp.Compare(f->largest.Encode(), *options.iterate_lower_bound) < 0) {
+    return false;
+  }
+  if (options.iterate_upper_bound != nullptr &&
+      icmp.Compare(f->smallest.Encode(), *options.iterate_upper_bound) >= 0) {
+    return false;
+  }
+  return true;
+}
+
 // An internal iterator.  For a given version/level pair, yields
 // information about the files in the level.  For a given entry, key()
 // is the largest key that occurs in the file, and value() is an
 // 16-byte value containing the file number and file size, both
-// encoded using EncodeFixed64.
+// encoded using EncodeFixed64.  Files outside the iterate bounds of
+// "options" are never yielded.
 class Version::LevelFileNumIterator : public Iterator {
  public:
   LevelFileNumIterator(const InternalKeyComparator& icmp,
-                       const std::vector<FileMetaData*>* flist)
+                       const std::vector<FileMetaData*>* flist,
+                       const ReadOptions& options)
       : icmp_(icmp),
-        flist_(flist),
-        index_(flist->size()) {        // Marks as invalid
+        flist_(flist) {
+    FindFilesInBounds(icmp, *flist, options, &begin_, &end_);
+    index_ = end_;  // Marks as invalid
   }
   virtual bool Valid() const {
-    return index_ < flist_->size();
+    return index_ < end_;
   }
   virtual void Seek(const Slice& target) {
     index_ = FindFile(icmp_, *flist_, target);
+    if (index_ < begin_) {
+      index_ = begin_;
+    } else if (index_ > end_) {
+      index_ = end_;
+    }
   }
-  virtual void SeekToFirst() { index_ = 0; }
+  virtual void SeekToFirst() { index_ = begin_; }
   virtual void SeekToLast() {
-    index_ = flist_->empty() ? 0 : flist_->size() - 1;
+    index_ = (end_ == begin_) ? end_ : end_ - 1;
   }
   virtual void Next() {
     assert(Valid());
@@ -184,8 +240,8 @@ class Version::LevelFileNumIterator : public Iterator {
   }
   virtual void Prev() {
     assert(Valid());
-    if (index_ == 0) {
-      index_ = flist_->size();  // Marks as invalid
+    if (index_ == begin_) {
+      index_ = end_;  // Marks as invalid
     } else {
       index_--;
     }
@@ -204,83 +260,93 @@ class Version::LevelFileNumIterator : public Iterator {
  private:
   const InternalKeyComparator icmp_;
   const std::vector<FileMetaData*>* const flist_;
+  uint32_t begin_;  // First file inside the iterate bounds
+  uint32_t end_;    // One past the last file inside the iterate bounds
   uint32_t index_;
 
   // Backing store for value().  Holds the file number and size.
   mutable char value_buf_[16];
 };
 // SOLVE: Copied from LevelFileNumIterator
+// Two-level iterator over the pmem files of a level: the file list is the
+// index, and a PmemIterator is only opened for the file it is positioned
+// on.  PmemIterators are reused through a small pool holding at most one
+// iterator per skiplist manager.
 class Version::LevelFilesConcatIteratorFromPmem : public Iterator {
  public:
   LevelFilesConcatIteratorFromPmem(
                        const InternalKeyComparator& icmp,
                        PmemSkiplist **pmem_skiplist,
-                       const std::vector<FileMetaData*>* flist)
-      : icmp_(icmp), flist_(flist), size_(flist->size()), current_(nullptr)
-        {
-
-    pmem_iterator = new PmemIterator*[size_];
-    // Make PmemIterators based on each index
-    // printf("LevelFiles size %d\n", size_);
-    for (int i=0; i<size_; i++) {
-      uint64_t file_number = flist_->at(i)->number;
-      // printf("LevelFiles %d\n", file_number);
-      pmem_iterator[i] = new PmemIterator(file_number, 
-                                          pmem_skiplist[file_number % NUM_OF_SKIPLIST_MANAGER]); 
-      // printf("LevelFiles End\n");
+                       const std::vector<FileMetaData*>* flist,
+                       const ReadOptions& options)
+      : icmp_(icmp), pmem_skiplist_(pmem_skiplist), flist_(flist),
+        lower_bound_(options.iterate_lower_bound),
+        upper_bound_(options.iterate_upper_bound),
+        current_(nullptr) {
+    // Only the files overlapping the iterate bounds are ever opened
+    FindFilesInBounds(icmp, *flist, options, &begin_, &end_);
+    current_index_ = end_;
+    for (int i = 0; i < NUM_OF_SKIPLIST_MANAGER; i++) {
+      iter_pool_[i] = nullptr;
     }
   }
   ~LevelFilesConcatIteratorFromPmem() {
-    for (int i=0; i<size_; i++) {
-      uint64_t file_number = flist_->at(i)->number;
-      // printf("Destructor LevelFiles %d\n", file_number);
-      delete pmem_iterator[i];
+    for (int i = 0; i < NUM_OF_SKIPLIST_MANAGER; i++) {
+      delete iter_pool_[i];
     }
-    delete[] pmem_iterator;
   }
   virtual bool Valid() const {
     return (current_ != nullptr && current_->Valid());
   }
   virtual void Seek(const Slice& target) {
-    // printf("LevelFilesConcatIterator Start\n");
-    // Specific searching
-    assert(Valid());
-    // Copy from FindFile() in version_set.cc
-    uint32_t left = 0;
-    uint32_t right = flist_->size();
-    while (left < right) {
-      uint32_t mid = (left + right) / 2;
-      // printf("LevelFilesConcatIterator right %d mid %d\n", right, mid);
-      const FileMetaData* f = flist_->at(mid);
-      // printf("LevelFilesConcatIterator at '%s'\n", f->largest.Encode().data());
-      if (icmp_.InternalKeyComparator::Compare(f->largest.Encode(), target) < 0) {
-        // Key at "mid.largest" is < "target".  Therefore all
-        // files at or before "mid" are uninteresting.
-        left = mid + 1;
-      } else {
-        // Key at "mid.largest" is >= "target".  Therefore all files
-        // after "mid" are uninteresting.
-        right = mid;
-      }
+    Slice key = target;
+    if (lower_bound_ != nullptr && icmp_.Compare(key, *lower_bound_) < 0) {
+      key = *lower_bound_;
+    }
+    // First file whose largest key is >= key
+    uint32_t index = FindFile(icmp_, *flist_, key);
+    if (index < begin_) {
+      index = begin_;
     }
-    // printf("LevelFilesConcatIterator size %d\n", right);
-    // printf("LevelFilesConcatIterator 2\n");
-    current_index_ = right;
-    current_ = pmem_iterator[current_index_];
-    // printf("LevelFilesConcatIterator index %d\n", current_->GetIndex());
-    current_->Seek(target);
-    // printf("LevelFilesConcatIterator End\n");
+    if (index >= end_) {
+      current_ = nullptr;
+      return;
+    }
+    OpenFile(index);
+    current_->Seek(key);
+    CheckUpperBound();
   }
   virtual void SeekToFirst() {
-    current_index_ = 0;
-    current_ = pmem_iterator[current_index_];
+    if (lower_bound_ != nullptr) {
+      Seek(*lower_bound_);
+      return;
+    }
+    if (begin_ == end_) {
+      current_ = nullptr;
+      return;
+    }
+    OpenFile(begin_);
     current_->SeekToFirst();
+    CheckUpperBound();
   }
   virtual void SeekToLast() {
-    // printf("version_set:seek to last\n");
-    current_index_ = size_-1;
-    current_ = pmem_iterator[current_index_];
-    current_->SeekToLast();
+    if (begin_ == end_) {
+      current_ = nullptr;
+      return;
+    }
+    OpenFile(end_ - 1);
+    if (upper_bound_ != nullptr) {
+      // Step back from the first entry at or past the upper bound
+      current_->Seek(*upper_bound_);
+      if (current_->Valid()) {
+        current_->Prev();
+      } else {
+        current_->SeekToLast();
+      }
+    } else {
+      current_->SeekToLast();
+    }
+    CheckLowerBound();
   }
   virtual void Next() {
     assert(Valid());
@@ -288,32 +354,25 @@ class Version::LevelFilesConcatIteratorFromPmem : public Iterator {
     // else, point to next iterator
     current_->Next();
     if (!current_->Valid()) {
-      if (!(current_index_ == size_-1)) {
-        current_index_ += 1;
-        current_ = pmem_iterator[current_index_];
+      if (current_index_ + 1 < end_) {
+        OpenFile(current_index_ + 1);
         current_->SeekToFirst();
       }
     }
+    CheckUpperBound();
   }
   virtual void Prev() {
     assert(Valid());
     // if Prev is not null, just run Prev()
     // else, point to previous iterator
-    //printf("version_set->prev\n");
-
     current_->Prev();
-    //printf("p1");
-
     if (!current_->Valid()) {
-      //printf("p2");
-      if (!(current_index_ == 0)) {
-	//printf("p3");
-        current_index_ -= 1;
-        current_ = pmem_iterator[current_index_];
+      if (current_index_ > begin_) {
+        OpenFile(current_index_ - 1);
         current_->SeekToLast();
       }
     }
-    //printf("p4");   
+    CheckLowerBound();
   }
  
  
@@ -342,12 +401,48 @@ class Version::LevelFilesConcatIteratorFromPmem : public Iterator {
     return current_->buffer_ptr();
   }
  private:
+  // Point current_ at (*flist_)[index].  The pooled PmemIterator of the
+  // file's skiplist manager is re-targeted instead of allocating a new one.
+  void OpenFile(uint32_t index) {
+    assert(index >= begin_ && index < end_);
+    uint64_t file_number = flist_->at(index)->number;
+    int slot = file_number % NUM_OF_SKIPLIST_MANAGER;
+    PmemIterator* iter = iter_pool_[slot];
+    if (iter == nullptr) {
+      iter = new PmemIterator(file_number, pmem_skiplist_[slot]);
+      iter_pool_[slot] = iter;
+    } else if (static_cast<uint64_t>(iter->GetIndex()) != file_number) {
+      iter->UnRef(iter->GetIndex());
+      iter->SetIndex(file_number);
+      iter->Ref(file_number);
+    }
+    current_index_ = index;
+    current_ = iter;
+  }
+  // Stop once the current file walks past one of the iterate bounds
+  void CheckUpperBound() {
+    if (upper_bound_ != nullptr && Valid() &&
+        icmp_.Compare(current_->key(), *upper_bound_) >= 0) {
+      current_ = nullptr;
+    }
+  }
+  void CheckLowerBound() {
+    if (lower_bound_ != nullptr && Valid() &&
+        icmp_.Compare(current_->key(), *lower_bound_) < 0) {
+      current_ = nullptr;
+    }
+  }
+
   InternalKeyComparator icmp_;
-  PmemIterator **pmem_iterator;
+  PmemSkiplist** const pmem_skiplist_;
   const std::vector<FileMetaData*>* const flist_;
-  PmemIterator* current_;
-  uint8_t size_;
-  uint8_t current_index_;
+  const Slice* const lower_bound_;  // May be nullptr
+  const Slice* const upper_bound_;  // May be nullptr
+  PmemIterator* current_;           // Points into iter_pool_, or nullptr
+  PmemIterator* iter_pool_[NUM_OF_SKIPLIST_MANAGER];
+  uint32_t begin_;  // First file inside the iterate bounds
+  uint32_t end_;    // One past the last file inside the iterate bounds
+  uint32_t current_index_;
 
 };
 
@@ -364,12 +459,54 @@ static Iterator* GetFileIterator(void* arg,
                               DecodeFixed64(file_value.data() + 8));
   }
 }
+// Like GetFileIterator, for the files of a compaction input
+static Iterator* GetCompactionFileIterator(void* arg,
+                                           const ReadOptions& options,
+                                           const Slice& file_value) {
+  TableCache* cache = reinterpret_cast<TableCache*>(arg);
+  if (file_value.size() != 16) {
+    return NewErrorIterator(
+        Status::Corruption("FileReader invoked with unexpected value"));
+  } else {
+    return cache->NewIterator(options,
+                              DecodeFixed64(file_value.data()),
+                              DecodeFixed64(file_value.data() + 8),
+                              nullptr, true);
+  }
+}
 /* TODO: Iterator based on pmem */
 Iterator* Version::NewConcatenatingIterator(const ReadOptions& options,
                                             int level) const {
   return NewTwoLevelIterator(
-      new LevelFileNumIterator(vset_->icmp_, &files_[level]),
-      &GetFileIterator, vset_->table_cache_, options);
+      new LevelFileNumIterator(vset_->icmp_, &files_[level], options),
+      &GetFileIterator, vset_->table_cache_, options, &vset_->icmp_);
+}
+
+const Version::TierPartition* Version::GetTierPartition(
+    Tiering_stats* tiering_stats) {
+  const uint64_t generation = tiering_stats->Generation();
+  if (!tier_partitions_.empty() &&
+      tier_partitions_.back()->generation == generation) {
+    return tier_partitions_.back();
+  }
+
+  TierPartition* partition = new TierPartition;
+  partition->generation = generation;
+  for (int level = 0; level < config::kNumLevels; level++) {
+    for (size_t i = 0; i < files_[level].size(); i++) {
+      FileMetaData* f = files_[level][i];
+      if (tiering_stats->IsInFileSet(f->number)) {
+        partition->file_set[level].push_back(f);
+      } else if (tiering_stats->IsInSkiplistSet(f->number)) {
+        partition->skiplist_set[level].push_back(f);
+      } else {
+        // WARN
+        printf("[WARN][Version][GetTierPartition][L%d] number '%d' is not in both fileset and skiplistset\n", level, f->number);
+      }
+    }
+  }
+  tier_partitions_.push_back(partition);
+  return partition;
 }
 
 // Customized by JH
@@ -377,85 +514,44 @@ Iterator* Version::NewConcatenatingIterator(const ReadOptions& options,
 // PROGRESS:
 void Version::AddIterators(const ReadOptions& options,
                            std::vector<Iterator*>* iters,
-                           Tiering_stats* tiering_stats,
-                           std::vector<FileMetaData *>* fileSet,
-                           std::vector<FileMetaData *>* skiplistSet,
-                           bool &preserve_flag) {
-
-  //printf("AddIterators\n"); 
-  // Initialize fileSet and skiplistSet
-  if (!preserve_flag) {
-    for (int level = 1; level < config::kNumLevels; level++) {
-      fileSet[level].clear();
-      skiplistSet[level].clear();
-    }  
-  }
+                           Tiering_stats* tiering_stats) {
+  const TierPartition* partition = GetTierPartition(tiering_stats);
 
   // Level 0
-  // printf("Level 0\n");
-  // printf("level 0 size: %d \n", files_[0].size());
-
-  for (size_t i = 0; i < files_[0].size(); i++) {
-    uint64_t number = files_[0][i]->number;
-    if (tiering_stats->IsInFileSet(number)) {
-       //printf("level0-file '%d'\n ", number);
+  for (size_t i = 0; i < partition->file_set[0].size(); i++) {
+    const FileMetaData* f = partition->file_set[0][i];
+    if (FileInBounds(vset_->icmp_, f, options)) {
       iters->push_back(
           vset_->table_cache_->NewIterator(
-              options, number, files_[0][i]->file_size));
-    } else if (tiering_stats->IsInSkiplistSet(number)) {
-       //printf("level0-skiplist '%d'\n ", number);
+              options, f->number, f->file_size));
+    }
+  }
+  for (size_t i = 0; i < partition->skiplist_set[0].size(); i++) {
+    const FileMetaData* f = partition->skiplist_set[0][i];
+    if (FileInBounds(vset_->icmp_, f, options)) {
       iters->push_back(
           vset_->table_cache_->NewIteratorFromPmem(
-              options, number, files_[0][i]->file_size));
-    } else {
-      // WARN
-      printf("[WARN][Version][AddIterators][L0] number '%d' is not in both fileset and skiplistset\n", number);
+              options, f->number, f->file_size));
     }
   }
 
   // Levels > 0
   for (int level = 1; level < config::kNumLevels; level++) {
-    if (!files_[level].empty()) {
-      //printf("Level %d\n", level);
-      for (int i=0; i < files_[level].size(); i++) {
-        uint64_t number = files_[level][i]->number;
-        if (tiering_stats->IsInFileSet(number)) {
-          if (!preserve_flag) {
-            fileSet[level].push_back(files_[level][i]);
-            //printf("file '%d'\n ", number);
-          }
-        } else if (tiering_stats->IsInSkiplistSet(number)) {
-          //printf("skiplist '%d'\n ", number);
-          if (!preserve_flag) {
-            skiplistSet[level].push_back(files_[level][i]);
-          }
-        } else {
-          // WARN
-          printf("[WARN][Version][AddIterators][L%d] number '%d' is not in both fileset and skiplistset\n", level, number);
-        }
-      }
-      // printf("\n");
-      // printf("file size '%d' \n", fileSet[level].size());
-      if (fileSet[level].size() > 0) {
-       // printf("file size '%d' \n", fileSet[level].size());
-        iters->push_back(NewTwoLevelIterator(
-          new Version::LevelFileNumIterator(vset_->icmp_, &fileSet[level]),
-          &GetFileIterator, vset_->table_cache_, options));
-      } 
-
-      // printf("skiplist size '%d' \n", skiplistSet[level].size());
-      if (skiplistSet[level].size() > 0) {
-        //printf("skiplist size '%d' \n", skiplistSet[level].size());
-        iters->push_back(new Version::LevelFilesConcatIteratorFromPmem(
-            vset_->icmp_, 
-            vset_->options_->pmem_skiplist,
-            &skiplistSet[level]));
-
-      }
+    if (!partition->file_set[level].empty()) {
+      iters->push_back(NewTwoLevelIterator(
+        new Version::LevelFileNumIterator(vset_->icmp_,
+                                          &partition->file_set[level],
+                                          options),
+        &GetFileIterator, vset_->table_cache_, options, &vset_->icmp_));
+    }
+    if (!partition->skiplist_set[level].empty()) {
+      iters->push_back(new Version::LevelFilesConcatIteratorFromPmem(
+          vset_->icmp_, 
+          vset_->options_->pmem_skiplist,
+          &partition->skiplist_set[level],
+          options));
     }
   }
-  if (!preserve_flag) 
-    preserve_flag = true;  
 }
 
 // Callback from TableCache::Get()
@@ -471,6 +567,7 @@ struct Saver {
   const Comparator* ucmp;
   Slice user_key;
   std::string* value;
+  SequenceNumber sequence;  // Sequence of the entry found, if any
 };
 }
 static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
@@ -481,6 +578,7 @@ static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
   } else {
     if (s->ucmp->Compare(parsed_key.user_key, s->user_key) == 0) {
       s->state = (parsed_key.type == kTypeValue) ? kFound : kDeleted;
+      s->sequence = parsed_key.sequence;
       if (s->state == kFound) {
         s->value->assign(v.data(), v.size());
       }
@@ -488,6 +586,53 @@ static void SaveValue(void* arg, const Slice& ikey, const Slice& v) {
   }
 }
 
+// JH: DRAM row cache in front of pmem tables.  An entry is encoded as
+//    fixed64 file_number | fixed64 (sequence << 8 | type) | value
+// and always holds the newest entry for its user key inside that table, so
+// it is valid for any read that reaches the same table with a snapshot at
+// or above its sequence.  Table numbers are never reused, which makes
+// entries of deleted tables dead without an explicit erase.
+static void DeletePmemRowEntry(const Slice& key, void* value) {
+  delete reinterpret_cast<std::string*>(value);
+}
+
+static bool LookupPmemRowCache(Cache* row_cache, uint64_t file_number,
+                               SequenceNumber snapshot, Saver* saver) {
+  Cache::Handle* handle = row_cache->Lookup(saver->user_key);
+  if (handle == nullptr) {
+    return false;
+  }
+  const std::string* entry =
+      reinterpret_cast<std::string*>(row_cache->Value(handle));
+  const uint64_t tag = DecodeFixed64(entry->data() + 8);
+  const bool hit = DecodeFixed64(entry->data()) == file_number &&
+                   (tag >> 8) <= snapshot;
+  if (hit) {
+    saver->sequence = tag >> 8;
+    if (static_cast<ValueType>(tag & 0xff) == kTypeValue) {
+      saver->state = kFound;
+      saver->value->assign(entry->data() + 16, entry->size() - 16);
+    } else {
+      saver->state = kDeleted;
+    }
+  }
+  row_cache->Release(handle);
+  return hit;
+}
+
+static void InsertPmemRowCache(Cache* row_cache, uint64_t file_number,
+                               const Saver& saver) {
+  std::string* entry = new std::string;
+  PutFixed64(entry, file_number);
+  PutFixed64(entry, (saver.sequence << 8) |
+                        (saver.state == kFound ? kTypeValue : kTypeDeletion));
+  if (saver.state == kFound) {
+    entry->append(*saver.value);
+  }
+  row_cache->Release(row_cache->Insert(saver.user_key, entry, entry->size(),
+                                       &DeletePmemRowEntry));
+}
+
 static bool NewestFirst(FileMetaData* a, FileMetaData* b) {
   return a->number > b->number;
 }
@@ -545,11 +690,15 @@ Status Version::Get(const Options& options_,
                     Tiering_stats* tiering_stats) {
   Slice ikey = k.internal_key();
   Slice user_key = k.user_key();
+  const SequenceNumber snapshot =
+      DecodeFixed64(ikey.data() + ikey.size() - 8) >> 8;
   const Comparator* ucmp = vset_->icmp_.user_comparator();
   Status s;
 
   stats->seek_file = nullptr;
   stats->seek_file_level = -1;
+  stats->hit_level = -1;
+  stats->hit_in_pmem = false;
   FileMetaData* last_file_read = nullptr;
   int last_file_read_level = -1;
 
@@ -581,6 +730,17 @@ Status Version::Get(const Options& options_,
       std::sort(tmp.begin(), tmp.end(), NewestFirst);
       files = &tmp[0];
       num_files = tmp.size();
+      // Overlapping level-0 SSTs are probed one after another; put all of
+      // their candidate block reads in flight first so the probes do not
+      // each wait for a full device round trip.
+      if (num_files > 1) {
+        for (uint32_t i = 0; i < num_files; i++) {
+          if (tiering_stats->IsInFileSet(files[i]->number)) {
+            vset_->table_cache_->Prefetch(files[i]->number,
+                                          files[i]->file_size, ikey);
+          }
+        }
+      }
     } 
         /*--------------------------------------*/
     // zewei coldfind
@@ -692,25 +852,47 @@ Status Version::Get(const Options& options_,
       saver.ucmp = ucmp;
       saver.user_key = user_key;
       saver.value = value;
+      saver.sequence = 0;
       /*
        * SOLVE: Get operation 
        */
       PmemSkiplist* pmem_skiplist = options_.pmem_skiplist[f->number % NUM_OF_SKIPLIST_MANAGER];
-      if (tiering_stats->IsInFileSet(f->number)) {
+      PERF_TIMER_GUARD(tiering_lookup_nanos);
+      const bool in_file_set = tiering_stats->IsInFileSet(f->number);
+      const bool in_pmem = !in_file_set &&
+                           tiering_stats->IsInSkiplistSet(f->number) &&
+                           pmem_skiplist->CheckNumberIsInPmem(f->number);
+      PERF_TIMER_STOP(tiering_lookup_nanos);
+      if (in_file_set) {
         dup_candidate_number_iter = dup_candidate_number.find(f->number);
         if (dup_candidate_number_iter == dup_candidate_number.end()) {
           // printf("Get\n");
+          PERF_COUNTER_ADD(sst_probe_count, 1);
           s = vset_->table_cache_->Get(options, f->number, f->file_size,
                                       ikey, &saver, SaveValue);
           dup_candidate_number.insert(f->number);
         }
-      } else if ( tiering_stats->IsInSkiplistSet(f->number) &&
-          pmem_skiplist->CheckNumberIsInPmem(f->number) ) {
+      } else if (in_pmem) {
         dup_candidate_number_iter = dup_candidate_number.find(f->number);
         if (dup_candidate_number_iter == dup_candidate_number.end()) {
           // printf("GetFromPmem %d", f->number);
-          s = vset_->table_cache_->GetFromPmem(options_, f->number,
-                                    ikey, &saver, SaveValue);
+          PERF_COUNTER_ADD(pmem_probe_count, 1);
+          Cache* row_cache = options_.pmem_row_cache;
+          if (row_cache != nullptr &&
+              LookupPmemRowCache(row_cache, f->number, snapshot, &saver)) {
+            PERF_COUNTER_ADD(pmem_row_cache_hit_count, 1);
+          } else {
+            s = vset_->table_cache_->GetFromPmem(options_,
+                                      options.verify_checksums, f->number,
+                                      ikey, &saver, SaveValue);
+            // Only a read at the latest sequence is guaranteed to have
+            // found the newest entry of this table.
+            if (s.ok() && row_cache != nullptr &&
+                options.snapshot == nullptr &&
+                (saver.state == kFound || saver.state == kDeleted)) {
+              InsertPmemRowCache(row_cache, f->number, saver);
+            }
+          }
           // printf(" end\n");
           dup_candidate_number.insert(f->number);
         }
@@ -727,6 +909,10 @@ Status Version::Get(const Options& options_,
       if (!s.ok()) {
         return s;
       }
+      if (saver.state == kFound || saver.state == kDeleted) {
+        stats->hit_level = level;
+        stats->hit_in_pmem = !in_file_set;
+      }
       switch (saver.state) {
         case kNotFound:
           break;      // NOTE: Keep searching in other files
@@ -1138,6 +1324,7 @@ void VersionSet::AppendVersion(Version* v) {
 }
 
 Status VersionSet::LogAndApply(VersionEdit* edit, port::Mutex* mu) {
+  TRACE_SPAN("version.install");
   if (edit->has_log_number_) {
     assert(edit->log_number_ >= log_number_);
     assert(edit->log_number_ < next_file_number_);
@@ -1525,6 +1712,23 @@ int64_t VersionSet::NumLevelBytes(int level) const {
   return TotalFileSize(current_->files_[level]);
 }
 
+void VersionSet::NumLevelBytesByTier(int level, Tiering_stats* tiering_stats,
+                                     int64_t* pmem_bytes,
+                                     int64_t* sst_bytes) const {
+  assert(level >= 0);
+  assert(level < config::kNumLevels);
+  *pmem_bytes = 0;
+  *sst_bytes = 0;
+  const std::vector<FileMetaData*>& files = current_->files_[level];
+  for (size_t i = 0; i < files.size(); i++) {
+    if (tiering_stats->IsInFileSet(files[i]->number)) {
+      *sst_bytes += files[i]->file_size;
+    } else {
+      *pmem_bytes += files[i]->file_size;
+    }
+  }
+}
+
 int64_t VersionSet::MaxNextLevelOverlappingBytes() {
   int64_t result = 0;
   std::vector<FileMetaData*> overlaps;
@@ -1607,7 +1811,8 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c, Tiering_stats* tiering_st
           PmemSkiplist* pmem_skiplist = options_->pmem_skiplist[number % NUM_OF_SKIPLIST_MANAGER];
           if (tiering_stats->IsInFileSet(number)) {
             list[num++] = table_cache_->NewIterator(
-                options, files[i]->number, files[i]->file_size);
+                options, files[i]->number, files[i]->file_size, nullptr,
+                true);
           } else if ( tiering_stats->IsInSkiplistSet(number) &&
               pmem_skiplist->CheckNumberIsInPmem(number) ) {
             list[num++] = table_cache_->NewIteratorFromPmem(
@@ -1622,12 +1827,14 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c, Tiering_stats* tiering_st
         // printf("If\n");
         if (c->inputs_in_fileset_[which].size() != 0) {
           list[num++] = NewTwoLevelIterator(
-              new Version::LevelFileNumIterator(icmp_, &c->inputs_in_fileset_[which]),
-              &GetFileIterator, table_cache_, options);
+              new Version::LevelFileNumIterator(icmp_, &c->inputs_in_fileset_[which],
+                                                options),
+              &GetCompactionFileIterator, table_cache_, options, &icmp_);
         }
         if (c->inputs_in_skiplistset_[which].size() != 0) {
           list[num++] = new Version::LevelFilesConcatIteratorFromPmem(
-                          icmp_, options_->pmem_skiplist, &c->inputs_in_skiplistset_[which]);
+                          icmp_, options_->pmem_skiplist, &c->inputs_in_skiplistset_[which],
+                          options);
         }
         // printf("FI\n");
       }
@@ -60,12 +60,9 @@ class Version {
   // Append to *iters a sequence of iterators that will
   // yield the contents of this Version when merged together.
   // REQUIRES: This version has been saved (see VersionSet::SaveTo)
+  // REQUIRES: lock is held
   void AddIterators(const ReadOptions&, std::vector<Iterator*>* iters, 
-                    Tiering_stats* tiering_stats,
-                    std::vector<FileMetaData *>* fileSet,
-                    std::vector<FileMetaData *>* skiplistSet,
-                    bool &preserve_flag
-                    );
+                    Tiering_stats* tiering_stats);
 
   // Lookup the value for key.  If found, store it in *val and
   // return OK.  Else return a non-OK status.  Fills *stats.
@@ -73,6 +70,9 @@ class Version {
   struct GetStats {
     FileMetaData* seek_file;
     int seek_file_level;
+    // Table that resolved the lookup (found or deleted), if any
+    int hit_level;               // -1 if no table held the key
+    bool hit_in_pmem;
   };
   // Customized by JH
   // Status Get(const ReadOptions&, const LookupKey& key, std::string* val,
@@ -137,6 +137,19 @@ class Version {
   // JH
   class LevelFilesConcatIteratorFromPmem;
 
+  // The files of each level split by the tier that holds them, as seen
+  // by Tiering_stats at "generation".
+  struct TierPartition {
+    uint64_t generation;
+    std::vector<FileMetaData*> file_set[config::kNumLevels];
+    std::vector<FileMetaData*> skiplist_set[config::kNumLevels];
+  };
+
+  // Return the tier partition of this version, computing it on first use
+  // and again whenever a file has moved between tiers since.
+  // REQUIRES: lock is held
+  const TierPartition* GetTierPartition(Tiering_stats* tiering_stats);
+
   Iterator* NewConcatenatingIterator(const ReadOptions&, int level) const;
 
   // Call func(arg, level, f) for every file that overlaps user_key in
@@ -156,6 +169,11 @@ class Version {
   // List of files per level
   std::vector<FileMetaData*> files_[config::kNumLevels];
 
+  // Tier partitions of files_; the last one is current.  Superseded
+  // partitions are kept until the version dies since iterators created
+  // from them may still point into their file lists.
+  std::vector<TierPartition*> tier_partitions_;
+
   // Next file to compact based on seek stats.
   FileMetaData* file_to_compact_;
   int file_to_compact_level_;
@@ -224,6 +242,13 @@ class VersionSet {
   // Return the combined file size of all files at the specified level.
   int64_t NumLevelBytes(int level) const;
 
+  // JH
+  // Split NumLevelBytes(level) by the tier that holds each file: tables in
+  // the PMEM skiplist pools are charged their recorded file size, like
+  // everywhere else in the version.
+  void NumLevelBytesByTier(int level, Tiering_stats* tiering_stats,
+                           int64_t* pmem_bytes, int64_t* sst_bytes) const;
+
   // Return the last sequence number.
   uint64_t LastSequence() const { return last_sequence_; }
 
@@ -27,7 +27,9 @@ namespace leveldb {
 class LEVELDB_EXPORT Cache;
 
 // Create a new cache with a fixed size capacity.  This implementation
-// of Cache uses a least-recently-used eviction policy.
+// of Cache uses a segmented least-recently-used eviction policy: entries
+// that are looked up again after insertion are protected from entries
+// that are only inserted once, e.g. by a sequential scan.
 LEVELDB_EXPORT Cache* NewLRUCache(size_t capacity);
 
 class LEVELDB_EXPORT Cache {
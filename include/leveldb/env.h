@@ -91,6 +91,16 @@ class LEVELDB_EXPORT Env {
   virtual Status NewAppendableFile(const std::string& fname,
                                    WritableFile** result);
 
+  // Like NewWritableFile(), but the returned file bypasses the OS page
+  // cache where the platform supports it (e.g. O_DIRECT).  Intended for
+  // large, write-once files such as table files produced by compactions,
+  // whose contents are not read back soon.  Data appended since the last
+  // Sync() or Close() may not be visible to readers of the file.
+  //
+  // The default implementation returns NewWritableFile(fname, result).
+  virtual Status NewDirectWritableFile(const std::string& fname,
+                                       WritableFile** result);
+
   // Returns true iff the named file exists.
   virtual bool FileExists(const std::string& fname) = 0;
 
@@ -219,6 +229,14 @@ class LEVELDB_EXPORT RandomAccessFile {
   // Safe for concurrent use by multiple threads.
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
                       char* scratch) const = 0;
+
+  // Hint that "[offset, offset+n)" is about to be read.  Implementations
+  // may start fetching it asynchronously, so that several such hints put
+  // more than one read in flight before the blocking Read() calls that
+  // follow.  The default implementation does nothing.
+  //
+  // Safe for concurrent use by multiple threads.
+  virtual void Prefetch(uint64_t offset, size_t n) const { }
 };
 
 // A file abstraction for sequential writing.  The implementation
@@ -305,6 +323,10 @@ class LEVELDB_EXPORT EnvWrapper : public Env {
   Status NewAppendableFile(const std::string& f, WritableFile** r) override {
     return target_->NewAppendableFile(f, r);
   }
+  Status NewDirectWritableFile(const std::string& f,
+                               WritableFile** r) override {
+    return target_->NewDirectWritableFile(f, r);
+  }
   bool FileExists(const std::string& f) override {
     return target_->FileExists(f);
   }
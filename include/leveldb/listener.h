@@ -0,0 +1,85 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// An EventListener set in Options::listener is told when memtable flushes
+// and compactions start and finish, with the tables they read and wrote
+// in each tier and what the job cost.  The same events are also written
+// to Options::info_log as JSON lines:
+//
+//   EVENT {"event": "compaction_finished", "job": 12, ...}
+//
+// Callbacks run on the thread doing the work, without the DB mutex held.
+// They may read from the DB but must not write to it, since a write can
+// wait for the very job being reported; they delay that job (and any
+// writers waiting on it) for as long as they take.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_LISTENER_H_
+#define STORAGE_LEVELDB_INCLUDE_LISTENER_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "leveldb/export.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+struct JobFileInfo {
+  uint64_t number = 0;
+  int level = 0;
+  bool in_pmem = false;  // PMEM table rather than SST
+  bool hot = false;      // hot output of a hot/warm compaction
+  uint64_t size = 0;     // file size, or encoded size of a PMEM table
+};
+
+struct FlushJobInfo {
+  int job_id = 0;
+  uint64_t memtable_bytes = 0;  // approximate memory usage of the memtable
+  // Only set when finished:
+  JobFileInfo output;           // size 0 if nothing was written
+  uint64_t micros = 0;          // wall time
+  uint64_t cpu_micros = 0;      // CPU time of the flushing thread
+  Status status;
+};
+
+struct CompactionJobInfo {
+  int job_id = 0;
+  int level = 0;                // inputs come from level and level + 1
+  std::vector<JobFileInfo> inputs;
+  // Only set when finished:
+  std::vector<JobFileInfo> outputs;
+  uint64_t bytes_read = 0;
+  uint64_t bytes_written = 0;   // as in "leveldb.stats": PMEM outputs are
+                                // charged with the bytes streamed to the
+                                // pmem-buffer
+  uint64_t lru_flushed_bytes = 0;  // PMEM tables rewritten as SSTs by LRU
+                                   // tiering during the job
+  uint64_t input_entries = 0;
+  uint64_t dropped_entries = 0;    // overwritten or obsolete deletions
+  uint64_t hot_entries = 0;
+  uint64_t warm_entries = 0;
+  uint64_t micros = 0;        // wall time, less memtable flushes done inline
+  uint64_t cpu_micros = 0;    // CPU time of the compacting thread
+  uint64_t stall_micros = 0;  // writers stalled while the job ran
+  Status status;
+};
+
+class LEVELDB_EXPORT EventListener {
+ public:
+  EventListener() = default;
+
+  EventListener(const EventListener&) = delete;
+  EventListener& operator=(const EventListener&) = delete;
+
+  virtual ~EventListener();
+
+  virtual void OnFlushBegin(const FlushJobInfo& info) { }
+  virtual void OnFlushCompleted(const FlushJobInfo& info) { }
+  virtual void OnCompactionBegin(const CompactionJobInfo& info) { }
+  virtual void OnCompactionCompleted(const CompactionJobInfo& info) { }
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_LISTENER_H_
@@ -6,6 +6,8 @@
 #define STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
 
 #include <stddef.h>
+#include <string>
+#include <vector>
 #include "leveldb/export.h"
 // JH
 #include "pmem/pmem_skiplist.h"
@@ -19,9 +21,14 @@ namespace leveldb {
 class Cache;
 class Comparator;
 class Env;
+class EventListener;
 class FilterPolicy;
 class Logger;
+class PmemLog;
+class RateLimiter;
+class Slice;
 class Snapshot;
+class Statistics;
 
 // DB contents are stored in a set of blocks, each of which holds a
 // sequence of key,value pairs.  Each block may be compressed before
@@ -31,7 +38,9 @@ enum CompressionType {
   // NOTE: do not change the values of existing entries, as these are
   // part of the persistent format on disk.
   kNoCompression     = 0x0,
-  kSnappyCompression = 0x1
+  kSnappyCompression = 0x1,
+  kZstdCompression   = 0x2,
+  kLZ4Compression    = 0x3
 };
 
 // JH
@@ -173,6 +182,30 @@ struct LEVELDB_EXPORT Options {
   // efficiently detect that and will switch to uncompressed mode.
   CompressionType compression;
 
+  // If non-empty, overrides "compression" per level: tables written to
+  // level L use compression_per_level[L], or the last entry if L is past
+  // the end.  For example {kLZ4Compression, kLZ4Compression,
+  // kZstdCompression} keeps the hot levels 0 and 1 fast to decompress
+  // while cold levels are stored as compactly as possible.
+  //
+  // Default: empty
+  std::vector<CompressionType> compression_per_level;
+
+  // Compression level used by kZstdCompression, for table blocks and for
+  // pmem-buffer values (pmem_value_compression).
+  //
+  // Default: 1
+  int zstd_compression_level;
+
+  // If positive, each table written with kZstdCompression samples its
+  // first data blocks, trains a zstd dictionary of at most this many
+  // bytes from them and compresses the rest of its data blocks with it.
+  // The dictionary is stored in the table.  Helps most with small blocks
+  // of similar values.
+  //
+  // Default: 0 (no dictionary)
+  size_t zstd_max_dict_bytes;
+
   // EXPERIMENTAL: If true, append to existing MANIFEST and log files
   // when a database is opened.  This can significantly speed up open.
   //
@@ -195,8 +228,86 @@ struct LEVELDB_EXPORT Options {
   SSTMakerType sst_type;
   PmemDataStructrueType ds_type;
 
+  // If non-empty, the PMEM pools are opened or created in this directory
+  // (a DAX mount) under their usual file names instead of the paths
+  // compiled into pmem/layout.h.  Pool sizes are fixed by layout.h.
+  // Default: empty
+  std::string pmem_dir;
+
   bool skiplist_cache;
   bool use_pmem_buffer;
+
+  // If not kNoCompression, values written to the pmem buffer by PMEM table
+  // builders are compressed one record at a time with this algorithm when
+  // that saves at least 12.5%.  Records are self-describing, so tables
+  // with and without compressed values can be read and merged freely.
+  // Skiplist tables only; hashmap tables store values raw.
+  // Default: kNoCompression
+  CompressionType pmem_value_compression;
+
+  // Number of records between restart points for key prefix compression
+  // in the pmem buffer.  Records between restart points store only the
+  // suffix of their key that differs from the restart record's key, plus
+  // a back-pointer to it, so any key can be rebuilt from two records.
+  // Zero disables it.  Skiplist tables only.
+  //
+  // Default: 16
+  int pmem_key_restart_interval;
+
+  // If non-null, results found in PMEM tables are kept in this DRAM cache,
+  // keyed by user key, so that hot keys skip the PMEM skiplist descent.
+  // Entries are tagged with the PMEM table number and sequence they came
+  // from and are ignored once that table is gone or a read cannot see them.
+  // The cache is owned by the caller.
+  // Default: nullptr
+  Cache* pmem_row_cache;
+
+  // If true, the write-ahead log is kept in a ring of segments in the
+  // PMEM_LOG_PATH pool instead of in *.log files.  Appends use
+  // non-temporal stores and are durable once flushed, so WriteOptions::sync
+  // costs a persist barrier instead of an fsync.  The pool holds the logs
+  // of a single database.  A memtable's log must fit in one segment
+  // (LOG_SEGMENT_SIZE), so write_buffer_size is capped a little below it.
+  // The option may change between opens: *.log files and segments left
+  // by the other setting are replayed before the new logs are created.
+  // Default: false
+  bool use_pmem_log;
+  PmemLog* pmem_log;
+
+  // If true, memtable entries are written into an extent of
+  // pmem_memtable_buffer (MEMTABLE_BUFFER_PATH) instead of the DRAM arena.
+  // When the memtable is flushed to a PMEM table, the table's skiplist
+  // links those entries in place rather than copying them into pmem_buffer.
+  // An extent is reused once its memtable and every PMEM table linking it
+  // are gone; while the pool is full, new memtables fall back to DRAM
+  // (noted in the info log).
+  // Default: false
+  bool use_pmem_memtable;
+  PmemBuffer* pmem_memtable_buffer;
+
+  // If true, table files written by memtable flushes and compactions are
+  // opened with Env::NewDirectWritableFile() and bypass the page cache.
+  // Default: false
+  bool use_direct_io_for_flush_and_compaction;
+
+  // If non-null, table file writes of memtable flushes and compactions are
+  // charged to this limiter, so background writes to SSTs cannot saturate
+  // the device under foreground log writes.  The limiter is owned by the
+  // caller.  See NewRateLimiter() in leveldb/rate_limiter.h.
+  // Default: nullptr
+  RateLimiter* rate_limiter;
+
+  // If non-null, tickers and latency histograms about the memtable, PMEM
+  // and SST tiers are recorded here (see leveldb/statistics.h).  If null,
+  // the DB keeps tickers of its own and skips the histograms.  Owned by
+  // the caller.
+  // Default: nullptr
+  Statistics* statistics;
+
+  // If non-null, told when memtable flushes and compactions start and
+  // finish (see leveldb/listener.h).  Owned by the caller.
+  // Default: nullptr
+  EventListener* listener;
   
   /* Tiering */
   TieringOption tiering_option;
@@ -207,7 +318,8 @@ struct LEVELDB_EXPORT Options {
 // Options that control read operations
 struct LEVELDB_EXPORT ReadOptions {
   // If true, all data read from underlying storage will be
-  // verified against corresponding checksums.
+  // verified against corresponding checksums.  PMEM tables are checked a
+  // pmem-buffer chunk at a time, each chunk once per process.
   // Default: false
   bool verify_checksums;
 
@@ -223,10 +335,27 @@ struct LEVELDB_EXPORT ReadOptions {
   // Default: nullptr
   const Snapshot* snapshot;
 
+  // If non-null, iterators created with these options only return keys
+  // >= *iterate_lower_bound.  Child table and pmem iterators use the bound
+  // to avoid opening files and reading blocks that lie entirely below it.
+  // For DB::NewIterator() the bound is a user key; for Table::NewIterator()
+  // it is compared with the table's Options::comparator.  The pointed-to
+  // slice must outlive any iterator created with these options.
+  // Default: nullptr
+  const Slice* iterate_lower_bound;
+
+  // If non-null, iterators created with these options stop before the
+  // first key >= *iterate_upper_bound (i.e. the bound is exclusive).
+  // Same key space and lifetime rules as iterate_lower_bound.
+  // Default: nullptr
+  const Slice* iterate_upper_bound;
+
   ReadOptions()
       : verify_checksums(false),
         fill_cache(true),
-        snapshot(nullptr) {
+        snapshot(nullptr),
+        iterate_lower_bound(nullptr),
+        iterate_upper_bound(nullptr) {
   }
 };
 
@@ -0,0 +1,80 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// PerfContext breaks the latency of a single request down by where the
+// time went.  Each thread has its own context; enable it with
+// SetPerfLevel(), Reset() it before the request and read it after:
+//
+//   leveldb::SetPerfLevel(leveldb::kPerfEnableTime);
+//   leveldb::GetPerfContext()->Reset();
+//   db->Get(options, key, &value);
+//   ... leveldb::GetPerfContext()->ToString() ...
+//
+// With the default kPerfDisabled every measurement point costs one
+// thread-local load.  kPerfEnableCount only updates the counters;
+// kPerfEnableTime also reads the clock around each timed section.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
+#define STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
+
+#include <stdint.h>
+#include <string>
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+enum PerfLevel {
+  kPerfDisabled = 0,
+  kPerfEnableCount = 1,
+  kPerfEnableTime = 2
+};
+
+struct LEVELDB_EXPORT PerfContext {
+  // Zero every field.
+  void Reset();
+
+  // "name = value" for every non-zero field, comma separated.
+  std::string ToString() const;
+
+  // DBImpl::Get
+  uint64_t get_memtable_nanos;         // memtable and immutable memtable
+  uint64_t get_from_files_nanos;       // Version::Get, all of the below
+
+  // Version::Get
+  uint64_t tiering_lookup_nanos;       // is a table an SST or in PMEM
+  uint64_t sst_probe_count;            // SSTs searched
+  uint64_t pmem_probe_count;           // PMEM tables searched
+  uint64_t pmem_row_cache_hit_count;   // ... answered by the row cache
+
+  // TableCache::Get and GetFromPmem
+  uint64_t find_table_nanos;           // table cache lookup or table open
+  uint64_t pmem_seek_nanos;            // PMEM skiplist descent
+  uint64_t pmem_read_delay_nanos;      // emulated PMEM read latency
+  uint64_t pmem_read_delay_count;
+
+  // Table::InternalGet
+  uint64_t index_seek_nanos;           // index block seek
+  uint64_t filter_nanos;               // bloom filter check
+  uint64_t block_read_nanos;           // reading data blocks from files
+  uint64_t block_read_count;
+  uint64_t block_read_bytes;
+  uint64_t block_cache_hit_count;
+  uint64_t block_cache_miss_count;
+
+  // DBIter
+  uint64_t iter_seek_nanos;            // positioning the internal iterator
+  uint64_t internal_key_skipped_count;     // overwritten entries passed
+  uint64_t internal_delete_skipped_count;  // deletion markers passed
+};
+
+// Set the perf level of the calling thread (default: kPerfDisabled).
+LEVELDB_EXPORT void SetPerfLevel(PerfLevel level);
+LEVELDB_EXPORT PerfLevel GetPerfLevel();
+
+// The calling thread's context.  Fields only ever grow until Reset().
+LEVELDB_EXPORT PerfContext* GetPerfContext();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_PERF_CONTEXT_H_
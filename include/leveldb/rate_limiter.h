@@ -0,0 +1,50 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A RateLimiter throttles background writes (table files produced by
+// memtable flushes and compactions) so that they do not starve foreground
+// log writes and syncs of device bandwidth.  It has internal
+// synchronization and may be shared by several DBs.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+#define STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Env;
+
+class LEVELDB_EXPORT RateLimiter {
+ public:
+  RateLimiter() = default;
+
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  virtual ~RateLimiter();
+
+  // Block until "bytes" may be written without exceeding the rate.
+  virtual void Request(size_t bytes) = 0;
+
+  // Return the configured rate in bytes per second.
+  virtual int64_t GetBytesPerSecond() const = 0;
+
+  // Return the total number of bytes granted so far.
+  virtual uint64_t GetTotalBytesThrough() const = 0;
+};
+
+// Create a token-bucket rate limiter that grants "bytes_per_second" bytes
+// per second, with bursts of up to a tenth of a second's worth.  Requests
+// larger than the bucket are granted and paid back by later requests.
+// Time is measured with env->NowMicros(); if "env" is nullptr,
+// Env::Default() is used.
+LEVELDB_EXPORT RateLimiter* NewRateLimiter(int64_t bytes_per_second,
+                                           Env* env = nullptr);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
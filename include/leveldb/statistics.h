@@ -0,0 +1,96 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Statistics collects counters ("tickers") and latency histograms about
+// where a DB's reads are served from and what its PMEM tier does.  Set
+// Options::statistics to an object returned by NewStatistics() to read them
+// directly (and to enable the latency histograms); otherwise the DB keeps
+// tickers of its own, readable through the "leveldb.pmem-stats" and
+// "leveldb.pmem-stats-json" properties.
+//
+// All methods are thread-safe and lock-free: recording is a relaxed atomic
+// add, so readers may see the tickers of a concurrent operation partially
+// updated.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
+#define STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
+
+#include <stdint.h>
+#include <string>
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+enum Ticker {
+  kMemtableHits = 0,       // Get() served by the (immutable) memtable
+  kGetMisses,              // Get() that found nothing
+  kPmemBytesRead,          // value bytes Get() returned from PMEM tables
+  kPmemBytesWritten,       // bytes tables and memtable extents wrote to PMEM
+  kCompactionHotEntries,   // entries compacted into hot PMEM tables
+  kCompactionWarmEntries,  // ... and into warm PMEM tables
+  kTieringMigratedTables,  // PMEM tables rewritten as SSTs by tiering
+  kTieringMigratedBytes,
+  kWriteStallMicros,       // time writers waited in MakeRoomForWrite
+  kBloomFilterChecked,     // filter lookups made by Table::InternalGet
+  kBloomFilterUseful,      // ... that ruled the key out without a read
+  kUserBytesWritten,       // write batch bytes passed to DB::Write
+  kWalBytesWritten,        // bytes appended to the log, framing included
+  kNumTickers
+};
+
+// Tickers kept per level
+enum LevelTicker {
+  kPmemHits = 0,           // Get() served by a PMEM table at the level
+  kSstHits,                // Get() served by an SST at the level
+  kNumLevelTickers
+};
+
+// Histograms are in microseconds
+enum HistogramType {
+  kGetMicros = 0,
+  kWriteMicros,
+  kCompactionMicros,
+  kWriteStallHistogram,
+  kNumHistograms
+};
+
+class LEVELDB_EXPORT Statistics {
+ public:
+  // Levels tracked by the level tickers (config::kNumLevels)
+  static const int kNumLevels = 7;
+
+  virtual ~Statistics();
+
+  virtual void RecordTick(Ticker ticker, uint64_t count = 1) = 0;
+  virtual void RecordLevelTick(LevelTicker ticker, int level,
+                               uint64_t count = 1) = 0;
+  virtual void MeasureTime(HistogramType type, uint64_t micros) = 0;
+
+  virtual uint64_t GetTickerCount(Ticker ticker) const = 0;
+  virtual uint64_t GetLevelTickerCount(LevelTicker ticker,
+                                       int level) const = 0;
+  virtual uint64_t GetHistogramCount(HistogramType type) const = 0;
+  // The "p"th percentile (0..100) of the values recorded in "type", to
+  // within ~1.6%.
+  virtual double GetHistogramPercentile(HistogramType type,
+                                        double p) const = 0;
+
+  // Zero every ticker and histogram.
+  virtual void Reset() = 0;
+
+  // Human-readable dump, and the same as a single-line JSON object:
+  //   {"tickers": {"memtable.hits": N, ...},
+  //    "levels": [{"level": 0, "pmem.hits": N, "sst.hits": N}, ...],
+  //    "histograms": {"get.micros": {"count": N, "p50": X, ...}, ...}}
+  virtual std::string ToString() const = 0;
+  virtual std::string ToJSON() const = 0;
+};
+
+// Return a new, zeroed Statistics object.  The caller owns it and must
+// keep it alive while any DB using it is open.
+LEVELDB_EXPORT Statistics* NewStatistics();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
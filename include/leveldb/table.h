@@ -62,6 +62,14 @@ class LEVELDB_EXPORT Table {
   // be close to the file length.
   uint64_t ApproximateOffsetOf(const Slice& key) const;
 
+  // Start fetching the data block that may hold "key", unless it is
+  // already in the block cache, so that a following lookup does not wait
+  // for the whole device round trip.  Only a hint; never fails.
+  void Prefetch(const Slice& key) const;
+
+  // Start fetching the whole file, e.g. ahead of a compaction scan.
+  void PrefetchAll(uint64_t file_size) const;
+
  private:
   struct Rep;
   Rep* rep_;
@@ -81,6 +89,7 @@ class LEVELDB_EXPORT Table {
 
   void ReadMeta(const Footer& footer);
   void ReadFilter(const Slice& filter_handle_value);
+  void ReadCompressionDict(const Slice& dict_handle_value);
 };
 
 }  // namespace leveldb
@@ -104,6 +104,10 @@ class LEVELDB_EXPORT TableBuilder {
   // Finish() call, returns the size of the final generated file.
   uint64_t FileSize() const;
 
+  // Bytes streamed to the pmem-buffer so far.  Entries linked by pointer
+  // are not copied and so are not counted.
+  uint64_t PmemBytesWritten() const;
+
   // JH
   Status FinishPmem();
 
@@ -111,6 +115,8 @@ class LEVELDB_EXPORT TableBuilder {
   bool ok() const { return status().ok(); }
   void WriteBlock(BlockBuilder* block, BlockHandle* handle);
   void WriteRawBlock(const Slice& data, CompressionType, BlockHandle* handle);
+  void SampleForDictionary(const Slice& raw);
+  void MaybeStreamBuffer(PmemBuffer* pmem_buffer, uint64_t number);
 
   struct Rep;
   Rep* rep_;
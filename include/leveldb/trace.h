@@ -0,0 +1,42 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Tracing records the hot paths of the store (WAL append, memtable insert,
+// PMEM insert and flush, SST block build, compaction merge, version
+// install, ...) as spans and writes them in the Chrome trace event format,
+// which chrome://tracing and ui.perfetto.dev can open:
+//
+//   leveldb::StartTrace(leveldb::Env::Default(), "/tmp/leveldb.trace.json");
+//   ... run the workload ...
+//   leveldb::EndTrace();
+//
+// The spans are only compiled in when the library is built with
+// -DLEVELDB_ENABLE_TRACING=ON (which defines LEVELDB_TRACING); otherwise
+// they cost nothing and StartTrace() returns NotSupported.  When compiled
+// in but not started, each span costs one relaxed atomic load.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_TRACE_H_
+#define STORAGE_LEVELDB_INCLUDE_TRACE_H_
+
+#include <string>
+#include "leveldb/export.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class Env;
+
+// Start recording spans from all threads, to be written to "fname" by
+// EndTrace().  Returns an error if tracing is compiled out, already
+// started or the file cannot be created.
+LEVELDB_EXPORT Status StartTrace(Env* env, const std::string& fname);
+
+// Stop recording and write the spans recorded since StartTrace().  At most
+// a few million spans are kept; later ones are dropped and the number
+// dropped is recorded in the trace metadata.
+LEVELDB_EXPORT Status EndTrace();
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_TRACE_H_
@@ -73,36 +73,67 @@ struct store_last_node last_node;
 int common_constant;
 
 /* Getter of Key & Value from (pmem)buffer */
+struct buffer_key_field {
+	const char* data;      // key, or suffix if delta
+	uint32_t length;
+	uint32_t shared;
+	uint32_t restart_back;
+	bool delta;
+};
+// Returns a pointer just past the key field
+static const char* ParseKeyField(const char* buf, struct buffer_key_field* f) {
+	const char* p = GetVarint32Ptr(buf, buf+VARINT_LENGTH, &f->length);
+	f->delta = (p - buf) > VarintLength(f->length);
+	f->shared = 0;
+	f->restart_back = 0;
+	if (f->delta) {
+		p = GetVarint32Ptr(p, p+VARINT_LENGTH, &f->shared);
+		p = GetVarint32Ptr(p, p+VARINT_LENGTH, &f->restart_back);
+	}
+	f->data = p;
+	return p + f->length;
+}
 uint32_t GetKeyLengthFromBuffer(char* buf) {
-	uint32_t key_len;
-	const char* key_ptr = GetVarint32Ptr(buf, buf+VARINT_LENGTH, &key_len);
-	return key_len;
+	struct buffer_key_field f;
+	ParseKeyField(buf, &f);
+	return f.shared + f.length;
 }
 char* GetKeyFromBuffer(char* buf) {
 	uint32_t key_len;
-	const char* key_ptr = GetVarint32Ptr(buf, buf+VARINT_LENGTH, &key_len);
-	return const_cast<char *>(key_ptr);
+	return GetKeyAndLengthFromBuffer(buf, &key_len);
 }
 char* GetKeyAndLengthFromBuffer(char* buf, uint32_t* key_len) {
-	const char* key_ptr = GetVarint32Ptr(buf, buf+VARINT_LENGTH, key_len);
-	return const_cast<char *>(key_ptr);
+	static thread_local std::string scratch;
+	return GetKeyAndLengthFromBuffer(buf, key_len, &scratch);
+}
+char* GetKeyAndLengthFromBuffer(char* buf, uint32_t* key_len,
+																std::string* scratch) {
+	struct buffer_key_field f;
+	ParseKeyField(buf, &f);
+	if (!f.delta) {
+		*key_len = f.length;
+		return const_cast<char *>(f.data);
+	}
+	// Restart records always hold their full key
+	struct buffer_key_field restart;
+	ParseKeyField(buf - f.restart_back, &restart);
+	scratch->assign(restart.data, f.shared);
+	scratch->append(f.data, f.length);
+	*key_len = scratch->size();
+	return &(*scratch)[0];
+}
+char* GetValueFieldFromBuffer(char* buf) {
+	struct buffer_key_field f;
+	return const_cast<char *>(ParseKeyField(buf, &f));
 }
 char* GetValueFromBuffer(char* buf) {
-	uint32_t key_length, value_length;
-	const char* key_ptr = GetVarint32Ptr(buf, buf+VARINT_LENGTH, &key_length);
-	const char* value_ptr = GetVarint32Ptr(
-													buf+key_length+VarintLength(key_length),
-													buf+key_length+VarintLength(key_length)+VARINT_LENGTH,
-													&value_length);
-	return const_cast<char *>(value_ptr);                 
+	uint32_t value_length;
+	return GetValueAndLengthFromBuffer(buf, &value_length);
 }
 char* GetValueAndLengthFromBuffer(char* buf, uint32_t* value_len) {
-	uint32_t key_length, value_length;
-	const char* key_ptr = GetVarint32Ptr(buf, buf+5, &key_length);
-	const char* value_ptr = GetVarint32Ptr(
-													buf+key_length+VarintLength(key_length),
-													buf+key_length+VarintLength(key_length)+VARINT_LENGTH,
-													value_len);
+	char* length_ptr = GetValueFieldFromBuffer(buf);
+	const char* value_ptr = GetVarint32Ptr(length_ptr, length_ptr+VARINT_LENGTH,
+																				value_len);
 	return const_cast<char *>(value_ptr);                 
 }
 
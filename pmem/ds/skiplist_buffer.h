@@ -75,9 +75,26 @@
 #define LEVEL_1_POINT ( LEVEL_2_POINT / 2)
 
 namespace leveldb{
+/*
+ * Record layout in the buffer:
+ *   varint32 key_len | key | varint32 value_len | value
+ * A prefix-compressed record replaces the key field with
+ *   padded varint32 suffix_len | varint32 shared | varint32 restart_back |
+ *   suffix
+ * where the key is the first "shared" bytes of the key of the restart
+ * record "restart_back" bytes before it, followed by "suffix".  The padded
+ * (VARINT_LENGTH bytes, non-minimal) length marks this form.
+ *
+ * Keys of prefix-compressed records are rebuilt in a scratch buffer: the
+ * overloads without one use a thread-local buffer that is only valid until
+ * the next call on the same thread.
+ */
 uint32_t GetKeyLengthFromBuffer(char* buf);
 char* GetKeyFromBuffer(char* buf);
 char* GetKeyAndLengthFromBuffer(char* buf, uint32_t* key_len);
+char* GetKeyAndLengthFromBuffer(char* buf, uint32_t* key_len,
+                                std::string* scratch);
+char* GetValueFieldFromBuffer(char* buf); // varint32 value_len | value
 char* GetValueFromBuffer(char* buf);
 char* GetValueAndLengthFromBuffer(char* buf, uint32_t* value_len);
 
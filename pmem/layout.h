@@ -7,6 +7,7 @@
 #define LAYOUT_H
 
 #include <libpmemobj.h>
+#include <string>
 
 /* Single skiplist */
 #define SKIPLIST_PATH "/home/zewei/pmem_dir/skiplist"
@@ -28,7 +29,13 @@
 #define SKIPLIST_MANAGER_PATH_11 "/home/zewei/pmem_dir/skiplist_manager_11"
 
 // #define SKIPLIST_MANAGER_POOL_SIZE 300 * (1 << 20)
-#define SKIPLIST_MANAGER_POOL_SIZE 2 * (1 << 30)
+#if defined(LEVELDB_SMALL_PMEM_POOLS)
+// Small-pool build (cmake -DLEVELDB_SMALL_PMEM_POOLS=ON): enough for
+// db_bench-sized runs on tmpfs, where pools are allocated up front
+#define SKIPLIST_MANAGER_POOL_SIZE (256UL << 20)
+#else
+#define SKIPLIST_MANAGER_POOL_SIZE (2UL << 30)
+#endif
 /* 
  * EVALUATION 1: write_buffer_size = 4MB (default)
  * value 100bytes - 28300 (28221) MAX_LIST_SIZE 290
@@ -74,14 +81,32 @@
 
 // #define BUFFER_POOL_SIZE 2.5 * (1 << 30)
 // #define BUFFER_POOL_SIZE 2684354560
-#define BUFFER_POOL_SIZE 2 * (1 << 30)
+#if defined(LEVELDB_SMALL_PMEM_POOLS)
+#define BUFFER_POOL_SIZE (192UL << 20)
+#define NUM_OF_CONTENTS 40
+#else
+#define BUFFER_POOL_SIZE (2UL << 30)
+#define NUM_OF_CONTENTS 350
+#endif
 #define NUM_OF_BUFFER 10
 // #define NUM_OF_BUFFER 13
-#define NUM_OF_CONTENTS 350
 #define EACH_CONTENT_SIZE 4 << 20 // FIXME: 4MB
 #define MAX_CONTENTS_SIZE (NUM_OF_CONTENTS * EACH_CONTENT_SIZE)
 
 #define FREE_LIST_WARNING_BOUNDARY 10
+// TableBuilder streams its pmem-buffer contents in chunks of this size
+#define BUFFER_STREAM_CHUNK_SIZE (64 << 10)
+// Values shorter than this are never compressed (Options::pmem_value_compression)
+#define PMEM_VALUE_COMPRESSION_MIN_SIZE 64
+
+/* Extents of pmem-resident memtables */
+#define MEMTABLE_BUFFER_PATH "/home/zewei/pmem_dir/pmem_buffer_memtable"
+
+/* Write-ahead log: ring of segments, one per live log number */
+#define PMEM_LOG_PATH "/home/zewei/pmem_dir/pmem_log"
+#define NUM_OF_LOG_SEGMENTS 4
+#define LOG_SEGMENT_SIZE (128 << 20) // caps write_buffer_size (SanitizeOptions)
+#define PMEM_LOG_POOL_SIZE (NUM_OF_LOG_SEGMENTS * LOG_SEGMENT_SIZE + (64 << 20))
 
 // PROGRESS: Hashmap
 #define HASHMAP_PATH "/home/zewei/pmem_dir/pmem_hashmap"
@@ -100,7 +125,22 @@
 #define HASHMAP_LIST_SIZE 100
 #define NUM_OF_HASHMAP 10
 
-namespace levedb {
+namespace leveldb {
+
+  // Path of the pool "default_path" (one of the *_PATH macros above),
+  // moved under "pmem_dir" if that is not empty.
+  inline std::string PmemPoolPath(const std::string& pmem_dir,
+                                  const char* default_path) {
+    if (pmem_dir.empty()) {
+      return default_path;
+    }
+    std::string base = default_path;
+    const size_t slash = base.rfind('/');
+    if (slash != std::string::npos) {
+      base = base.substr(slash + 1);
+    }
+    return pmem_dir + "/" + base;
+  }
 
 }
 #endif
@@ -0,0 +1,638 @@
+/*
+ * PMEM data-structure microbenchmarks
+ *
+ * Times PmemBuffer, PmemSkiplist, PmemIterator and PmemHashmap in
+ * isolation, without a DB around them, and reports ns/op and MB/s.  One
+ * op is one record.  Every thread works on pools of its own (buffer,
+ * skiplist and hashmap number "tid"), since the structures are only
+ * thread-safe across pools; --threads is therefore capped at the number
+ * of pools in pmem/layout.h.
+ *
+ *   bufferwrite     -- SequentialWrite one table image per file
+ *   bufferstream    -- StreamWrite the image in BUFFER_STREAM_CHUNK_SIZE
+ *                      chunks, as TableBuilder does
+ *   skiplistinsert  -- PmemSkiplist::Insert every record of every file
+ *   skiplistseek    -- PmemSkiplist::GetOID of --reads random keys
+ *   iteratornext    -- scan every file with PmemIterator::Next
+ *   hashmapinsert   -- PmemHashmap::Insert every record of every file
+ *                      (once per run: PmemHashmap cannot be cleared)
+ *   hashmapseek     -- PmemHashmap::SeekOID of --reads random keys
+ *
+ * Benchmarks that need records in the buffer, skiplist or hashmap fill
+ * them first, outside the timed section.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+#include "pmem/layout.h"
+#include "pmem/pmem_buffer.h"
+#include "pmem/pmem_hashmap.h"
+#include "pmem/pmem_iterator.h"
+#include "pmem/pmem_skiplist.h"
+#include "port/port.h"
+#include "util/hdr_histogram.h"
+#include "util/mutexlock.h"
+#include "util/random.h"
+
+// Comma-separated list of operations to run in the specified order
+static const char* FLAGS_benchmarks =
+    "bufferwrite,"
+    "bufferstream,"
+    "skiplistinsert,"
+    "skiplistseek,"
+    "iteratornext,"
+    "hashmapinsert,"
+    "hashmapseek,"
+    ;
+
+// Records per file (table)
+static int FLAGS_entries = 20000;
+
+// Files per thread
+static int FLAGS_files = 10;
+
+// Random lookups per thread in the seek benchmarks
+static int FLAGS_reads = 1000000;
+
+// Number of concurrent threads, each with pools of its own
+static int FLAGS_threads = 1;
+
+// Size of each key and value
+static int FLAGS_key_size = 16;
+static int FLAGS_value_size = 100;
+
+// Print a histogram of the time of each op (adds a clock read per op)
+static bool FLAGS_histogram = false;
+
+// Directory holding the PMEM pools (default: paths in pmem/layout.h)
+static const char* FLAGS_pmem_dir = nullptr;
+
+namespace leveldb {
+
+namespace {
+
+  const char* const kBufferPaths[] = {
+    BUFFER_PATH_0, BUFFER_PATH_1, BUFFER_PATH_2, BUFFER_PATH_3, BUFFER_PATH_4,
+    BUFFER_PATH_5, BUFFER_PATH_6, BUFFER_PATH_7, BUFFER_PATH_8, BUFFER_PATH_9
+  };
+  const char* const kSkiplistPaths[] = {
+    SKIPLIST_MANAGER_PATH_0, SKIPLIST_MANAGER_PATH_1, SKIPLIST_MANAGER_PATH_2,
+    SKIPLIST_MANAGER_PATH_3, SKIPLIST_MANAGER_PATH_4, SKIPLIST_MANAGER_PATH_5,
+    SKIPLIST_MANAGER_PATH_6, SKIPLIST_MANAGER_PATH_7, SKIPLIST_MANAGER_PATH_8,
+    SKIPLIST_MANAGER_PATH_9
+  };
+  const char* const kHashmapPaths[] = {
+    HASHMAP_PATH_0, HASHMAP_PATH_1, HASHMAP_PATH_2, HASHMAP_PATH_3,
+    HASHMAP_PATH_4, HASHMAP_PATH_5, HASHMAP_PATH_6, HASHMAP_PATH_7,
+    HASHMAP_PATH_8, HASHMAP_PATH_9
+  };
+  const int kMaxThreads = sizeof(kBufferPaths) / sizeof(kBufferPaths[0]);
+
+  // Path of the PMEM pool "default_path", moved under --pmem_dir if set
+  std::string PoolPath(const char* default_path) {
+    return PmemPoolPath(FLAGS_pmem_dir != nullptr ? FLAGS_pmem_dir : "",
+                        default_path);
+  }
+
+  uint64_t NowNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // Pools of one thread and the state of the records in them
+  struct PoolSet {
+    PmemBuffer* buffer;
+    PmemSkiplist* skiplist;
+    PmemHashmap* hashmap;
+    std::vector<char*> file_start;  // contents of each file in "buffer"
+    bool in_skiplist;
+    bool in_hashmap;
+
+    PoolSet()
+        : buffer(nullptr), skiplist(nullptr), hashmap(nullptr),
+          in_skiplist(false), in_hashmap(false) { }
+  };
+
+  class Stats {
+   public:
+    Stats() : start_(0), finish_(0), nanos_(0), ops_(0), bytes_(0),
+              last_op_(0) { }
+
+    void Start() {
+      start_ = last_op_ = NowNanos();
+    }
+
+    void Stop() {
+      finish_ = NowNanos();
+      nanos_ = finish_ - start_;
+    }
+
+    void FinishedOps(int64_t n, int64_t bytes) {
+      ops_ += n;
+      bytes_ += bytes;
+      if (FLAGS_histogram) {
+        uint64_t now = NowNanos();
+        hist_.Add((now - last_op_) / n);
+        last_op_ = now;
+      }
+    }
+
+    void AddMessage(const std::string& msg) { message_ = msg; }
+
+    void Merge(const Stats& other) {
+      hist_.Merge(other.hist_);
+      nanos_ += other.nanos_;
+      ops_ += other.ops_;
+      bytes_ += other.bytes_;
+      if (other.start_ < start_) start_ = other.start_;
+      if (other.finish_ > finish_) finish_ = other.finish_;
+      if (message_.empty()) message_ = other.message_;
+    }
+
+    // ns/op is per thread; MB/s is of all threads over the elapsed time
+    void Report(const Slice& name, int threads) const {
+      const double ns_per_op = ops_ > 0 ? static_cast<double>(nanos_) / ops_
+                                        : 0;
+      const double elapsed = (finish_ - start_) * 1e-9;
+      fprintf(stdout, "%-14s : %10.1f ns/op; %9.1f MB/s; %lld ops, "
+              "%d threads %s\n",
+              name.ToString().c_str(), ns_per_op,
+              elapsed > 0 ? bytes_ / 1048576.0 / elapsed : 0,
+              static_cast<long long>(ops_), threads, message_.c_str());
+      if (FLAGS_histogram) {
+        fprintf(stdout, "Nanoseconds per op: %s\n", hist_.ToString().c_str());
+      }
+      fflush(stdout);
+    }
+
+   private:
+    uint64_t start_;
+    uint64_t finish_;
+    uint64_t nanos_;
+    int64_t ops_;
+    int64_t bytes_;
+    uint64_t last_op_;
+    HdrHistogram hist_;
+    std::string message_;
+  };
+
+  struct SharedState {
+    port::Mutex mu;
+    port::CondVar cv GUARDED_BY(mu);
+    int total GUARDED_BY(mu);
+    int num_initialized GUARDED_BY(mu);
+    int num_done GUARDED_BY(mu);
+    bool start GUARDED_BY(mu);
+
+    SharedState(int total)
+        : cv(&mu), total(total), num_initialized(0), num_done(0),
+          start(false) { }
+  };
+
+  struct ThreadState {
+    int tid;
+    Random rand;
+    Stats stats;
+    PoolSet* pools;
+    SharedState* shared;
+
+    ThreadState(int index, PoolSet* pools)
+        : tid(index), rand(1000 + index), pools(pools), shared(nullptr) { }
+  };
+
+} // namespace
+
+  class Benchmark {
+   public:
+    Benchmark() : pools_(new PoolSet[FLAGS_threads]) {
+      // One table image, written once per file; every file holds the
+      // same keys in a skiplist/hashmap list of its own.
+      std::string value(FLAGS_value_size, 'v');
+      for (int i = 0; i < FLAGS_entries; i++) {
+        char key[100];
+        snprintf(key, sizeof(key), "%0*d", FLAGS_key_size, i);
+        keys_.push_back(std::string(key, FLAGS_key_size));
+        offsets_.push_back(image_.size());
+        EncodeToBuffer(&image_, Slice(keys_.back()), Slice(value));
+      }
+      if (static_cast<uint64_t>(image_.size()) * FLAGS_files >=
+          static_cast<uint64_t>(MAX_CONTENTS_SIZE)) {
+        fprintf(stderr, "%d files of %.1f MB do not fit in a pmem buffer\n",
+                FLAGS_files, image_.size() / 1048576.0);
+        exit(1);
+      }
+    }
+
+    ~Benchmark() {
+      for (int t = 0; t < FLAGS_threads; t++) {
+        delete pools_[t].buffer;
+        delete pools_[t].skiplist;
+        delete pools_[t].hashmap;
+      }
+      delete[] pools_;
+    }
+
+    void Run() {
+      PrintHeader();
+      const char* benchmarks = FLAGS_benchmarks;
+      while (benchmarks != nullptr) {
+        const char* sep = strchr(benchmarks, ',');
+        Slice name;
+        if (sep == nullptr) {
+          name = benchmarks;
+          benchmarks = nullptr;
+        } else {
+          name = Slice(benchmarks, sep - benchmarks);
+          benchmarks = sep + 1;
+        }
+
+        void (Benchmark::*method)(ThreadState*) = nullptr;
+        if (name == Slice("bufferwrite")) {
+          PrepareBuffer();
+          method = &Benchmark::BufferWrite;
+        } else if (name == Slice("bufferstream")) {
+          PrepareBuffer();
+          method = &Benchmark::BufferStream;
+        } else if (name == Slice("skiplistinsert")) {
+          PrepareSkiplist();
+          method = &Benchmark::SkiplistInsert;
+        } else if (name == Slice("skiplistseek")) {
+          FillSkiplist();
+          method = &Benchmark::SkiplistSeek;
+        } else if (name == Slice("iteratornext")) {
+          FillSkiplist();
+          method = &Benchmark::IteratorNext;
+        } else if (name == Slice("hashmapinsert")) {
+          if (pools_[0].in_hashmap) {
+            fprintf(stdout, "%-14s : skipped (hashmap already filled)\n",
+                    name.ToString().c_str());
+          } else {
+            PrepareHashmap();
+            method = &Benchmark::HashmapInsert;
+          }
+        } else if (name == Slice("hashmapseek")) {
+          FillHashmap();
+          method = &Benchmark::HashmapSeek;
+        } else if (name != Slice()) {  // No error message for empty name
+          fprintf(stderr, "unknown benchmark '%s'\n", name.ToString().c_str());
+        }
+
+        if (method != nullptr) {
+          RunBenchmark(name, method);
+        }
+      }
+    }
+
+   private:
+    struct ThreadArg {
+      Benchmark* bm;
+      SharedState* shared;
+      ThreadState* thread;
+      void (Benchmark::*method)(ThreadState*);
+    };
+
+    PoolSet* pools_;
+    std::string image_;
+    std::vector<uint32_t> offsets_;  // of each record in image_
+    std::vector<std::string> keys_;
+
+    void PrintHeader() {
+      fprintf(stdout, "Keys:       %d bytes each\n", FLAGS_key_size);
+      fprintf(stdout, "Values:     %d bytes each\n", FLAGS_value_size);
+      fprintf(stdout, "Entries:    %d per file, %d files per thread\n",
+              FLAGS_entries, FLAGS_files);
+      fprintf(stdout, "Image:      %.1f MB per file\n",
+              image_.size() / 1048576.0);
+      fprintf(stdout, "PMEM pools: %s\n",
+              FLAGS_pmem_dir != nullptr ? FLAGS_pmem_dir
+                                        : "pmem/layout.h paths");
+#ifndef NDEBUG
+      fprintf(stdout,
+              "WARNING: Assertions are enabled; benchmarks unnecessarily slow\n");
+#endif
+      fprintf(stdout, "------------------------------------------------\n");
+    }
+
+    static uint64_t FileNumber(int i) { return i + 1; }
+
+    /* Untimed setup */
+    void PrepareBuffer() {
+      for (int t = 0; t < FLAGS_threads; t++) {
+        PoolSet* p = &pools_[t];
+        if (p->buffer == nullptr) {
+          p->buffer = new PmemBuffer(PoolPath(kBufferPaths[t]));
+        }
+        p->buffer->ClearAll();
+        p->file_start.clear();
+        // Rewritten contents: the skiplist entries must be rebuilt too
+        ClearSkiplist(p);
+      }
+    }
+    void FillBuffer() {
+      if (!pools_[0].file_start.empty()) return;
+      PrepareBuffer();
+      RunUntimed(&Benchmark::BufferWrite);
+    }
+    void ClearSkiplist(PoolSet* p) {
+      if (p->in_skiplist) {
+        for (int i = 0; i < FLAGS_files; i++) {
+          p->skiplist->DeleteFile(FileNumber(i));
+        }
+        p->in_skiplist = false;
+      }
+    }
+    void PrepareSkiplist() {
+      FillBuffer();
+      for (int t = 0; t < FLAGS_threads; t++) {
+        PoolSet* p = &pools_[t];
+        if (p->skiplist == nullptr) {
+          p->skiplist = new PmemSkiplist(PoolPath(kSkiplistPaths[t]));
+          p->skiplist->ClearAll();
+        }
+        ClearSkiplist(p);
+      }
+    }
+    void FillSkiplist() {
+      if (pools_[0].in_skiplist) return;
+      PrepareSkiplist();
+      RunUntimed(&Benchmark::SkiplistInsert);
+    }
+    void PrepareHashmap() {
+      FillBuffer();
+      for (int t = 0; t < FLAGS_threads; t++) {
+        PoolSet* p = &pools_[t];
+        if (p->hashmap == nullptr) {
+          p->hashmap = new PmemHashmap(PoolPath(kHashmapPaths[t]));
+          p->hashmap->ClearAll();
+        }
+      }
+    }
+    void FillHashmap() {
+      if (pools_[0].in_hashmap) return;
+      PrepareHashmap();
+      RunUntimed(&Benchmark::HashmapInsert);
+    }
+    void RunUntimed(void (Benchmark::*method)(ThreadState*)) {
+      for (int t = 0; t < FLAGS_threads; t++) {
+        ThreadState thread(t, &pools_[t]);
+        (this->*method)(&thread);
+      }
+    }
+
+    /* Benchmarks */
+    void BufferWrite(ThreadState* thread) {
+      PoolSet* p = thread->pools;
+      for (int i = 0; i < FLAGS_files; i++) {
+        p->file_start.push_back(p->buffer->GetStartOffset(FileNumber(i)));
+        p->buffer->SequentialWrite(FileNumber(i), Slice(image_));
+        thread->stats.FinishedOps(FLAGS_entries, image_.size());
+      }
+    }
+
+    void BufferStream(ThreadState* thread) {
+      PoolSet* p = thread->pools;
+      for (int i = 0; i < FLAGS_files; i++) {
+        const uint64_t number = FileNumber(i);
+        p->file_start.push_back(p->buffer->GetStartOffset(number));
+        // Cut on record boundaries, like TableBuilder::MaybeStreamBuffer
+        size_t chunk_start = 0;
+        int chunk_records = 0;
+        for (int j = 0; j <= FLAGS_entries; j++) {
+          const size_t end = j < FLAGS_entries ? offsets_[j] : image_.size();
+          if (end - chunk_start >= BUFFER_STREAM_CHUNK_SIZE ||
+              (j == FLAGS_entries && end > chunk_start)) {
+            Status s = p->buffer->StreamWrite(
+                number, chunk_start,
+                Slice(image_.data() + chunk_start, end - chunk_start));
+            if (!s.ok()) {
+              fprintf(stderr, "bufferstream: %s\n", s.ToString().c_str());
+              exit(1);
+            }
+            thread->stats.FinishedOps(chunk_records, end - chunk_start);
+            chunk_start = end;
+            chunk_records = 0;
+          }
+          chunk_records++;
+        }
+        p->buffer->FinishStreamWrite(number, image_.size());
+      }
+    }
+
+    void SkiplistInsert(ThreadState* thread) {
+      PoolSet* p = thread->pools;
+      for (int i = 0; i < FLAGS_files; i++) {
+        for (int j = 0; j < FLAGS_entries; j++) {
+          p->skiplist->Insert(const_cast<char*>(keys_[j].data()),
+                              p->file_start[i] + offsets_[j],
+                              FLAGS_key_size, FileNumber(i), 0);
+          thread->stats.FinishedOps(1, FLAGS_key_size);
+        }
+      }
+      p->in_skiplist = true;
+    }
+
+    void SkiplistSeek(ThreadState* thread) {
+      PoolSet* p = thread->pools;
+      int found = 0;
+      for (int i = 0; i < FLAGS_reads; i++) {
+        const int file = thread->rand.Uniform(FLAGS_files);
+        const int k = thread->rand.Uniform(FLAGS_entries);
+        PMEMoid* oid = p->skiplist->GetOID(
+            FileNumber(file), const_cast<char*>(keys_[k].c_str()));
+        if (!OID_IS_NULL(*oid)) found++;
+        thread->stats.FinishedOps(1, FLAGS_key_size);
+      }
+      char msg[100];
+      snprintf(msg, sizeof(msg), "(%d of %d found)", found, FLAGS_reads);
+      thread->stats.AddMessage(msg);
+    }
+
+    void IteratorNext(ThreadState* thread) {
+      PoolSet* p = thread->pools;
+      for (int i = 0; i < FLAGS_files; i++) {
+        PmemIterator* iter = new PmemIterator(FileNumber(i), p->skiplist);
+        int64_t bytes = 0;
+        int n = 0;
+        for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+          bytes += iter->key().size() + iter->value().size();
+          n++;
+          if (n == 1000) {
+            thread->stats.FinishedOps(n, bytes);
+            n = 0;
+            bytes = 0;
+          }
+        }
+        if (n > 0) thread->stats.FinishedOps(n, bytes);
+        delete iter;
+      }
+    }
+
+    void HashmapInsert(ThreadState* thread) {
+      PoolSet* p = thread->pools;
+      for (int i = 0; i < FLAGS_files; i++) {
+        for (int j = 0; j < FLAGS_entries; j++) {
+          p->hashmap->Insert(const_cast<char*>(keys_[j].data()),
+                             p->file_start[i] + offsets_[j],
+                             FLAGS_key_size, FileNumber(i));
+          thread->stats.FinishedOps(1, FLAGS_key_size);
+        }
+      }
+      p->in_hashmap = true;
+    }
+
+    void HashmapSeek(ThreadState* thread) {
+      PoolSet* p = thread->pools;
+      int found = 0;
+      for (int i = 0; i < FLAGS_reads; i++) {
+        const int file = thread->rand.Uniform(FLAGS_files);
+        const int k = thread->rand.Uniform(FLAGS_entries);
+        PMEMoid* oid = p->hashmap->SeekOID(
+            FileNumber(file), const_cast<char*>(keys_[k].data()),
+            FLAGS_key_size);
+        if (oid != nullptr && !OID_IS_NULL(*oid)) found++;
+        thread->stats.FinishedOps(1, FLAGS_key_size);
+      }
+      char msg[100];
+      snprintf(msg, sizeof(msg), "(%d of %d found)", found, FLAGS_reads);
+      thread->stats.AddMessage(msg);
+    }
+
+    /* Driver, as in db_bench */
+    static void ThreadBody(void* v) {
+      ThreadArg* arg = reinterpret_cast<ThreadArg*>(v);
+      SharedState* shared = arg->shared;
+      ThreadState* thread = arg->thread;
+      {
+        MutexLock l(&shared->mu);
+        shared->num_initialized++;
+        if (shared->num_initialized >= shared->total) {
+          shared->cv.SignalAll();
+        }
+        while (!shared->start) {
+          shared->cv.Wait();
+        }
+      }
+
+      thread->stats.Start();
+      (arg->bm->*(arg->method))(thread);
+      thread->stats.Stop();
+
+      {
+        MutexLock l(&shared->mu);
+        shared->num_done++;
+        if (shared->num_done >= shared->total) {
+          shared->cv.SignalAll();
+        }
+      }
+    }
+
+    void RunBenchmark(Slice name, void (Benchmark::*method)(ThreadState*)) {
+      const int n = FLAGS_threads;
+      SharedState shared(n);
+
+      ThreadArg* arg = new ThreadArg[n];
+      for (int i = 0; i < n; i++) {
+        arg[i].bm = this;
+        arg[i].method = method;
+        arg[i].shared = &shared;
+        arg[i].thread = new ThreadState(i, &pools_[i]);
+        arg[i].thread->shared = &shared;
+        Env::Default()->StartThread(ThreadBody, &arg[i]);
+      }
+
+      shared.mu.Lock();
+      while (shared.num_initialized < n) {
+        shared.cv.Wait();
+      }
+
+      shared.start = true;
+      shared.cv.SignalAll();
+      while (shared.num_done < n) {
+        shared.cv.Wait();
+      }
+      shared.mu.Unlock();
+
+      for (int i = 1; i < n; i++) {
+        arg[0].thread->stats.Merge(arg[i].thread->stats);
+      }
+      arg[0].thread->stats.Report(name, n);
+
+      for (int i = 0; i < n; i++) {
+        delete arg[i].thread;
+      }
+      delete[] arg;
+    }
+  };
+
+} // namespace leveldb
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    int n;
+    char junk;
+    if (leveldb::Slice(argv[i]).starts_with("--benchmarks=")) {
+      FLAGS_benchmarks = argv[i] + strlen("--benchmarks=");
+    } else if (sscanf(argv[i], "--entries=%d%c", &n, &junk) == 1 && n > 0) {
+      FLAGS_entries = n;
+    } else if (sscanf(argv[i], "--files=%d%c", &n, &junk) == 1 && n > 0) {
+      FLAGS_files = n;
+    } else if (sscanf(argv[i], "--reads=%d%c", &n, &junk) == 1 && n >= 0) {
+      FLAGS_reads = n;
+    } else if (sscanf(argv[i], "--threads=%d%c", &n, &junk) == 1 && n > 0) {
+      FLAGS_threads = n;
+    } else if (sscanf(argv[i], "--key_size=%d%c", &n, &junk) == 1 &&
+               n > 0 && n < 100) {
+      FLAGS_key_size = n;
+    } else if (sscanf(argv[i], "--value_size=%d%c", &n, &junk) == 1 &&
+               n >= 0) {
+      FLAGS_value_size = n;
+    } else if (sscanf(argv[i], "--histogram=%d%c", &n, &junk) == 1 &&
+               (n == 0 || n == 1)) {
+      FLAGS_histogram = n;
+    } else if (strncmp(argv[i], "--pmem_dir=", 11) == 0) {
+      FLAGS_pmem_dir = argv[i] + 11;
+    } else {
+      fprintf(stderr, "Invalid flag '%s'\n", argv[i]);
+      exit(1);
+    }
+  }
+
+  // Each thread needs pools of its own, and each file a list and contents
+  // slot of its own
+  if (FLAGS_threads > leveldb::kMaxThreads) {
+    fprintf(stderr, "--threads is at most %d (pools in pmem/layout.h)\n",
+            leveldb::kMaxThreads);
+    exit(1);
+  }
+  if (FLAGS_files > SKIPLIST_MANAGER_LIST_SIZE ||
+      FLAGS_files > HASHMAP_LIST_SIZE) {
+    fprintf(stderr, "--files is at most %d per thread\n",
+            SKIPLIST_MANAGER_LIST_SIZE < HASHMAP_LIST_SIZE
+                ? SKIPLIST_MANAGER_LIST_SIZE : HASHMAP_LIST_SIZE);
+    exit(1);
+  }
+  char digits[32];
+  if (snprintf(digits, sizeof(digits), "%d", FLAGS_entries - 1) >
+      FLAGS_key_size) {
+    fprintf(stderr, "--key_size is too small for %d distinct keys\n",
+            FLAGS_entries);
+    exit(1);
+  }
+  if (FLAGS_entries > MAX_SKIPLIST_NODE_SIZE) {
+    fprintf(stderr, "--entries is at most %d (MAX_SKIPLIST_NODE_SIZE)\n",
+            MAX_SKIPLIST_NODE_SIZE);
+    exit(1);
+  }
+
+  leveldb::Benchmark benchmark;
+  benchmark.Run();
+  return 0;
+}
@@ -3,9 +3,14 @@
  * PMDK-based buffer class
  */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include "util/coding.h" 
+#include "leveldb/options.h"
+#include "port/port.h"
+#include "util/crc32c.h"
+#include "util/mutexlock.h"
 #include "pmem/pmem_buffer.h"
 
 namespace leveldb {
@@ -15,6 +20,123 @@ namespace leveldb {
     PutLengthPrefixedSlice(buffer, value);
   }
 
+  // Padded varint32: always VARINT_LENGTH bytes, so never minimal for
+  // lengths below 2^28.  Marks a compressed value or a prefix-compressed key.
+  static void PutPaddedVarint32(std::string* dst, uint32_t v) {
+    char buf[VARINT_LENGTH];
+    for (int i = 0; i < VARINT_LENGTH - 1; i++) {
+      buf[i] = static_cast<char>(((v >> (7 * i)) & 0x7f) | 0x80);
+    }
+    buf[VARINT_LENGTH - 1] = static_cast<char>(v >> (7 * (VARINT_LENGTH - 1)));
+    dst->append(buf, VARINT_LENGTH);
+  }
+  // Append the value field, compressed if that pays off; returns its length
+  static int PutValueField(std::string* buffer, const Slice& value,
+                           int compression, int zstd_level) {
+    std::string compressed;
+    bool ok = false;
+    if (compression != kNoCompression &&
+        value.size() >= PMEM_VALUE_COMPRESSION_MIN_SIZE) {
+      switch (compression) {
+        case kSnappyCompression:
+          ok = port::Snappy_Compress(value.data(), value.size(), &compressed);
+          break;
+        case kZstdCompression:
+          ok = port::Zstd_Compress(zstd_level, value.data(), value.size(),
+                                   &compressed, nullptr, 0);
+          break;
+        case kLZ4Compression:
+          ok = port::Lz4_Compress(value.data(), value.size(), &compressed);
+          break;
+      }
+      // Same threshold as table blocks: keep it raw unless it saves 12.5%
+      ok = ok && (1 + compressed.size() < value.size() - (value.size() / 8u));
+    }
+    if (!ok) {
+      PutLengthPrefixedSlice(buffer, value);
+      return VarintLength(value.size()) + value.size();
+    }
+    // value := [compression type][compressed bytes]
+    PutPaddedVarint32(buffer, 1 + compressed.size());
+    buffer->push_back(static_cast<char>(compression));
+    buffer->append(compressed);
+    return VARINT_LENGTH + 1 + compressed.size();
+  }
+  int EncodeCompressedToBuffer(std::string* buffer, const Slice& key,
+                               const Slice& value, int compression,
+                               int zstd_level) {
+    PutLengthPrefixedSlice(buffer, key);
+    return VarintLength(key.size()) + key.size() +
+           PutValueField(buffer, value, compression, zstd_level);
+  }
+  int EncodeDeltaToBuffer(std::string* buffer, const Slice& key,
+                          const Slice& value, const Slice& restart_key,
+                          uint32_t restart_back, int compression,
+                          int zstd_level) {
+    size_t shared = 0;
+    const size_t min_length = std::min(key.size(), restart_key.size());
+    while ((shared < min_length) && (key[shared] == restart_key[shared])) {
+      shared++;
+    }
+    const size_t suffix = key.size() - shared;
+    const size_t delta_key_length = VARINT_LENGTH + VarintLength(shared) +
+                                    VarintLength(restart_back) + suffix;
+    if (delta_key_length >= VarintLength(key.size()) + key.size()) {
+      // Not enough in common to pay for the longer header
+      return EncodeCompressedToBuffer(buffer, key, value, compression,
+                                      zstd_level);
+    }
+    PutPaddedVarint32(buffer, suffix);
+    PutVarint32(buffer, shared);
+    PutVarint32(buffer, restart_back);
+    buffer->append(key.data() + shared, suffix);
+    return delta_key_length +
+           PutValueField(buffer, value, compression, zstd_level);
+  }
+  bool DecodeValueFromBuffer(const char* buf, Slice* value,
+                             std::string* scratch) {
+    uint32_t value_length;
+    const char* length_ptr = GetValueFieldFromBuffer(const_cast<char *>(buf));
+    const char* value_ptr = GetVarint32Ptr(length_ptr,
+                                           length_ptr+VARINT_LENGTH,
+                                           &value_length);
+    if (value_ptr - length_ptr <= VarintLength(value_length)) {
+      *value = Slice(value_ptr, value_length);  // Stored raw
+      return true;
+    }
+    if (value_length < 1) {
+      return false;
+    }
+    const char* data = value_ptr + 1;
+    const size_t n = value_length - 1;
+    size_t ulength = 0;
+    bool ok = false;
+    switch (value_ptr[0]) {
+      case kSnappyCompression:
+        if (port::Snappy_GetUncompressedLength(data, n, &ulength)) {
+          scratch->resize(ulength);
+          ok = port::Snappy_Uncompress(data, n, &(*scratch)[0]);
+        }
+        break;
+      case kZstdCompression:
+        if (port::Zstd_GetUncompressedLength(data, n, &ulength)) {
+          scratch->resize(ulength);
+          ok = port::Zstd_Uncompress(data, n, &(*scratch)[0], nullptr, 0);
+        }
+        break;
+      case kLZ4Compression:
+        if (port::Lz4_GetUncompressedLength(data, n, &ulength)) {
+          scratch->resize(ulength);
+          ok = port::Lz4_Uncompress(data, n, &(*scratch)[0]);
+        }
+        break;
+    }
+    if (ok) {
+      *value = Slice(*scratch);
+    }
+    return ok;
+  }
+
   // DEBUG: 
   void AddToPmemBuffer(PmemBuffer* pmem_buffer, 
                                   std::string* buffer, uint64_t file_number) {
@@ -51,19 +173,16 @@ namespace leveldb {
     }
   }
   uint32_t SkipNEntriesAndGetOffset(const char* buf, uint64_t file_number, uint8_t n) {
-    Slice key, value;
     uint32_t skip_length = 0;
-    uint32_t key_length, value_length;
+    uint32_t value_length;
     for (int i=0; i< n; i++) {
       char* tmp_buf = const_cast<char *>(buf)+skip_length;
-      const char* key_ptr = GetVarint32Ptr(tmp_buf, 
-                                          tmp_buf+VARINT_LENGTH, &key_length);
-      uint32_t encoded_key_length = VarintLength(key_length) + key_length;
-      const char* value_ptr = GetVarint32Ptr(tmp_buf+encoded_key_length, 
-                                    tmp_buf+encoded_key_length+VARINT_LENGTH, 
-                                    &value_length);
-      uint32_t encoded_value_length = VarintLength(value_length) + value_length;
-      skip_length += (encoded_key_length + encoded_value_length);
+      // Prefix-compressed keys and compressed values have padded varints
+      char* length_ptr = GetValueFieldFromBuffer(tmp_buf);
+      const char* value_ptr = GetVarint32Ptr(length_ptr,
+                                             length_ptr+VARINT_LENGTH,
+                                             &value_length);
+      skip_length = (value_ptr + value_length) - buf;
     }
     return skip_length;
   }
@@ -71,6 +190,18 @@ namespace leveldb {
   int GetEncodedLength(const size_t key_size, const size_t value_size) {
     return VarintLength(key_size) + key_size + VarintLength(value_size) + value_size;
   }
+  Status VerifyPmemRecord(PmemBuffer** buffers, const char* ptr,
+                          const char** chunk_start, const char** chunk_limit) {
+    // Compaction links records of other tables by pointer, so the record
+    // need not live in the buffer of the table being read.
+    for (int i=0; i<NUM_OF_BUFFER; i++) {
+      if (buffers[i]->Contains(ptr)) {
+        return buffers[i]->VerifyChunk(ptr, chunk_start, chunk_limit);
+      }
+    }
+    *chunk_start = *chunk_limit = ptr;
+    return Status::OK();
+  }
 
   /* 
    * pmem-buffer DA functions 
@@ -86,10 +217,10 @@ namespace leveldb {
   }
 
   /* pmdk-based buffer */
-  PmemBuffer::PmemBuffer() {
+  PmemBuffer::PmemBuffer() : bytes_written_(0) {
     Init(BUFFER_PATH);
   }
-  PmemBuffer::PmemBuffer(std::string pool_path) {
+  PmemBuffer::PmemBuffer(std::string pool_path) : bytes_written_(0) {
     Init(pool_path);
   }
   PmemBuffer::~PmemBuffer() {
@@ -128,6 +259,14 @@ namespace leveldb {
     }
     // PROGRESS:
     current_offset = 0;
+    {
+      MutexLock l(&extent_mutex_);
+      extents_.clear();
+      free_extents_.clear();
+      linked_extents_.clear();
+    }
+    MutexLock l(&checksum_mutex_);
+    chunk_checksums_.clear();
   }
   void PmemBuffer::SequentialWrite(uint64_t file_number, const Slice& data) {
     // Get offset(index)
@@ -144,6 +283,8 @@ namespace leveldb {
       data.data(), 
       data_size
     );
+    AddChunkChecksum(offset, data);
+    bytes_written_.fetch_add(data_size, std::memory_order_relaxed);
     // Addition for updating current offset
     current_offset += data_size;
     // Set contents_size about matching offset(index)
@@ -153,6 +294,32 @@ namespace leveldb {
     //   sizeof(uint32_t)
     // );
   }
+  Status PmemBuffer::StreamWrite(uint64_t file_number, uint64_t offset,
+                                 const Slice& data) {
+    uint64_t start = GetIndexFromAllocatedMap(&allocated_map_, file_number);
+    if (start + offset + data.size() >= MAX_CONTENTS_SIZE) {
+      char buf[100];
+      snprintf(buf, sizeof(buf), "table #%llu needs %llu bytes at offset %llu",
+               (unsigned long long)file_number,
+               (unsigned long long)(offset + data.size()),
+               (unsigned long long)start);
+      return Status::IOError("pmem buffer is full", buf);
+    }
+    pmemobj_memcpy(buffer_pool_.get_handle(),
+                   root_buffer_->contents.get() + start + offset,
+                   data.data(), data.size(),
+                   PMEMOBJ_F_MEM_NONTEMPORAL | PMEMOBJ_F_MEM_NODRAIN);
+    AddChunkChecksum(start + offset, data);
+    bytes_written_.fetch_add(data.size(), std::memory_order_relaxed);
+    return Status::OK();
+  }
+  void PmemBuffer::FinishStreamWrite(uint64_t file_number,
+                                     uint64_t total_size) {
+    DelayPmemWriteNtimes(1);
+    pmemobj_drain(buffer_pool_.get_handle());
+    // Addition for updating current offset
+    current_offset += total_size;
+  }
   void PmemBuffer::RandomRead(uint64_t file_number,
                               uint64_t offset, size_t n, Slice* result) {
     // Get offset(index)
@@ -185,19 +352,62 @@ namespace leveldb {
    * NOTE: Be copied from memtable.cc
    */
   std::string PmemBuffer::key(char* buf) const {
+    std::string scratch;
     uint32_t key_length;
-    const char* key_ptr = GetVarint32Ptr(buf, buf+VARINT_LENGTH, &key_length);
+    const char* key_ptr = GetKeyAndLengthFromBuffer(buf, &key_length, &scratch);
     return std::string(key_ptr, key_length);
   }
   std::string PmemBuffer::value(char* buf) const {
-    uint32_t key_length, value_length;
-    const char* key_ptr = GetVarint32Ptr(buf, buf+VARINT_LENGTH, &key_length);
-    const char* value_ptr = GetVarint32Ptr(
-                        buf+key_length+VarintLength(key_length),
-                        buf+key_length+VarintLength(key_length)+VARINT_LENGTH,
-                        &value_length);
-    return std::string(value_ptr, value_length);                    
+    std::string scratch;
+    Slice value;
+    if (!DecodeValueFromBuffer(buf, &value, &scratch)) {
+      return std::string();
+    }
+    return value.ToString();
   }
+  /* Checksum */
+  void PmemBuffer::AddChunkChecksum(uint64_t offset, const Slice& data) {
+    // Computed from the DRAM copy, so it also catches bad media writes
+    ChunkChecksum chunk;
+    chunk.size = data.size();
+    chunk.crc = crc32c::Value(data.data(), data.size());
+    chunk.state = kUnverified;
+    MutexLock l(&checksum_mutex_);
+    chunk_checksums_[offset] = chunk;
+  }
+  bool PmemBuffer::Contains(const char* ptr) {
+    const char* contents = root_buffer_->contents.get();
+    return ptr >= contents && ptr < contents + MAX_CONTENTS_SIZE;
+  }
+  Status PmemBuffer::VerifyChunk(const char* ptr, const char** chunk_start,
+                                 const char** chunk_limit) {
+    const char* contents = root_buffer_->contents.get();
+    uint64_t offset = ptr - contents;
+    *chunk_start = *chunk_limit = ptr;
+    MutexLock l(&checksum_mutex_);
+    std::map<uint64_t, ChunkChecksum>::iterator it =
+        chunk_checksums_.upper_bound(offset);
+    if (it == chunk_checksums_.begin()) {
+      return Status::OK();
+    }
+    --it;
+    ChunkChecksum* chunk = &it->second;
+    if (offset >= it->first + chunk->size) {
+      return Status::OK();
+    }
+    if (chunk->state == kUnverified) {
+      DelayPmemReadNtimes(1);
+      uint32_t actual = crc32c::Value(contents + it->first, chunk->size);
+      chunk->state = (actual == chunk->crc) ? kVerified : kMismatch;
+    }
+    if (chunk->state == kMismatch) {
+      return Status::Corruption("pmem buffer chunk checksum mismatch");
+    }
+    *chunk_start = contents + it->first;
+    *chunk_limit = *chunk_start + chunk->size;
+    return Status::OK();
+  }
+
   /* Getter */
   PMEMobjpool* PmemBuffer::GetPool() {
     return buffer_pool_.get_handle();
@@ -207,5 +417,86 @@ namespace leveldb {
     return root_buffer_->contents.get() + offset;
   }
 
+  /* Extent */
+  char* PmemBuffer::AllocateExtent(size_t size) {
+    MutexLock l(&extent_mutex_);
+    uint64_t offset;
+    // Memtables all ask for the same size, so the smallest free extent
+    // that fits is normally an exact match
+    std::multimap<uint64_t, uint64_t>::iterator free =
+        free_extents_.lower_bound(size);
+    if (free != free_extents_.end()) {
+      offset = free->second;
+      size = free->first;
+      free_extents_.erase(free);
+    } else if (current_offset + size < MAX_CONTENTS_SIZE) {
+      offset = current_offset;
+      current_offset += size;
+    } else {
+      return nullptr;
+    }
+    Extent* extent = &extents_[offset];
+    extent->size = size;
+    extent->refs = 1;
+    return root_buffer_->contents.get() + offset;
+  }
+  void PmemBuffer::UnrefExtentLocked(uint64_t offset) {
+    std::map<uint64_t, Extent>::iterator it = extents_.find(offset);
+    assert(it != extents_.end());
+    assert(it->second.refs > 0);
+    if (--it->second.refs == 0) {
+      free_extents_.insert(std::make_pair(it->second.size, offset));
+      extents_.erase(it);
+    }
+  }
+  void PmemBuffer::UnrefExtent(const char* extent) {
+    MutexLock l(&extent_mutex_);
+    UnrefExtentLocked(extent - root_buffer_->contents.get());
+  }
+  void PmemBuffer::LinkExtent(uint64_t file_number, const char* ptr,
+                              const char** start, const char** limit) {
+    *start = *limit = ptr;
+    if (!Contains(ptr)) {
+      return;
+    }
+    char* contents = root_buffer_->contents.get();
+    const uint64_t offset = ptr - contents;
+    MutexLock l(&extent_mutex_);
+    std::map<uint64_t, Extent>::iterator it = extents_.upper_bound(offset);
+    if (it == extents_.begin()) {
+      return;
+    }
+    --it;
+    if (offset >= it->first + it->second.size) {
+      return;
+    }
+    if (linked_extents_[file_number].insert(it->first).second) {
+      it->second.refs++;
+    }
+    *start = contents + it->first;
+    *limit = *start + it->second.size;
+  }
+  void PmemBuffer::UnlinkExtents(uint64_t file_number) {
+    MutexLock l(&extent_mutex_);
+    std::map<uint64_t, std::set<uint64_t> >::iterator it =
+        linked_extents_.find(file_number);
+    if (it == linked_extents_.end()) {
+      return;
+    }
+    for (std::set<uint64_t>::iterator offset = it->second.begin();
+         offset != it->second.end(); ++offset) {
+      UnrefExtentLocked(*offset);
+    }
+    linked_extents_.erase(it);
+  }
+  void PmemBuffer::Persist(const char* ptr, size_t size) {
+    DelayPmemWriteNtimes(1);
+    buffer_pool_.persist(ptr, size);
+    bytes_written_.fetch_add(size, std::memory_order_relaxed);
+  }
+  uint64_t PmemBuffer::BytesWritten() const {
+    return bytes_written_.load(std::memory_order_relaxed);
+  }
+
 
 } // namespace leveldb 
\ No newline at end of file
@@ -7,6 +7,12 @@
 
 
 // #include "util/coding.h" 
+#include <atomic>
+#include <map>
+#include <set>
+#include "leveldb/status.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
 #include "pmem/pmem_skiplist.h"
 
 // use pmem with c++ bindings
@@ -18,6 +24,31 @@ namespace leveldb {
   class PmemBuffer;
 
   void EncodeToBuffer(std::string* buffer, const Slice& key, const Slice& value);
+  // Like EncodeToBuffer, but store "value" compressed with "compression"
+  // (a CompressionType, zstd at "zstd_level") if it is long enough and
+  // compresses well.  A
+  // compressed record is flagged by writing its value length as a padded
+  // (non-minimal) varint, so existing readers still find the key and the
+  // record extent.  Returns the encoded length of the record.
+  int EncodeCompressedToBuffer(std::string* buffer, const Slice& key,
+                               const Slice& value, int compression,
+                               int zstd_level);
+  // Like EncodeCompressedToBuffer, but if "key" shares enough of a prefix
+  // with "restart_key", the key of the record "restart_back" bytes before
+  // this one, store only the rest of it (see skiplist_buffer.h).
+  int EncodeDeltaToBuffer(std::string* buffer, const Slice& key,
+                          const Slice& value, const Slice& restart_key,
+                          uint32_t restart_back, int compression,
+                          int zstd_level);
+  // Set "*value" to the value of the record at "buf", decompressing it
+  // into "*scratch" if needed.  Returns false if the record is corrupt.
+  bool DecodeValueFromBuffer(const char* buf, Slice* value,
+                             std::string* scratch);
+ 
+  // Check the chunk checksum of the record at "ptr" in whichever of
+  // "buffers" (Options::pmem_buffer) holds it; see PmemBuffer::VerifyChunk.
+  Status VerifyPmemRecord(PmemBuffer** buffers, const char* ptr,
+                          const char** chunk_start, const char** chunk_limit);
  
   // DEBUG:
   void AddToPmemBuffer(PmemBuffer* pmem_buffer, std::string* buffer, uint64_t file_number);
@@ -37,11 +68,33 @@ namespace leveldb {
 
     /* Read/Write function */
     void SequentialWrite(uint64_t file_number, const Slice& data);
+    // Streaming variant of SequentialWrite: copy "data" to "offset" within
+    // the file's contents with non-temporal stores and no drain, then call
+    // FinishStreamWrite() once with the total size after the last chunk.
+    // Returns an IOError, writing nothing, if the chunk does not fit in
+    // the pool.
+    Status StreamWrite(uint64_t file_number, uint64_t offset, const Slice& data);
+    void FinishStreamWrite(uint64_t file_number, uint64_t total_size);
     void RandomRead(uint64_t file_number, 
                     uint64_t offset, size_t n, Slice* result);
     std::string key(char* buf) const;
     std::string value(char* buf) const;
 
+    /* Checksum */
+    // Every SequentialWrite/StreamWrite call records the CRC32C of the data
+    // it wrote as one chunk; chunks always end on a record boundary.
+    // VerifyChunk checks the chunk holding "ptr" the first time it is asked
+    // for and remembers the result, then sets [*chunk_start, *chunk_limit)
+    // to that chunk.  "ptr" outside any chunk (e.g. in a memtable extent)
+    // is OK and yields an empty range.
+    Status VerifyChunk(const char* ptr, const char** chunk_start,
+                       const char** chunk_limit);
+    bool Contains(const char* ptr);
+
+    /* Stats */
+    // Bytes written to this pool by tables and memtable extents
+    uint64_t BytesWritten() const;
+
     /* Getter */
     PMEMobjpool* GetPool();
     char* GetStartOffset(uint64_t file_number);
@@ -50,6 +103,26 @@ namespace leveldb {
     uint64_t AddFileAndGetNextOffset(uint64_t file_number);
     void InsertAllocatedMap(uint64_t file_number, uint64_t index);
 
+    /* Extent for pmem-resident memtable entries */
+    // Reserve "size" contiguous bytes, reusing a released extent when one
+    // is large enough, or return nullptr if the pool is full.  The caller
+    // (the memtable filling it) holds the only reference.
+    // Extents are not tied to a file number; tables refer to their entries
+    // by pointer, and hold a reference on every extent they link into, so
+    // an extent is reused only once its memtable and every such table are
+    // gone.
+    char* AllocateExtent(size_t size);
+    void UnrefExtent(const char* extent);
+    // Note that table "file_number" links the record at "ptr".  The first
+    // time a table links into an extent it takes a reference on it.  Sets
+    // [*start, *limit) to the extent holding "ptr" (empty if none), so
+    // that callers can skip the records that follow in the same extent.
+    void LinkExtent(uint64_t file_number, const char* ptr,
+                    const char** start, const char** limit);
+    // Drop the references table "file_number" took with LinkExtent
+    void UnlinkExtents(uint64_t file_number);
+    void Persist(const char* ptr, size_t size);
+
    private:
     /* pmdk access object */
     pobj::pool<root_pmem_buffer> buffer_pool_;
@@ -58,6 +131,31 @@ namespace leveldb {
 
     /* Dynamic allocation */
     std::map<uint64_t, uint64_t> allocated_map_; // [ file_number -> index ]
+
+    /* Checksum */
+    enum ChunkState { kUnverified, kVerified, kMismatch };
+    struct ChunkChecksum {
+      uint32_t size;
+      uint32_t crc;
+      ChunkState state;
+    };
+    void AddChunkChecksum(uint64_t offset, const Slice& data);
+    std::atomic<uint64_t> bytes_written_;
+
+    /* Extent */
+    struct Extent {
+      uint64_t size;
+      int refs;
+    };
+    void UnrefExtentLocked(uint64_t offset) EXCLUSIVE_LOCKS_REQUIRED(extent_mutex_);
+    port::Mutex extent_mutex_;
+    std::map<uint64_t, Extent> extents_ GUARDED_BY(extent_mutex_);  // [ offset -> extent ]
+    std::multimap<uint64_t, uint64_t> free_extents_ GUARDED_BY(extent_mutex_);  // [ size -> offset ]
+    std::map<uint64_t, std::set<uint64_t> > linked_extents_ GUARDED_BY(extent_mutex_);  // [ file_number -> offsets ]
+    port::Mutex checksum_mutex_;
+    // [ contents offset -> chunk ], in DRAM like allocated_map_
+    std::map<uint64_t, ChunkChecksum> chunk_checksums_
+        GUARDED_BY(checksum_mutex_);
   };
   /* root structure for accessing pmdk */
   struct root_pmem_buffer {
@@ -38,6 +38,7 @@ SPDX-License-Identifier: BSD-3-Clause
 #include <fstream> //file_exists
 #include <chrono>
 #include "pmem/pmem_buffer.h"
+#include "leveldb/options.h"
 
 
 using namespace std;
@@ -177,6 +178,166 @@ TEST (PmemBufferTest, Buffer) {
 	printf("# End Buffer\n");
 }
 
+TEST (PmemBufferTest, CompressedRecords) {
+  const int kTypes[] = { kNoCompression, kSnappyCompression,
+                         kZstdCompression, kLZ4Compression };
+  for (size_t t = 0; t < sizeof(kTypes) / sizeof(kTypes[0]); t++) {
+    // Raw and compressed records mixed in one buffer
+    std::string buffer;
+    std::vector<std::string> values;
+    std::vector<int> offsets;
+    for (int i = 0; i < 100; i++) {
+      std::string value = (i % 3 == 0) ? "short" : std::string(100 + i, 'a' + i % 26);
+      char key[20];
+      snprintf(key, sizeof(key), "key-%06d", i);
+      offsets.push_back(buffer.size());
+      values.push_back(value);
+      int length;
+      if (i % 2 == 0) {
+        length = EncodeCompressedToBuffer(&buffer, Slice(key), Slice(value),
+                                          kTypes[t], 1 + i % 5);
+      } else {
+        EncodeToBuffer(&buffer, Slice(key), Slice(value));
+        length = GetEncodedLength(strlen(key), value.size());
+      }
+      ASSERT_EQ(buffer.size(), offsets.back() + length);
+    }
+
+    std::string scratch;
+    for (int i = 0; i < 100; i++) {
+      char* record = const_cast<char *>(buffer.data()) + offsets[i];
+      char key[20];
+      snprintf(key, sizeof(key), "key-%06d", i);
+      uint32_t key_len;
+      char* key_ptr = GetKeyAndLengthFromBuffer(record, &key_len);
+      ASSERT_EQ(std::string(key), std::string(key_ptr, key_len));
+      Slice value;
+      ASSERT_TRUE(DecodeValueFromBuffer(record, &value, &scratch));
+      ASSERT_EQ(values[i], value.ToString());
+    }
+    ASSERT_EQ(offsets[10], SkipNEntriesAndGetOffset(buffer.data(), 0, 10));
+  }
+}
+
+TEST (PmemBufferTest, PrefixCompressedRecords) {
+  const int kInterval = 4;
+  std::string buffer;
+  std::vector<std::string> keys;
+  std::vector<int> offsets;
+  std::string restart_key;
+  int restart_offset = 0;
+  for (int i = 0; i < 100; i++) {
+    char key[40];
+    // Every tenth key shares nothing with its predecessors
+    snprintf(key, sizeof(key), "%s%06d", (i % 10 == 9) ? "z" : "user-key-", i);
+    std::string value = std::string(10 + i, 'a' + i % 26);
+    offsets.push_back(buffer.size());
+    keys.push_back(key);
+    int length;
+    if (i % kInterval == 0) {
+      length = EncodeCompressedToBuffer(&buffer, Slice(key), Slice(value),
+                                        (i % 8 == 0) ? kSnappyCompression
+                                                     : kNoCompression, 1);
+      restart_key = key;
+      restart_offset = offsets.back();
+    } else {
+      length = EncodeDeltaToBuffer(&buffer, Slice(key), Slice(value),
+                                   Slice(restart_key),
+                                   offsets.back() - restart_offset,
+                                   kNoCompression, 1);
+    }
+    ASSERT_EQ(buffer.size(), offsets.back() + length);
+  }
+
+  std::string key_scratch, value_scratch;
+  for (int i = 0; i < 100; i++) {
+    char* record = const_cast<char *>(buffer.data()) + offsets[i];
+    uint32_t key_len;
+    char* key_ptr = GetKeyAndLengthFromBuffer(record, &key_len, &key_scratch);
+    ASSERT_EQ(keys[i], std::string(key_ptr, key_len));
+    key_ptr = GetKeyAndLengthFromBuffer(record, &key_len);
+    ASSERT_EQ(keys[i], std::string(key_ptr, key_len));
+    ASSERT_EQ(keys[i].size(), GetKeyLengthFromBuffer(record));
+    Slice value;
+    ASSERT_TRUE(DecodeValueFromBuffer(record, &value, &value_scratch));
+    ASSERT_EQ(std::string(10 + i, 'a' + i % 26), value.ToString());
+  }
+  ASSERT_EQ(offsets[50], SkipNEntriesAndGetOffset(buffer.data(), 0, 50));
+}
+
+TEST (PmemBufferTest, ChunkChecksums) {
+  PmemBuffer* pmem_buffer = new PmemBuffer(BUFFER_PATH_0);
+  pmem_buffer->ClearAll();
+  const uint64_t file_number = 1;
+  char* start = pmem_buffer->GetStartOffset(file_number);
+  std::string chunk1(BUFFER_STREAM_CHUNK_SIZE, 'a');
+  std::string chunk2(1000, 'b');
+  ASSERT_OK(pmem_buffer->StreamWrite(file_number, 0, Slice(chunk1)));
+  ASSERT_OK(pmem_buffer->StreamWrite(file_number, chunk1.size(),
+                                     Slice(chunk2)));
+  pmem_buffer->FinishStreamWrite(file_number, chunk1.size() + chunk2.size());
+
+  const char* chunk_start;
+  const char* chunk_limit;
+  ASSERT_OK(pmem_buffer->VerifyChunk(start + 100, &chunk_start, &chunk_limit));
+  ASSERT_TRUE(chunk_start == start);
+  ASSERT_TRUE(chunk_limit == start + chunk1.size());
+
+  // Not written by a table: nothing to check
+  char* after = start + chunk1.size() + chunk2.size();
+  ASSERT_OK(pmem_buffer->VerifyChunk(after, &chunk_start, &chunk_limit));
+  ASSERT_TRUE(chunk_start == chunk_limit);
+
+  // Media error in the second chunk
+  start[chunk1.size() + 10] ^= 0x1;
+  ASSERT_TRUE(pmem_buffer->VerifyChunk(start + chunk1.size(), &chunk_start,
+                                       &chunk_limit).IsCorruption());
+  // The first chunk was already verified and is not checked again
+  ASSERT_OK(pmem_buffer->VerifyChunk(start, &chunk_start, &chunk_limit));
+
+  // A chunk past the end of the pool is refused, not half written
+  ASSERT_TRUE(pmem_buffer->StreamWrite(file_number, MAX_CONTENTS_SIZE,
+                                       Slice(chunk2)).IsIOError());
+  delete pmem_buffer;
+}
+
+TEST (PmemBufferTest, ExtentReuse) {
+  PmemBuffer* pmem_buffer = new PmemBuffer(MEMTABLE_BUFFER_PATH);
+  pmem_buffer->ClearAll();
+  const size_t size = 1 << 20;
+  char* a = pmem_buffer->AllocateExtent(size);
+  char* b = pmem_buffer->AllocateExtent(size);
+  ASSERT_TRUE(a != nullptr && b != nullptr && a != b);
+
+  // Tables 7 and 8 link records of "a"; 8 also links "b"
+  const char* start;
+  const char* limit;
+  pmem_buffer->LinkExtent(7, a + 10, &start, &limit);
+  ASSERT_TRUE(start == a && limit == a + size);
+  pmem_buffer->LinkExtent(7, a + 20, &start, &limit);
+  pmem_buffer->LinkExtent(8, a + 30, &start, &limit);
+  pmem_buffer->LinkExtent(8, b, &start, &limit);
+  ASSERT_TRUE(start == b);
+  // Outside any extent
+  char c;
+  pmem_buffer->LinkExtent(8, &c, &start, &limit);
+  ASSERT_TRUE(start == limit);
+
+  // The memtables are gone, but the tables still link both extents
+  pmem_buffer->UnrefExtent(a);
+  pmem_buffer->UnrefExtent(b);
+  char* d = pmem_buffer->AllocateExtent(size);
+  ASSERT_TRUE(d != a && d != b);
+
+  pmem_buffer->UnlinkExtents(7);
+  ASSERT_TRUE(pmem_buffer->AllocateExtent(size) != a);
+  pmem_buffer->UnlinkExtents(8);
+  char* e = pmem_buffer->AllocateExtent(size);
+  char* f = pmem_buffer->AllocateExtent(size);
+  ASSERT_TRUE((e == a && f == b) || (e == b && f == a));
+  delete pmem_buffer;
+}
+
 } // namespace leveldb
 
 /* Main */
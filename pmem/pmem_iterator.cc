@@ -5,6 +5,7 @@
  */
 #include <iostream>
 #include "pmem/pmem_iterator.h"
+#include "pmem/pmem_buffer.h"
 
 namespace leveldb {
   /* Structure for skiplist */
@@ -32,19 +33,23 @@ namespace leveldb {
    * Pmem-based Iterator 
    */
   PmemIterator::PmemIterator(PmemSkiplist *pmem_skiplist) 
-    : index_(0), pmem_skiplist_(pmem_skiplist), data_structure(kSkiplist) {
+    : index_(0), pmem_skiplist_(pmem_skiplist), checksum_buffers_(nullptr),
+      verified_start_(nullptr), verified_limit_(nullptr), data_structure(kSkiplist) {
     
   }
   PmemIterator::PmemIterator(int index, PmemSkiplist *pmem_skiplist) 
-    : index_(index), pmem_skiplist_(pmem_skiplist), data_structure(kSkiplist) {
+    : index_(index), pmem_skiplist_(pmem_skiplist), checksum_buffers_(nullptr),
+      verified_start_(nullptr), verified_limit_(nullptr), data_structure(kSkiplist) {
       // printf("[Constructor]New Iterator From Pmem %d\n", index_);
     pmem_skiplist->Ref(index);
   }
   PmemIterator::PmemIterator(PmemHashmap* pmem_hashmap) 
-    : index_(0), pmem_hashmap_(pmem_hashmap), data_structure(kHashmap) {
+    : index_(0), pmem_hashmap_(pmem_hashmap), checksum_buffers_(nullptr),
+      verified_start_(nullptr), verified_limit_(nullptr), data_structure(kHashmap) {
   }
   PmemIterator::PmemIterator(int index, PmemHashmap* pmem_hashmap) 
-    : index_(index), pmem_hashmap_(pmem_hashmap), data_structure(kHashmap) {
+    : index_(index), pmem_hashmap_(pmem_hashmap), checksum_buffers_(nullptr),
+      verified_start_(nullptr), verified_limit_(nullptr), data_structure(kHashmap) {
   }
   PmemIterator::~PmemIterator() {
     // printf("PmemIterator destructor %d\n", index_);
@@ -55,6 +60,8 @@ namespace leveldb {
   }
 
   void PmemIterator::Seek(const Slice& target) {
+    // Cached iterators are shared between lookups: forget earlier errors
+    status_ = Status::OK();
     if (data_structure == kSkiplist) {
       current_ = (pmem_skiplist_->GetOID(index_, (char *)target.data()));
       SetCurrentNode(current_);
@@ -65,6 +72,7 @@ namespace leveldb {
     }
   }
   void PmemIterator::SeekToFirst() {
+    status_ = Status::OK();
     if (data_structure == kSkiplist) {
       current_ = (pmem_skiplist_->GetFirstOID(index_));
       assert(!OID_IS_NULL(*current_));
@@ -80,6 +88,7 @@ namespace leveldb {
   
   }
   void PmemIterator::SeekToLast() {
+    status_ = Status::OK();
       // printf("pmem:seek to last\n");
 
     if (data_structure == kSkiplist) {
@@ -143,6 +152,9 @@ namespace leveldb {
       if (current_node_->entry.buffer_ptr == nullptr) {
         return false;
       }
+      if (!status_.ok()) {
+        return false;
+      }
       uint8_t key_len = GetKeyLengthFromBuffer(current_node_->entry.buffer_ptr);
       return key_len;
     } else if (data_structure == kHashmap) {
@@ -155,7 +167,8 @@ namespace leveldb {
     if (data_structure == kSkiplist) {    
       assert(!OID_IS_NULL(*current_));
       uint32_t key_len;
-      char* ptr = GetKeyAndLengthFromBuffer(current_node_->entry.buffer_ptr, &key_len);
+      char* ptr = GetKeyAndLengthFromBuffer(current_node_->entry.buffer_ptr, &key_len,
+                                            &key_scratch_);
       key_ptr_ = ptr;
       buffer_ptr_ = current_node_->entry.buffer_ptr;
       Slice res((char *)ptr, key_len);
@@ -182,16 +195,19 @@ namespace leveldb {
   Slice PmemIterator::value() const {
     if (data_structure == kSkiplist) {
       assert(!OID_IS_NULL(*current_));
-      uint32_t value_len;
-      char* ptr = GetValueAndLengthFromBuffer(buffer_ptr_, &value_len);
-      Slice res((char *)ptr, value_len);
+      // Values may be stored compressed (Options::pmem_value_compression)
+      Slice res;
+      if (!DecodeValueFromBuffer(buffer_ptr_, &res, &value_scratch_) &&
+          status_.ok()) {
+        status_ = Status::Corruption("corrupted compressed value in pmem");
+      }
       return res;
     } else if (data_structure == kHashmap) {
       // TODO: Implement hashmap-based value()
     }
   }
   Status PmemIterator::status() const {
-    return Status::OK();
+    return status_;
   }
 
   /*--------------------------------------*/
@@ -236,6 +252,26 @@ namespace leveldb {
   }
   void PmemIterator::SetCurrentNode(PMEMoid* current_oid) {
     current_node_ = (struct skiplist_map_node*)pmemobj_direct_latency(*current_oid);
+    if (checksum_buffers_ == nullptr || current_node_ == nullptr) {
+      return;
+    }
+    const char* ptr = current_node_->entry.buffer_ptr;
+    if (ptr == nullptr || (ptr >= verified_start_ && ptr < verified_limit_)) {
+      return;
+    }
+    const char* chunk_start;
+    const char* chunk_limit;
+    Status s = VerifyPmemRecord(checksum_buffers_, ptr,
+                                &chunk_start, &chunk_limit);
+    if (!s.ok()) {
+      if (status_.ok()) status_ = s;
+      return;
+    }
+    verified_start_ = chunk_start;
+    verified_limit_ = chunk_limit;
+  }
+  void PmemIterator::SetChecksumVerification(PmemBuffer** buffers) {
+    checksum_buffers_ = buffers;
   }
   void PmemIterator::SetCurrentEntry(PMEMoid* current_oid) {
     current_entry_ = (struct entry*)pmemobj_direct_latency(*current_oid);
@@ -29,6 +29,7 @@ namespace leveldb {
   struct skiplist_map_entry;
   struct skiplist_map_node; 
   struct entry;
+  class PmemBuffer;
 
   // Choose data-structure options
   enum PmemDataStructrueType {
@@ -86,6 +87,11 @@ namespace leveldb {
     void Ref(uint64_t file_number);
     void UnRef(uint64_t file_number);
 
+    // Check the pmem-buffer chunk checksum of every record the iterator
+    // lands on (ReadOptions::verify_checksums).  "buffers" is
+    // Options::pmem_buffer, or nullptr to stop checking.  Skiplist only.
+    void SetChecksumVerification(PmemBuffer** buffers);
+
    private:
     PmemSkiplist* pmem_skiplist_;
     PmemHashmap* pmem_hashmap_;
@@ -100,6 +106,16 @@ namespace leveldb {
 
     mutable void* key_ptr_;
     mutable char* buffer_ptr_;
+    // Rebuilt copy of the current key, if it is stored prefix-compressed
+    mutable std::string key_scratch_;
+    // Decompressed copy of the current value, if it is stored compressed
+    mutable std::string value_scratch_;
+    mutable Status status_;
+
+    PmemBuffer** checksum_buffers_;
+    // Chunk of the pmem buffer already known to be intact
+    const char* verified_start_;
+    const char* verified_limit_;
 
     const PmemDataStructrueType data_structure; 
 
@@ -3,6 +3,7 @@
  * PMDK-based latency functions
  */
 #include "pmem/pmem_latency.h"
+#include "util/perf_context_imp.h"
 
 namespace leveldb {
 /* Return the UNIX time in nanoseconds */
@@ -33,6 +34,8 @@ void DelayPmemReadNtimes(int n) {
 	// struct timespec interval, remainder;
 	// interval.tv_nsec = READ_DELAY * n;
 	// nanosleep(&interval, &remainder);
+  PERF_TIMER_GUARD(pmem_read_delay_nanos);
+  PERF_COUNTER_ADD(pmem_read_delay_count, n);
   struct timespec base = nstimespec();
   base.tv_nsec += (READ_DELAY * n);
   while (nstimeCompare(base, nstimespec()) == 1) {
@@ -0,0 +1,191 @@
+/*
+ * PMDK-based write-ahead log
+ */
+
+#include "pmem/pmem_log.h"
+
+#include "pmem/pmem_skiplist.h" // file_exists
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+  namespace {
+
+  // Appends go straight to the mapped segment with non-temporal stores.
+  // Flush() drains them and then persists the new length, which is the
+  // commit point of everything appended so far.
+  class PmemLogWriter : public WritableFile {
+   public:
+    PmemLogWriter(PMEMobjpool* pop, char* base, uint64_t* size)
+        : pop_(pop), base_(base), size_(size), pending_(*size) { }
+    virtual ~PmemLogWriter() { }
+
+    virtual Status Append(const Slice& data) {
+      if (pending_ + data.size() > LOG_SEGMENT_SIZE) {
+        return Status::IOError("pmem log segment is full");
+      }
+      pmemobj_memcpy(pop_, base_ + pending_, data.data(), data.size(),
+                     PMEMOBJ_F_MEM_NONTEMPORAL | PMEMOBJ_F_MEM_NODRAIN);
+      pending_ += data.size();
+      return Status::OK();
+    }
+    virtual Status Close() { return Flush(); }
+    virtual Status Flush() {
+      if (pending_ != *size_) {
+        pmemobj_drain(pop_);
+        *size_ = pending_;
+        pmemobj_persist(pop_, size_, sizeof(uint64_t));
+      }
+      return Status::OK();
+    }
+    // Data is durable once flushed; there is no page cache to write back.
+    virtual Status Sync() { return Flush(); }
+
+   private:
+    PMEMobjpool* pop_;
+    char* base_;
+    uint64_t* size_;
+    uint64_t pending_;
+  };
+
+  class PmemLogReader : public SequentialFile {
+   public:
+    PmemLogReader(const char* base, uint64_t size)
+        : base_(base), size_(size), offset_(0) { }
+    virtual ~PmemLogReader() { }
+
+    virtual Status Read(size_t n, Slice* result, char* scratch) {
+      if (n > size_ - offset_) {
+        n = static_cast<size_t>(size_ - offset_);
+      }
+      *result = Slice(base_ + offset_, n);
+      offset_ += n;
+      return Status::OK();
+    }
+    virtual Status Skip(uint64_t n) {
+      if (n > size_ - offset_) {
+        n = size_ - offset_;
+      }
+      offset_ += n;
+      return Status::OK();
+    }
+
+   private:
+    const char* base_;
+    const uint64_t size_;
+    uint64_t offset_;
+  };
+
+  }  // namespace
+
+  PmemLog::PmemLog(std::string pool_path) {
+    if (!file_exists(pool_path)) {
+      log_pool_ = pobj::pool<root_pmem_log>::create (
+                      pool_path, pool_path,
+                      (unsigned long)PMEM_LOG_POOL_SIZE, 0666);
+      root_log_ = log_pool_.get_root();
+
+      pobj::transaction::exec_tx(log_pool_, [&] {
+        root_log_->contents =
+              pobj::make_persistent<char[]>(
+                  (size_t)NUM_OF_LOG_SEGMENTS * LOG_SEGMENT_SIZE);
+        root_log_->segment_number =
+              pobj::make_persistent<uint64_t[]>(NUM_OF_LOG_SEGMENTS);
+        root_log_->segment_size =
+              pobj::make_persistent<uint64_t[]>(NUM_OF_LOG_SEGMENTS);
+      });
+      ClearAll();
+    }
+    // exists
+    else {
+      log_pool_ = pobj::pool<root_pmem_log>::open (
+                      pool_path, pool_path);
+      root_log_ = log_pool_.get_root();
+    }
+  }
+  PmemLog::~PmemLog() {
+    log_pool_.close();
+  }
+
+  char* PmemLog::SegmentStart(int segment) const {
+    return &(root_log_->contents[0]) + (uint64_t)segment * LOG_SEGMENT_SIZE;
+  }
+  int PmemLog::FindSegment(uint64_t number) const {
+    for (int i = 0; i < NUM_OF_LOG_SEGMENTS; i++) {
+      if (root_log_->segment_number[i] == number) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  Status PmemLog::NewLogWriter(uint64_t number, WritableFile** result) {
+    MutexLock l(&mutex_);
+    *result = nullptr;
+    int segment = FindSegment(number);
+    if (segment < 0) {
+      segment = FindSegment(0);
+    }
+    if (segment < 0) {
+      return Status::IOError("no free pmem log segment");
+    }
+    PMEMobjpool* pop = log_pool_.get_handle();
+    // Reset the length before claiming the segment so that a crash in
+    // between never exposes stale records under the new number.
+    uint64_t* size = &(root_log_->segment_size[segment]);
+    *size = 0;
+    pmemobj_persist(pop, size, sizeof(uint64_t));
+    uint64_t* owner = &(root_log_->segment_number[segment]);
+    *owner = number;
+    pmemobj_persist(pop, owner, sizeof(uint64_t));
+
+    *result = new PmemLogWriter(pop, SegmentStart(segment), size);
+    return Status::OK();
+  }
+
+  Status PmemLog::NewLogReader(uint64_t number, SequentialFile** result) {
+    MutexLock l(&mutex_);
+    *result = nullptr;
+    const int segment = FindSegment(number);
+    if (number == 0 || segment < 0) {
+      return Status::NotFound("pmem log segment");
+    }
+    *result = new PmemLogReader(SegmentStart(segment),
+                                root_log_->segment_size[segment]);
+    return Status::OK();
+  }
+
+  void PmemLog::DeleteLog(uint64_t number) {
+    MutexLock l(&mutex_);
+    const int segment = FindSegment(number);
+    if (number == 0 || segment < 0) {
+      return;
+    }
+    uint64_t* owner = &(root_log_->segment_number[segment]);
+    *owner = 0;
+    pmemobj_persist(log_pool_.get_handle(), owner, sizeof(uint64_t));
+  }
+
+  void PmemLog::GetLogNumbers(std::vector<uint64_t>* numbers) {
+    MutexLock l(&mutex_);
+    for (int i = 0; i < NUM_OF_LOG_SEGMENTS; i++) {
+      if (root_log_->segment_number[i] != 0) {
+        numbers->push_back(root_log_->segment_number[i]);
+      }
+    }
+  }
+
+  void PmemLog::ClearAll() {
+    MutexLock l(&mutex_);
+    PMEMobjpool* pop = log_pool_.get_handle();
+    for (int i = 0; i < NUM_OF_LOG_SEGMENTS; i++) {
+      root_log_->segment_number[i] = 0;
+      root_log_->segment_size[i] = 0;
+    }
+    pmemobj_persist(pop, &(root_log_->segment_number[0]),
+                    NUM_OF_LOG_SEGMENTS * sizeof(uint64_t));
+    pmemobj_persist(pop, &(root_log_->segment_size[0]),
+                    NUM_OF_LOG_SEGMENTS * sizeof(uint64_t));
+  }
+
+} // namespace leveldb
@@ -0,0 +1,71 @@
+/*
+ * PMDK-based write-ahead log
+ * A fixed ring of log segments in a single pmemobj pool.  Each live log
+ * number owns one segment; records are copied in with non-temporal stores
+ * and made durable by persisting the segment's length.
+ */
+#ifndef PMEM_LOG_H
+#define PMEM_LOG_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "leveldb/env.h"
+#include "leveldb/status.h"
+#include "pmem/layout.h"
+#include "port/port.h"
+
+// C++
+#include <libpmemobj++/persistent_ptr.hpp>
+#include <libpmemobj++/make_persistent_array.hpp>
+#include <libpmemobj++/transaction.hpp>
+#include <libpmemobj++/pool.hpp>
+#include <libpmemobj.h>
+
+// use pmem with c++ bindings
+namespace pobj = pmem::obj;
+
+namespace leveldb {
+
+  struct root_pmem_log;
+
+  class PmemLog {
+   public:
+    PmemLog(std::string pool_path);
+    ~PmemLog();
+
+    // Claim a free segment for log "number" and return a writer that
+    // appends to it.  The caller should delete "*result" when done; the
+    // segment itself stays allocated until DeleteLog(number).
+    Status NewLogWriter(uint64_t number, WritableFile** result);
+    // Return a reader over the persisted contents of log "number".
+    // Reads are served directly from the mapped pool without copying.
+    Status NewLogReader(uint64_t number, SequentialFile** result);
+    // Release the segment owned by log "number", if any.
+    void DeleteLog(uint64_t number);
+    // Store the numbers of all logs that currently own a segment.
+    void GetLogNumbers(std::vector<uint64_t>* numbers);
+    // Release every segment.
+    void ClearAll();
+
+   private:
+    // REQUIRES: mutex_ held.  Return -1 if not found.
+    int FindSegment(uint64_t number) const;
+    char* SegmentStart(int segment) const;
+
+    port::Mutex mutex_;
+    pobj::pool<root_pmem_log> log_pool_;
+    pobj::persistent_ptr<root_pmem_log> root_log_;
+  };
+
+  /* root structure for accessing pmdk */
+  struct root_pmem_log {
+    pobj::persistent_ptr<char[]> contents;
+    pobj::persistent_ptr<uint64_t[]> segment_number;  // 0 means free
+    pobj::persistent_ptr<uint64_t[]> segment_size;    // persisted bytes
+  };
+
+} // namespace leveldb
+
+#endif
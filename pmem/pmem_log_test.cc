@@ -0,0 +1,104 @@
+// For TEST tool
+#include "util/logging.h"
+#include "util/testharness.h"
+
+// For this test
+#include <stdio.h>
+#include "db/log_reader.h"
+#include "db/log_writer.h"
+#include "pmem/pmem_log.h"
+
+namespace leveldb {
+
+static const char* kPmemLogTestPath = PMEM_LOG_PATH "_test";
+
+class PmemLogTest { };
+
+static std::string BigString(const std::string& partial, size_t n) {
+  std::string result;
+  while (result.size() < n) {
+    result.append(partial);
+  }
+  result.resize(n);
+  return result;
+}
+
+static std::vector<std::string> ReadAll(PmemLog* pmem_log, uint64_t number) {
+  std::vector<std::string> records;
+  SequentialFile* file;
+  ASSERT_OK(pmem_log->NewLogReader(number, &file));
+  log::Reader reader(file, nullptr, true/*checksum*/, 0/*initial_offset*/);
+  std::string scratch;
+  Slice record;
+  while (reader.ReadRecord(&record, &scratch)) {
+    records.push_back(record.ToString());
+  }
+  delete file;
+  return records;
+}
+
+TEST(PmemLogTest, WriteAndReplay) {
+  remove(kPmemLogTestPath);
+  PmemLog* pmem_log = new PmemLog(kPmemLogTestPath);
+
+  WritableFile* file;
+  ASSERT_OK(pmem_log->NewLogWriter(7, &file));
+  log::Writer* writer = new log::Writer(file);
+  ASSERT_OK(writer->AddRecord("foo"));
+  ASSERT_OK(writer->AddRecord(BigString("bar", 100000)));
+  ASSERT_OK(writer->AddRecord(""));
+  ASSERT_OK(file->Sync());
+  delete writer;
+  delete file;
+
+  // Reopen the pool and replay from the mapped segment
+  delete pmem_log;
+  pmem_log = new PmemLog(kPmemLogTestPath);
+  std::vector<uint64_t> numbers;
+  pmem_log->GetLogNumbers(&numbers);
+  ASSERT_EQ(1, numbers.size());
+  ASSERT_EQ(7, numbers[0]);
+
+  std::vector<std::string> records = ReadAll(pmem_log, 7);
+  ASSERT_EQ(3, records.size());
+  ASSERT_EQ("foo", records[0]);
+  ASSERT_EQ(BigString("bar", 100000), records[1]);
+  ASSERT_EQ("", records[2]);
+
+  pmem_log->DeleteLog(7);
+  numbers.clear();
+  pmem_log->GetLogNumbers(&numbers);
+  ASSERT_TRUE(numbers.empty());
+  SequentialFile* missing;
+  ASSERT_TRUE(pmem_log->NewLogReader(7, &missing).IsNotFound());
+
+  delete pmem_log;
+  remove(kPmemLogTestPath);
+}
+
+TEST(PmemLogTest, RingOfSegments) {
+  remove(kPmemLogTestPath);
+  PmemLog* pmem_log = new PmemLog(kPmemLogTestPath);
+
+  WritableFile* file;
+  for (int i = 0; i < NUM_OF_LOG_SEGMENTS; i++) {
+    ASSERT_OK(pmem_log->NewLogWriter(10 + i, &file));
+    delete file;
+  }
+  ASSERT_TRUE(!pmem_log->NewLogWriter(100, &file).ok());
+
+  // A released segment is reused, and starts out empty
+  pmem_log->DeleteLog(10);
+  ASSERT_OK(pmem_log->NewLogWriter(100, &file));
+  delete file;
+  ASSERT_TRUE(ReadAll(pmem_log, 100).empty());
+
+  delete pmem_log;
+  remove(kPmemLogTestPath);
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  return leveldb::test::RunAllTests();
+}
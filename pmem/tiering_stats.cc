@@ -28,9 +28,11 @@ namespace leveldb {
   }
   void Tiering_stats::InsertIntoFileSet(uint64_t number) {
     InsertIntoSet(&file_set, number);
+    generation_++;
   }
   void Tiering_stats::InsertIntoSkiplistSet(uint64_t number) {
     InsertIntoSet(&skiplist_set, number);
+    generation_++;
   }
   
   int DeleteFromSet(std::set<uint64_t>* set, uint64_t number) {
@@ -40,12 +42,14 @@ namespace leveldb {
     if (DeleteFromSet(&file_set, number) <= 0) {
       printf("[WARN][DeleteFromFileSet] no deleted_file %d in file set\n", number);
     }
+    generation_++;
   }
   void Tiering_stats::DeleteFromSkiplistSet(uint64_t number) {
     if (DeleteFromSet(&skiplist_set, number) <= 0) {
       // printf("[WARN][DeleteFromSkiplistSet] no deleted_file %d in skiplist set\n", number);
       DeleteFromFileSet(number);
     }
+    generation_++;
   }
 
   void Tiering_stats::PushToNumberListInPmem(int level, uint64_t number) {
@@ -100,4 +104,7 @@ namespace leveldb {
   uint64_t Tiering_stats::GetSkiplistSetSize() {
     return skiplist_set.size();
   }
+  uint64_t Tiering_stats::Generation() const {
+    return generation_.load(std::memory_order_acquire);
+  }
 } // namespace leveldb
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef TIERING_STATS_H
 #define TIERING_STATS_H
 
+#include <atomic>
 #include <list>
 #include <set>
 #include <stdint.h>
@@ -49,10 +50,15 @@ namespace leveldb {
     uint64_t GetFileSetSize();
     uint64_t GetSkiplistSetSize();
 
+    // Bumped whenever a file enters or leaves one of the sets, so that
+    // the per-Version tier partitions can tell when they are stale.
+    uint64_t Generation() const;
+
    private:
     // Common sets
     std::set<uint64_t> file_set;
     std::set<uint64_t> skiplist_set;
+    std::atomic<uint64_t> generation_{0};
     // ColdDataTiering, LRUTiering 
     std::list<level_number> LRU_fileNumber_list[NUM_OF_SKIPLIST_MANAGER]; // <level, Number> 
   } typedef Tiering_stats;
@@ -124,6 +124,55 @@ bool Snappy_GetUncompressedLength(const char* input, size_t length,
 bool Snappy_Uncompress(const char* input_data, size_t input_length,
                        char* output);
 
+// Store the zstd compression of "input[0,input_length-1]" in *output,
+// at compression "level" and using "dict[0,dict_length-1]" as dictionary
+// (none if dict_length is zero).  Returns false if zstd is not supported
+// by this port.
+bool Zstd_Compress(int level, const char* input, size_t input_length,
+                   std::string* output, const char* dict, size_t dict_length);
+
+// A zstd dictionary prepared once for compressing at "level" (resp. for
+// decompressing), to be shared by all the blocks that use it.
+class ZstdCompressionDict {
+ public:
+  ZstdCompressionDict(const char* dict, size_t dict_length, int level);
+};
+class ZstdDecompressionDict {
+ public:
+  ZstdDecompressionDict(const char* dict, size_t dict_length);
+};
+
+// Like the Zstd_Compress above, with a prepared dictionary.
+bool Zstd_Compress(const ZstdCompressionDict& dict, const char* input,
+                   size_t input_length, std::string* output);
+
+// Like Snappy_GetUncompressedLength, for zstd compressed buffers.
+bool Zstd_GetUncompressedLength(const char* input, size_t length,
+                                size_t* result);
+
+// Like Snappy_Uncompress, for zstd compressed buffers.  "dict" must be
+// the dictionary the buffer was compressed with, if any.
+bool Zstd_Uncompress(const char* input_data, size_t input_length,
+                     char* output, const char* dict, size_t dict_length);
+bool Zstd_Uncompress(const char* input_data, size_t input_length,
+                     char* output, const ZstdDecompressionDict& dict);
+
+// Train a zstd dictionary of at most "max_dict_length" bytes from the
+// samples concatenated in "samples", whose lengths are "sample_lengths",
+// and store it in *dict.  Returns false if zstd is not supported by this
+// port or training failed (e.g. too few samples).
+bool Zstd_TrainDictionary(const std::string& samples,
+                          const std::vector<size_t>& sample_lengths,
+                          size_t max_dict_length, std::string* dict);
+
+// Like the Snappy_* functions, for LZ4 compressed buffers.
+bool Lz4_Compress(const char* input, size_t input_length,
+                  std::string* output);
+bool Lz4_GetUncompressedLength(const char* input, size_t length,
+                               size_t* result);
+bool Lz4_Uncompress(const char* input_data, size_t input_length,
+                    char* output);
+
 // ------------------ Miscellaneous -------------------
 
 // If heap profiling is not supported, returns false.
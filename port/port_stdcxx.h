@@ -28,6 +28,13 @@
 #if HAVE_SNAPPY
 #include <snappy.h>
 #endif  // HAVE_SNAPPY
+#if HAVE_ZSTD
+#include <zdict.h>
+#include <zstd.h>
+#endif  // HAVE_ZSTD
+#if HAVE_LZ4
+#include <lz4.h>
+#endif  // HAVE_LZ4
 
 #include <stddef.h>
 #include <stdint.h>
@@ -35,6 +42,7 @@
 #include <condition_variable>  // NOLINT
 #include <mutex>               // NOLINT
 #include <string>
+#include <vector>
 #include "port/atomic_pointer.h"
 #include "port/thread_annotations.h"
 
@@ -122,13 +130,255 @@ inline bool Snappy_Uncompress(const char* input, size_t length, char* output) {
 #endif  // HAVE_SNAPPY
 }
 
+#if HAVE_ZSTD
+// zstd contexts of the calling thread, created on first use and reused
+// for every block instead of being set up and torn down per call.
+inline ZSTD_CCtx* ZstdThreadCCtx() {
+  struct Holder {
+    ZSTD_CCtx* ctx;
+    Holder() : ctx(ZSTD_createCCtx()) { }
+    ~Holder() { ZSTD_freeCCtx(ctx); }
+  };
+  static thread_local Holder holder;
+  return holder.ctx;
+}
+
+inline ZSTD_DCtx* ZstdThreadDCtx() {
+  struct Holder {
+    ZSTD_DCtx* ctx;
+    Holder() : ctx(ZSTD_createDCtx()) { }
+    ~Holder() { ZSTD_freeDCtx(ctx); }
+  };
+  static thread_local Holder holder;
+  return holder.ctx;
+}
+#endif  // HAVE_ZSTD
+
+// A zstd dictionary digested once for compression at "level", so that
+// the blocks compressed with it do not each re-parse the raw dictionary.
+class ZstdCompressionDict {
+ public:
+  ZstdCompressionDict(const char* dict, size_t dict_length, int level) {
+#if HAVE_ZSTD
+    cdict_ = ZSTD_createCDict(dict, dict_length, level);
+#endif  // HAVE_ZSTD
+  }
+  ~ZstdCompressionDict() {
+#if HAVE_ZSTD
+    ZSTD_freeCDict(cdict_);
+#endif  // HAVE_ZSTD
+  }
+
+  ZstdCompressionDict(const ZstdCompressionDict&) = delete;
+  ZstdCompressionDict& operator=(const ZstdCompressionDict&) = delete;
+
+#if HAVE_ZSTD
+  ZSTD_CDict* get() const { return cdict_; }
+
+ private:
+  ZSTD_CDict* cdict_;
+#endif  // HAVE_ZSTD
+};
+
+// Like ZstdCompressionDict, for decompression.
+class ZstdDecompressionDict {
+ public:
+  ZstdDecompressionDict(const char* dict, size_t dict_length) {
+#if HAVE_ZSTD
+    ddict_ = ZSTD_createDDict(dict, dict_length);
+#endif  // HAVE_ZSTD
+  }
+  ~ZstdDecompressionDict() {
+#if HAVE_ZSTD
+    ZSTD_freeDDict(ddict_);
+#endif  // HAVE_ZSTD
+  }
+
+  ZstdDecompressionDict(const ZstdDecompressionDict&) = delete;
+  ZstdDecompressionDict& operator=(const ZstdDecompressionDict&) = delete;
+
+#if HAVE_ZSTD
+  ZSTD_DDict* get() const { return ddict_; }
+
+ private:
+  ZSTD_DDict* ddict_;
+#endif  // HAVE_ZSTD
+};
+
+inline bool Zstd_Compress(int level, const char* input, size_t length,
+                          ::std::string* output,
+                          const char* dict, size_t dict_length) {
+#if HAVE_ZSTD
+  output->resize(ZSTD_compressBound(length));
+  size_t outlen = ZSTD_compress_usingDict(ZstdThreadCCtx(), &(*output)[0],
+                                          output->size(), input, length,
+                                          dict, dict_length, level);
+  if (ZSTD_isError(outlen)) {
+    return false;
+  }
+  output->resize(outlen);
+  return true;
+#endif  // HAVE_ZSTD
+
+  return false;
+}
+
+inline bool Zstd_Compress(const ZstdCompressionDict& dict, const char* input,
+                          size_t length, ::std::string* output) {
+#if HAVE_ZSTD
+  if (dict.get() == nullptr) {
+    return false;
+  }
+  output->resize(ZSTD_compressBound(length));
+  size_t outlen = ZSTD_compress_usingCDict(ZstdThreadCCtx(), &(*output)[0],
+                                           output->size(), input, length,
+                                           dict.get());
+  if (ZSTD_isError(outlen)) {
+    return false;
+  }
+  output->resize(outlen);
+  return true;
+#endif  // HAVE_ZSTD
+
+  return false;
+}
+
+inline bool Zstd_GetUncompressedLength(const char* input, size_t length,
+                                       size_t* result) {
+#if HAVE_ZSTD
+  unsigned long long size = ZSTD_getFrameContentSize(input, length);
+  if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN) {
+    return false;
+  }
+  *result = static_cast<size_t>(size);
+  return true;
+#else
+  return false;
+#endif  // HAVE_ZSTD
+}
+
+inline bool Zstd_Uncompress(const char* input, size_t length, char* output,
+                            const char* dict, size_t dict_length) {
+#if HAVE_ZSTD
+  size_t ulength;
+  if (!Zstd_GetUncompressedLength(input, length, &ulength)) {
+    return false;
+  }
+  size_t outlen = ZSTD_decompress_usingDict(ZstdThreadDCtx(), output, ulength,
+                                            input, length, dict, dict_length);
+  return !ZSTD_isError(outlen) && outlen == ulength;
+#else
+  return false;
+#endif  // HAVE_ZSTD
+}
+
+inline bool Zstd_Uncompress(const char* input, size_t length, char* output,
+                            const ZstdDecompressionDict& dict) {
+#if HAVE_ZSTD
+  size_t ulength;
+  if (dict.get() == nullptr ||
+      !Zstd_GetUncompressedLength(input, length, &ulength)) {
+    return false;
+  }
+  size_t outlen = ZSTD_decompress_usingDDict(ZstdThreadDCtx(), output,
+                                             ulength, input, length,
+                                             dict.get());
+  return !ZSTD_isError(outlen) && outlen == ulength;
+#else
+  return false;
+#endif  // HAVE_ZSTD
+}
+
+inline bool Zstd_TrainDictionary(const ::std::string& samples,
+                                 const ::std::vector<size_t>& sample_lengths,
+                                 size_t max_dict_length,
+                                 ::std::string* dict) {
+#if HAVE_ZSTD
+  dict->resize(max_dict_length);
+  size_t dict_length = ZDICT_trainFromBuffer(
+      &(*dict)[0], dict->size(), samples.data(), sample_lengths.data(),
+      static_cast<unsigned>(sample_lengths.size()));
+  if (ZDICT_isError(dict_length)) {
+    dict->clear();
+    return false;
+  }
+  dict->resize(dict_length);
+  return true;
+#else
+  return false;
+#endif  // HAVE_ZSTD
+}
+
+// The LZ4 block format does not record the uncompressed length, so it is
+// stored in front of the compressed data as a little-endian uint32.
+inline bool Lz4_Compress(const char* input, size_t length,
+                         ::std::string* output) {
+#if HAVE_LZ4
+  if (length > LZ4_MAX_INPUT_SIZE) {
+    return false;
+  }
+  const int bound = LZ4_compressBound(static_cast<int>(length));
+  output->resize(4 + bound);
+  for (int i = 0; i < 4; i++) {
+    (*output)[i] = static_cast<char>((length >> (8 * i)) & 0xff);
+  }
+  int outlen = LZ4_compress_default(input, &(*output)[4],
+                                    static_cast<int>(length), bound);
+  if (outlen <= 0) {
+    return false;
+  }
+  output->resize(4 + outlen);
+  return true;
+#endif  // HAVE_LZ4
+
+  return false;
+}
+
+inline bool Lz4_GetUncompressedLength(const char* input, size_t length,
+                                      size_t* result) {
+#if HAVE_LZ4
+  if (length < 4) {
+    return false;
+  }
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(input);
+  *result = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8) |
+            (static_cast<size_t>(p[2]) << 16) |
+            (static_cast<size_t>(p[3]) << 24);
+  return true;
+#else
+  return false;
+#endif  // HAVE_LZ4
+}
+
+inline bool Lz4_Uncompress(const char* input, size_t length, char* output) {
+#if HAVE_LZ4
+  size_t ulength;
+  if (!Lz4_GetUncompressedLength(input, length, &ulength)) {
+    return false;
+  }
+  int outlen = LZ4_decompress_safe(input + 4, output,
+                                   static_cast<int>(length - 4),
+                                   static_cast<int>(ulength));
+  return outlen >= 0 && static_cast<size_t>(outlen) == ulength;
+#else
+  return false;
+#endif  // HAVE_LZ4
+}
+
 inline bool GetHeapProfile(void (*func)(void*, const char*, int), void* arg) {
   return false;
 }
 
+#if HAVE_SSE42
+// Defined in port/port_posix_sse.cc.  Returns zero if the CPU lacks SSE4.2.
+uint32_t AcceleratedCRC32C_SSE42(uint32_t crc, const char* buf, size_t size);
+#endif  // HAVE_SSE42
+
 inline uint32_t AcceleratedCRC32C(uint32_t crc, const char* buf, size_t size) {
 #if HAVE_CRC32C
   return ::crc32c::Extend(crc, reinterpret_cast<const uint8_t*>(buf), size);
+#elif HAVE_SSE42
+  return AcceleratedCRC32C_SSE42(crc, buf, size);
 #else
   return 0;
 #endif  // HAVE_CRC32C
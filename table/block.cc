@@ -76,6 +76,8 @@ static inline const char* DecodeEntry(const char* p, const char* limit,
 class Block::Iter : public Iterator {
  private:
   const Comparator* const comparator_;
+  const Slice* const lower_bound_;  // May be nullptr
+  const Slice* const upper_bound_;  // May be nullptr
   const char* const data_;      // underlying block contents
   uint32_t const restarts_;     // Offset of restart array (list of fixed32)
   uint32_t const num_restarts_; // Number of uint32_t entries in restart array
@@ -111,12 +113,35 @@ class Block::Iter : public Iterator {
     value_ = Slice(data_ + offset, 0);
   }
 
+  void MarkInvalid() {
+    current_ = restarts_;
+    restart_index_ = num_restarts_;
+  }
+
+  // Invalidate the iterator if it has moved past one of the bounds.
+  void CheckUpperBound() {
+    if (upper_bound_ != nullptr && Valid() &&
+        Compare(key_, *upper_bound_) >= 0) {
+      MarkInvalid();
+    }
+  }
+  void CheckLowerBound() {
+    if (lower_bound_ != nullptr && Valid() &&
+        Compare(key_, *lower_bound_) < 0) {
+      MarkInvalid();
+    }
+  }
+
  public:
   Iter(const Comparator* comparator,
+       const Slice* lower_bound,
+       const Slice* upper_bound,
        const char* data,
        uint32_t restarts,
        uint32_t num_restarts)
       : comparator_(comparator),
+        lower_bound_(lower_bound),
+        upper_bound_(upper_bound),
         data_(data),
         restarts_(restarts),
         num_restarts_(num_restarts),
@@ -139,11 +164,51 @@ class Block::Iter : public Iterator {
   virtual void Next() {
     assert(Valid());
     ParseNextKey();
+    CheckUpperBound();
   }
 
   virtual void Prev() {
     assert(Valid());
+    PrevInternal();
+    CheckLowerBound();
+  }
+
+  virtual void Seek(const Slice& target) {
+    if (lower_bound_ != nullptr && Compare(target, *lower_bound_) < 0) {
+      SeekInternal(*lower_bound_);
+    } else {
+      SeekInternal(target);
+    }
+    CheckUpperBound();
+  }
+
+  virtual void SeekToFirst() {
+    if (lower_bound_ != nullptr) {
+      SeekInternal(*lower_bound_);
+    } else {
+      SeekToRestartPoint(0);
+      ParseNextKey();
+    }
+    CheckUpperBound();
+  }
 
+  virtual void SeekToLast() {
+    if (upper_bound_ != nullptr) {
+      // Step back from the first entry at or past the upper bound
+      SeekInternal(*upper_bound_);
+      if (Valid()) {
+        PrevInternal();
+      } else if (status_.ok()) {
+        SeekToLastInternal();
+      }
+    } else {
+      SeekToLastInternal();
+    }
+    CheckLowerBound();
+  }
+
+ private:
+  void PrevInternal() {
     // Scan backwards to a restart point before current_
     const uint32_t original = current_;
     while (GetRestartPoint(restart_index_) >= original) {
@@ -162,7 +227,7 @@ class Block::Iter : public Iterator {
     } while (ParseNextKey() && NextEntryOffset() < original);
   }
 
-  virtual void Seek(const Slice& target) {
+  void SeekInternal(const Slice& target) {
     // Binary search in restart array to find the last restart point
     // with a key < target
     uint32_t left = 0;
@@ -202,19 +267,13 @@ class Block::Iter : public Iterator {
     }
   }
 
-  virtual void SeekToFirst() {
-    SeekToRestartPoint(0);
-    ParseNextKey();
-  }
-
-  virtual void SeekToLast() {
+  void SeekToLastInternal() {
     SeekToRestartPoint(num_restarts_ - 1);
     while (ParseNextKey() && NextEntryOffset() < restarts_) {
       // Keep skipping
     }
   }
 
- private:
   void CorruptionError() {
     current_ = restarts_;
     restart_index_ = num_restarts_;
@@ -254,6 +313,12 @@ class Block::Iter : public Iterator {
 };
 
 Iterator* Block::NewIterator(const Comparator* cmp) {
+  return NewIterator(cmp, nullptr, nullptr);
+}
+
+Iterator* Block::NewIterator(const Comparator* cmp,
+                             const Slice* lower_bound,
+                             const Slice* upper_bound) {
   if (size_ < sizeof(uint32_t)) {
     return NewErrorIterator(Status::Corruption("bad block contents"));
   }
@@ -261,7 +326,8 @@ Iterator* Block::NewIterator(const Comparator* cmp) {
   if (num_restarts == 0) {
     return NewEmptyIterator();
   } else {
-    return new Iter(cmp, data_, restart_offset_, num_restarts);
+    return new Iter(cmp, lower_bound, upper_bound,
+                    data_, restart_offset_, num_restarts);
   }
 }
 
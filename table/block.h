@@ -24,6 +24,12 @@ class Block {
   size_t size() const { return size_; }
   Iterator* NewIterator(const Comparator* comparator);
 
+  // Same as above, but the returned iterator only yields keys in
+  // [*lower_bound, *upper_bound).  Either bound may be nullptr.
+  Iterator* NewIterator(const Comparator* comparator,
+                        const Slice* lower_bound,
+                        const Slice* upper_bound);
+
  private:
   uint32_t NumRestarts() const;
 
@@ -9,11 +9,13 @@
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
 #include "leveldb/options.h"
+#include "leveldb/statistics.h"
 #include "table/block.h"
 #include "table/filter_block.h"
 #include "table/format.h"
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
+#include "util/perf_context_imp.h"
 
 namespace leveldb {
 
@@ -22,6 +24,7 @@ struct Table::Rep {
     delete filter;
     delete [] filter_data;
     delete index_block;
+    delete compression_dict;
   }
 
   Options options;
@@ -33,6 +36,13 @@ struct Table::Rep {
 
   BlockHandle metaindex_handle;  // Handle to metaindex_block: saved from footer
   Block* index_block;
+  // True if "file" hands out slices of a mapping (e.g. DAX) rather than
+  // copying into the caller's scratch buffer.
+  bool zero_copy;
+  // False if no level is configured to compress its tables
+  bool may_be_compressed;
+  // zstd dictionary of the data blocks; nullptr if there is none
+  port::ZstdDecompressionDict* compression_dict;
 };
 
 Status Table::Open(const Options& options,
@@ -49,6 +59,7 @@ Status Table::Open(const Options& options,
   Status s = file->Read(size - Footer::kEncodedLength, Footer::kEncodedLength,
                         &footer_input, footer_space);
   if (!s.ok()) return s;
+  const bool zero_copy = (footer_input.data() != footer_space);
 
   Footer footer;
   s = footer.DecodeFrom(&footer_input);
@@ -73,9 +84,17 @@ Status Table::Open(const Options& options,
     rep->file = file;
     rep->metaindex_handle = footer.metaindex_handle();
     rep->index_block = index_block;
+    rep->zero_copy = zero_copy;
+    rep->may_be_compressed = (options.compression != kNoCompression);
+    for (size_t i = 0; i < options.compression_per_level.size(); i++) {
+      if (options.compression_per_level[i] != kNoCompression) {
+        rep->may_be_compressed = true;
+      }
+    }
     rep->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
     rep->filter_data = nullptr;
     rep->filter = nullptr;
+    rep->compression_dict = nullptr;
     *table = new Table(rep);
     (*table)->ReadMeta(footer);
   }
@@ -84,10 +103,6 @@ Status Table::Open(const Options& options,
 }
 
 void Table::ReadMeta(const Footer& footer) {
-  if (rep_->options.filter_policy == nullptr) {
-    return;  // Do not need any metadata
-  }
-
   // TODO(sanjay): Skip this if footer.metaindex_handle() size indicates
   // it is an empty block.
   ReadOptions opt;
@@ -102,11 +117,17 @@ void Table::ReadMeta(const Footer& footer) {
   Block* meta = new Block(contents);
 
   Iterator* iter = meta->NewIterator(BytewiseComparator());
-  std::string key = "filter.";
-  key.append(rep_->options.filter_policy->Name());
-  iter->Seek(key);
-  if (iter->Valid() && iter->key() == Slice(key)) {
-    ReadFilter(iter->value());
+  if (rep_->options.filter_policy != nullptr) {
+    std::string key = "filter.";
+    key.append(rep_->options.filter_policy->Name());
+    iter->Seek(key);
+    if (iter->Valid() && iter->key() == Slice(key)) {
+      ReadFilter(iter->value());
+    }
+  }
+  iter->Seek(kZstdDictBlockName);
+  if (iter->Valid() && iter->key() == Slice(kZstdDictBlockName)) {
+    ReadCompressionDict(iter->value());
   }
   delete iter;
   delete meta;
@@ -135,6 +156,29 @@ void Table::ReadFilter(const Slice& filter_handle_value) {
   rep_->filter = new FilterBlockReader(rep_->options.filter_policy, block.data);
 }
 
+void Table::ReadCompressionDict(const Slice& dict_handle_value) {
+  Slice v = dict_handle_value;
+  BlockHandle dict_handle;
+  if (!dict_handle.DecodeFrom(&v).ok()) {
+    return;
+  }
+
+  ReadOptions opt;
+  if (rep_->options.paranoid_checks) {
+    opt.verify_checksums = true;
+  }
+  BlockContents block;
+  if (!ReadBlock(rep_->file, opt, dict_handle, &block).ok()) {
+    // Data blocks compressed with the dictionary will fail to decompress
+    return;
+  }
+  rep_->compression_dict =
+      new port::ZstdDecompressionDict(block.data.data(), block.data.size());
+  if (block.heap_allocated) {
+    delete[] block.data.data();
+  }
+}
+
 Table::~Table() {
   delete rep_;
 }
@@ -154,6 +198,19 @@ static void ReleaseBlock(void* arg, void* h) {
   cache->Release(handle);
 }
 
+// ReadBlock() for data blocks, charged to the thread's perf context.
+static Status ReadDataBlock(
+    RandomAccessFile* file,
+    const ReadOptions& options,
+    const BlockHandle& handle,
+    BlockContents* contents,
+    const port::ZstdDecompressionDict* compression_dict) {
+  PERF_TIMER_GUARD(block_read_nanos);
+  PERF_COUNTER_ADD(block_read_count, 1);
+  PERF_COUNTER_ADD(block_read_bytes, handle.size());
+  return ReadBlock(file, options, handle, contents, compression_dict);
+}
+
 // Convert an index iterator value (i.e., an encoded BlockHandle)
 // into an iterator over the contents of the corresponding block.
 Iterator* Table::BlockReader(void* arg,
@@ -172,16 +229,23 @@ Iterator* Table::BlockReader(void* arg,
 
   if (s.ok()) {
     BlockContents contents;
-    if (block_cache != nullptr) {
+    // Uncompressed blocks of a zero-copy file are never cached (see
+    // ReadBlock), so do not pay for the lookup either.
+    const bool bypass_cache =
+        table->rep_->zero_copy && !table->rep_->may_be_compressed;
+    if (block_cache != nullptr && !bypass_cache) {
       char cache_key_buffer[16];
       EncodeFixed64(cache_key_buffer, table->rep_->cache_id);
       EncodeFixed64(cache_key_buffer+8, handle.offset());
       Slice key(cache_key_buffer, sizeof(cache_key_buffer));
       cache_handle = block_cache->Lookup(key);
       if (cache_handle != nullptr) {
+        PERF_COUNTER_ADD(block_cache_hit_count, 1);
         block = reinterpret_cast<Block*>(block_cache->Value(cache_handle));
       } else {
-        s = ReadBlock(table->rep_->file, options, handle, &contents);
+        PERF_COUNTER_ADD(block_cache_miss_count, 1);
+        s = ReadDataBlock(table->rep_->file, options, handle, &contents,
+                          table->rep_->compression_dict);
         if (s.ok()) {
           block = new Block(contents);
           if (contents.cachable && options.fill_cache) {
@@ -191,7 +255,8 @@ Iterator* Table::BlockReader(void* arg,
         }
       }
     } else {
-      s = ReadBlock(table->rep_->file, options, handle, &contents);
+      s = ReadDataBlock(table->rep_->file, options, handle, &contents,
+                        table->rep_->compression_dict);
       if (s.ok()) {
         block = new Block(contents);
       }
@@ -200,7 +265,9 @@ Iterator* Table::BlockReader(void* arg,
 
   Iterator* iter;
   if (block != nullptr) {
-    iter = block->NewIterator(table->rep_->options.comparator);
+    iter = block->NewIterator(table->rep_->options.comparator,
+                              options.iterate_lower_bound,
+                              options.iterate_upper_bound);
     if (cache_handle == nullptr) {
       iter->RegisterCleanup(&DeleteBlock, block, nullptr);
     } else {
@@ -215,7 +282,8 @@ Iterator* Table::BlockReader(void* arg,
 Iterator* Table::NewIterator(const ReadOptions& options) const {
   return NewTwoLevelIterator(
       rep_->index_block->NewIterator(rep_->options.comparator),
-      &Table::BlockReader, const_cast<Table*>(this), options);
+      &Table::BlockReader, const_cast<Table*>(this), options,
+      rep_->options.comparator);
 }
 
 /* TODO: Compaction based on pmem */
@@ -224,7 +292,8 @@ Iterator* Table::NewIteratorFromPmem(
                     
   return NewTwoLevelIterator(
       rep_->index_block->NewIterator(rep_->options.comparator),
-      &Table::BlockReader, const_cast<Table*>(this), options);
+      &Table::BlockReader, const_cast<Table*>(this), options,
+      rep_->options.comparator);
 }
 
 Status Table::InternalGet(const ReadOptions& options, const Slice& k,
@@ -232,16 +301,27 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k,
                           void (*saver)(void*, const Slice&, const Slice&)) {
   Status s;
   Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
+  PERF_TIMER_GUARD(index_seek_nanos);
   iiter->Seek(k);
+  PERF_TIMER_STOP(index_seek_nanos);
   // printf("[DEBUG InternalGet1]'%s' \n", k.data());
   if (iiter->Valid()) {
     Slice handle_value = iiter->value();
   // printf("[DEBUG InternalGet2]'%s' \n", handle_value.data());
     FilterBlockReader* filter = rep_->filter;
+    Statistics* statistics = rep_->options.statistics;
     BlockHandle handle;
-    if (filter != nullptr &&
-        handle.DecodeFrom(&handle_value).ok() &&
-        !filter->KeyMayMatch(handle.offset(), k)) {
+    bool filtered = false;
+    if (filter != nullptr && handle.DecodeFrom(&handle_value).ok()) {
+      PERF_TIMER_GUARD(filter_nanos);
+      filtered = !filter->KeyMayMatch(handle.offset(), k);
+      PERF_TIMER_STOP(filter_nanos);
+      if (statistics != nullptr) {
+        statistics->RecordTick(kBloomFilterChecked);
+        if (filtered) statistics->RecordTick(kBloomFilterUseful);
+      }
+    }
+    if (filtered) {
       // Not found
     } else {
       Iterator* block_iter = BlockReader(this, options, iiter->value());
@@ -262,6 +342,45 @@ Status Table::InternalGet(const ReadOptions& options, const Slice& k,
 }
 
 
+void Table::Prefetch(const Slice& key) const {
+  if (rep_->zero_copy) {
+    return;  // Nothing to wait for
+  }
+  Iterator* index_iter =
+      rep_->index_block->NewIterator(rep_->options.comparator);
+  index_iter->Seek(key);
+  if (index_iter->Valid()) {
+    BlockHandle handle;
+    Slice input = index_iter->value();
+    if (handle.DecodeFrom(&input).ok() &&
+        (rep_->filter == nullptr ||
+         rep_->filter->KeyMayMatch(handle.offset(), key))) {
+      Cache* block_cache = rep_->options.block_cache;
+      Cache::Handle* cache_handle = nullptr;
+      if (block_cache != nullptr) {
+        char cache_key_buffer[16];
+        EncodeFixed64(cache_key_buffer, rep_->cache_id);
+        EncodeFixed64(cache_key_buffer+8, handle.offset());
+        cache_handle = block_cache->Lookup(
+            Slice(cache_key_buffer, sizeof(cache_key_buffer)));
+      }
+      if (cache_handle != nullptr) {
+        block_cache->Release(cache_handle);
+      } else {
+        rep_->file->Prefetch(handle.offset(),
+                             handle.size() + kBlockTrailerSize);
+      }
+    }
+  }
+  delete index_iter;
+}
+
+void Table::PrefetchAll(uint64_t file_size) const {
+  if (!rep_->zero_copy) {
+    rep_->file->Prefetch(0, file_size);
+  }
+}
+
 uint64_t Table::ApproximateOffsetOf(const Slice& key) const {
   Iterator* index_iter =
       rep_->index_block->NewIterator(rep_->options.comparator);
@@ -5,15 +5,19 @@
 #include "leveldb/table_builder.h"
 
 #include <assert.h>
+#include <vector>
 #include "leveldb/comparator.h"
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
 #include "leveldb/options.h"
+#include "leveldb/statistics.h"
 #include "table/block_builder.h"
 #include "table/filter_block.h"
 #include "table/format.h"
 #include "util/coding.h"
+#include "port/port.h"
 #include "util/crc32c.h"
+#include "util/trace_imp.h"
 
 namespace leveldb {
 
@@ -33,7 +37,16 @@ struct TableBuilder::Rep {
   char* start_offset;
   uint64_t buffer_offset;
   bool first_addition_flag;
-  std::string buffer;
+  std::string buffer;           // Chunk not yet streamed to the pmem-buffer
+  uint64_t buffer_streamed;     // Bytes already streamed to the pmem-buffer
+  // Key prefix compression (see Options::pmem_key_restart_interval)
+  std::string restart_key;      // Key of the last full record
+  uint64_t restart_offset;      // buffer_offset of the last full record
+  int records_since_restart;
+  // Memtable extent the last record linked by pointer is in (see
+  // PmemBuffer::LinkExtent)
+  const char* linked_start;
+  const char* linked_limit;
 
   // We do not emit the index entry for a block until we have seen the
   // first key for the next data block.  This allows us to use shorter
@@ -49,6 +62,13 @@ struct TableBuilder::Rep {
 
   std::string compressed_output;
 
+  // zstd dictionary training (see Options::zstd_max_dict_bytes)
+  bool dict_done;                    // Trained, or not wanted
+  std::string dict_samples;          // Raw data blocks sampled so far
+  std::vector<size_t> dict_sample_lengths;
+  std::string compression_dict;      // Used for data blocks once trained
+  port::ZstdCompressionDict* compression_cdict;  // compression_dict, digested
+
   Rep(const Options& opt, WritableFile* f)
       : options(opt),
         index_block_options(opt),
@@ -58,14 +78,20 @@ struct TableBuilder::Rep {
         index_block(&index_block_options),
         num_entries(0),
         closed(false),
+        filter_block(opt.filter_policy == nullptr ? nullptr
+                     : new FilterBlockBuilder(opt.filter_policy)),
         // JH
         start_offset(nullptr),
         buffer_offset(0),
         first_addition_flag(true),
-
-        filter_block(opt.filter_policy == nullptr ? nullptr
-                     : new FilterBlockBuilder(opt.filter_policy)),
-        pending_index_entry(false) {
+        buffer_streamed(0),
+        restart_offset(0),
+        records_since_restart(0),
+        linked_start(nullptr),
+        linked_limit(nullptr),
+        pending_index_entry(false),
+        dict_done(opt.zstd_max_dict_bytes == 0),
+        compression_cdict(nullptr) {
     index_block_options.block_restart_interval = 1;
   }
 };
@@ -80,6 +106,7 @@ TableBuilder::TableBuilder(const Options& options, WritableFile* file)
 TableBuilder::~TableBuilder() {
   assert(rep_->closed);  // Catch errors where caller forgot to call Finish()
   delete rep_->filter_block;
+  delete rep_->compression_cdict;
   rep_->buffer.clear();
   delete rep_;
 }
@@ -185,17 +212,60 @@ void TableBuilder::AddToBufferAndSkiplist(
   }
 
   // Add to buffer
-  EncodeToBuffer(&r->buffer, key, value);
-  int total_length = GetEncodedLength(key.size(), value.size());
+  int total_length;
+  const int restart_interval = r->options.pmem_key_restart_interval;
+  const bool delta = restart_interval > 0 && !r->restart_key.empty() &&
+                     r->records_since_restart < restart_interval;
+  if (delta) {
+    total_length = EncodeDeltaToBuffer(&r->buffer, key, value,
+                                       Slice(r->restart_key),
+                                       r->buffer_offset - r->restart_offset,
+                                       r->options.pmem_value_compression,
+                                       r->options.zstd_compression_level);
+    r->records_since_restart++;
+  } else if (r->options.pmem_value_compression != kNoCompression) {
+    total_length = EncodeCompressedToBuffer(&r->buffer, key, value,
+                                            r->options.pmem_value_compression,
+                                            r->options.zstd_compression_level);
+  } else {
+    EncodeToBuffer(&r->buffer, key, value);
+    total_length = GetEncodedLength(key.size(), value.size());
+  }
+  if (restart_interval > 0 && !delta) {
+    // Written in full: the next records may store their keys against it
+    r->restart_key.assign(key.data(), key.size());
+    r->restart_offset = r->buffer_offset;
+    r->records_since_restart = 1;
+  }
+  MaybeStreamBuffer(pmem_buffer, number);
+  if (!ok()) return;
 
   // Add to pmem_skiplist
-  pmem_skiplist->Insert((char *)key.data(), r->start_offset + r->buffer_offset, 
-                        key.size(), number, refTimes /*zewei*/ );
+  {
+    TRACE_SPAN("pmem.insert");
+    pmem_skiplist->Insert((char *)key.data(), r->start_offset + r->buffer_offset, 
+                          key.size(), number, refTimes /*zewei*/ );
+  }
 
   // printf("start_offset %d '%d', total_length\n", r->start_offset, total_length);
   r->offset += (total_length);
   r->buffer_offset += (total_length);
 }
+// Stream the staged chunk to the pmem-buffer once it is large enough, so
+// the whole table is never staged in DRAM.  The skiplist/hashmap entries
+// already point at the final pmem location of each record, so a chunk
+// that cannot be written fails the table (see status()).
+void TableBuilder::MaybeStreamBuffer(PmemBuffer* pmem_buffer, uint64_t number) {
+  Rep* r = rep_;
+  if (r->buffer.size() >= BUFFER_STREAM_CHUNK_SIZE) {
+    TRACE_SPAN("pmem.flush");
+    r->status = pmem_buffer->StreamWrite(number, r->buffer_streamed,
+                                         Slice(r->buffer));
+    if (!r->status.ok()) return;
+    r->buffer_streamed += r->buffer.size();
+    r->buffer.clear();
+  }
+}
 void TableBuilder::FlushBufferToPmemBuffer(PmemBuffer* pmem_buffer, uint64_t number) {
   Rep* r = rep_;
   assert(!r->closed);
@@ -207,10 +277,25 @@ void TableBuilder::FlushBufferToPmemBuffer(PmemBuffer* pmem_buffer, uint64_t num
     // abort();
   }
   */
+  if (r->first_addition_flag) {
+    // Every entry was linked by pointer (AddToSkiplistByPtr); nothing to copy
+    return;
+  }
+  TRACE_SPAN("pmem.flush");
   Slice buffer_wrapper(r->buffer);
   // printf("[DEBUG %d] '%s'\n",buffer_wrapper.size(), buffer_wrapper.data()); // 3,555,846
   // printf("[Sequential_write] file_number %d\n", number);
-  pmem_buffer->SequentialWrite(number, buffer_wrapper);
+  if (!buffer_wrapper.empty()) {
+    r->status = pmem_buffer->StreamWrite(number, r->buffer_streamed,
+                                         buffer_wrapper);
+    if (!r->status.ok()) return;
+    r->buffer_streamed += buffer_wrapper.size();
+    r->buffer.clear();
+  }
+  pmem_buffer->FinishStreamWrite(number, r->buffer_streamed);
+  if (r->options.statistics != nullptr) {
+    r->options.statistics->RecordTick(kPmemBytesWritten, r->buffer_streamed);
+  }
 }
 void TableBuilder::AddToSkiplistByPtr(PmemSkiplist* pmem_skiplist, uint64_t number,
                     const Slice& key, const Slice& value,
@@ -224,7 +309,14 @@ void TableBuilder::AddToSkiplistByPtr(PmemSkiplist* pmem_skiplist, uint64_t numb
   r->last_key.assign(key.data(), key.size());
   r->num_entries++;
   r->offset += (key.size() + value.size());
+  if (r->options.use_pmem_memtable &&
+      (buffer_ptr < r->linked_start || buffer_ptr >= r->linked_limit)) {
+    r->options.pmem_memtable_buffer->LinkExtent(number, buffer_ptr,
+                                                &r->linked_start,
+                                                &r->linked_limit);
+  }
 
+  TRACE_SPAN("pmem.insert");
   pmem_skiplist->InsertByPtr(buffer_ptr, key.size(), number, refTimes /*zewei*/);
 }
 
@@ -251,6 +343,8 @@ void TableBuilder::AddToBufferAndHashmap(
   // Add to buffer
   EncodeToBuffer(&r->buffer, key, value);
   int total_length = GetEncodedLength(key.size(), value.size());
+  MaybeStreamBuffer(pmem_buffer, number);
+  if (!ok()) return;
   // printf("%d %d] total_length %d\n", key.size(), value.size(), total_length);
   // Add to pmem_skiplist
   pmem_hashmap->Insert((char *)key.data(), r->start_offset + r->offset, 
@@ -296,29 +390,51 @@ void TableBuilder::WriteBlock(BlockBuilder* block, BlockHandle* handle) {
   //    type: uint8
   //    crc: uint32
   assert(ok());
+  TRACE_SPAN("sst.write_block");
   Rep* r = rep_;
   Slice raw = block->Finish();
 
   Slice block_contents;
   CompressionType type = r->options.compression;
+  std::string* compressed = &r->compressed_output;
+  bool compressed_ok = false;
   // TODO(postrelease): Support more compression options: zlib?
   switch (type) {
     case kNoCompression:
       block_contents = raw;
       break;
 
-    case kSnappyCompression: {
-      std::string* compressed = &r->compressed_output;
-      if (port::Snappy_Compress(raw.data(), raw.size(), compressed) &&
-          compressed->size() < raw.size() - (raw.size() / 8u)) {
-        block_contents = *compressed;
+    case kSnappyCompression:
+      compressed_ok = port::Snappy_Compress(raw.data(), raw.size(), compressed);
+      break;
+
+    case kZstdCompression:
+      if (!r->dict_done) {
+        SampleForDictionary(raw);
+      }
+      if (r->compression_cdict != nullptr) {
+        compressed_ok = port::Zstd_Compress(*r->compression_cdict, raw.data(),
+                                            raw.size(), compressed);
       } else {
-        // Snappy not supported, or compressed less than 12.5%, so just
-        // store uncompressed form
-        block_contents = raw;
-        type = kNoCompression;
+        compressed_ok = port::Zstd_Compress(r->options.zstd_compression_level,
+                                            raw.data(), raw.size(),
+                                            compressed, nullptr, 0);
       }
       break;
+
+    case kLZ4Compression:
+      compressed_ok = port::Lz4_Compress(raw.data(), raw.size(), compressed);
+      break;
+  }
+  if (type != kNoCompression) {
+    if (compressed_ok &&
+        compressed->size() < raw.size() - (raw.size() / 8u)) {
+      block_contents = *compressed;
+    } else {
+      // Compression not supported, or compressed less than 12.5%, so just
+      // store uncompressed form
+      block_contents = raw;
+      type = kNoCompression;
     }
   }
   WriteRawBlock(block_contents, type, handle);
@@ -326,6 +442,32 @@ void TableBuilder::WriteBlock(BlockBuilder* block, BlockHandle* handle) {
   block->Reset();
 }
 
+// Collect raw data blocks until there are enough to train a dictionary of
+// options.zstd_max_dict_bytes, then train it.  Blocks written before that
+// are compressed without a dictionary.
+void TableBuilder::SampleForDictionary(const Slice& raw) {
+  static const size_t kTrainingRatio = 8;  // Sample bytes per dictionary byte
+  Rep* r = rep_;
+  r->dict_samples.append(raw.data(), raw.size());
+  r->dict_sample_lengths.push_back(raw.size());
+  if (r->dict_samples.size() <
+      kTrainingRatio * r->options.zstd_max_dict_bytes) {
+    return;
+  }
+  if (!port::Zstd_TrainDictionary(r->dict_samples, r->dict_sample_lengths,
+                                  r->options.zstd_max_dict_bytes,
+                                  &r->compression_dict)) {
+    r->compression_dict.clear();  // Go on without a dictionary
+  } else {
+    r->compression_cdict = new port::ZstdCompressionDict(
+        r->compression_dict.data(), r->compression_dict.size(),
+        r->options.zstd_compression_level);
+  }
+  r->dict_done = true;
+  std::string().swap(r->dict_samples);
+  std::vector<size_t>().swap(r->dict_sample_lengths);
+}
+
 void TableBuilder::WriteRawBlock(const Slice& block_contents,
                                  CompressionType type,
                                  BlockHandle* handle) {
@@ -353,7 +495,6 @@ Status TableBuilder::status() const {
 Status TableBuilder::FinishPmem() {
   Rep* r = rep_;
   r->pending_index_entry = false;
-  r->status = Status::OK();
   assert(!r->closed);
   r->closed = true;
   return r->status;
@@ -368,6 +509,20 @@ Status TableBuilder::Finish() {
   r->closed = true;
 
   BlockHandle filter_block_handle, metaindex_block_handle, index_block_handle;
+  BlockHandle dict_block_handle;
+
+  // Only data blocks use the dictionary: the index and metaindex blocks
+  // are read before it.
+  r->dict_done = true;
+  std::string compression_dict;
+  compression_dict.swap(r->compression_dict);
+  delete r->compression_cdict;
+  r->compression_cdict = nullptr;
+
+  // Write zstd dictionary
+  if (ok() && !compression_dict.empty()) {
+    WriteRawBlock(compression_dict, kNoCompression, &dict_block_handle);
+  }
 
   // Write filter block
   if (ok() && r->filter_block != nullptr) {
@@ -386,6 +541,12 @@ Status TableBuilder::Finish() {
       filter_block_handle.EncodeTo(&handle_encoding);
       meta_index_block.Add(key, handle_encoding);
     }
+    if (!compression_dict.empty()) {
+      // Keys of the metaindex block must be added in sorted order
+      std::string handle_encoding;
+      dict_block_handle.EncodeTo(&handle_encoding);
+      meta_index_block.Add(kZstdDictBlockName, handle_encoding);
+    }
 
     // TODO(postrelease): Add stats and other meta blocks
     WriteBlock(&meta_index_block, &metaindex_block_handle);
@@ -432,4 +593,8 @@ uint64_t TableBuilder::FileSize() const {
   return rep_->offset;
 }
 
+uint64_t TableBuilder::PmemBytesWritten() const {
+  return rep_->buffer_streamed;
+}
+
 }  // namespace leveldb
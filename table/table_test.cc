@@ -869,6 +869,74 @@ TEST(TableTest, ApproximateOffsetOfCompressed) {
   ASSERT_TRUE(Between(c.ApproximateOffsetOf("xyz"), 2 * min_z, 2 * max_z));
 }
 
+static bool CompressionSupported(CompressionType type) {
+  std::string out;
+  Slice in = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa";
+  switch (type) {
+    case kZstdCompression:
+      return port::Zstd_Compress(1, in.data(), in.size(), &out, nullptr, 0);
+    case kLZ4Compression:
+      return port::Lz4_Compress(in.data(), in.size(), &out);
+    default:
+      return port::Snappy_Compress(in.data(), in.size(), &out);
+  }
+}
+
+static void CheckCompressedRoundTrip(const Options& options) {
+  Random rnd(301);
+  TableConstructor c(BytewiseComparator());
+  std::string tmp;
+  for (int i = 0; i < 1000; i++) {
+    char key[20];
+    snprintf(key, sizeof(key), "k%06d", i);
+    c.Add(key, test::CompressibleString(&rnd, 0.25, 200, &tmp));
+  }
+  std::vector<std::string> keys;
+  KVMap kvmap;
+  c.Finish(options, &keys, &kvmap);
+
+  // The table is opened with default options: the block types and the
+  // dictionary are read from the file itself.
+  ASSERT_LT(c.ApproximateOffsetOf("xyz"), 1000 * 200 / 2);
+  Iterator* iter = c.NewIterator();
+  iter->SeekToFirst();
+  for (KVMap::const_iterator it = kvmap.begin(); it != kvmap.end(); ++it) {
+    ASSERT_TRUE(iter->Valid());
+    ASSERT_EQ(it->first, iter->key().ToString());
+    ASSERT_EQ(it->second, iter->value().ToString());
+    iter->Next();
+  }
+  ASSERT_TRUE(!iter->Valid());
+  ASSERT_OK(iter->status());
+  delete iter;
+}
+
+TEST(TableTest, ZstdAndLZ4Compression) {
+  const CompressionType kTypes[] = { kZstdCompression, kLZ4Compression };
+  for (size_t i = 0; i < sizeof(kTypes) / sizeof(kTypes[0]); i++) {
+    if (!CompressionSupported(kTypes[i])) {
+      fprintf(stderr, "skipping compression type %d\n", kTypes[i]);
+      continue;
+    }
+    Options options;
+    options.block_size = 1024;
+    options.compression = kTypes[i];
+    CheckCompressedRoundTrip(options);
+  }
+}
+
+TEST(TableTest, ZstdDictionary) {
+  if (!CompressionSupported(kZstdCompression)) {
+    fprintf(stderr, "skipping zstd dictionary test\n");
+    return;
+  }
+  Options options;
+  options.block_size = 1024;
+  options.compression = kZstdCompression;
+  options.zstd_max_dict_bytes = 4096;
+  CheckCompressedRoundTrip(options);
+}
+
 }  // namespace leveldb
 
 int main(int argc, char** argv) {
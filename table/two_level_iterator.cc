@@ -4,6 +4,8 @@
 
 #include "table/two_level_iterator.h"
 
+#include "leveldb/comparator.h"
+#include "leveldb/options.h"
 #include "leveldb/table.h"
 #include "table/block.h"
 #include "table/format.h"
@@ -21,7 +23,8 @@ class TwoLevelIterator: public Iterator {
     Iterator* index_iter,
     BlockFunction block_function,
     void* arg,
-    const ReadOptions& options);
+    const ReadOptions& options,
+    const Comparator* comparator);
 
   virtual ~TwoLevelIterator();
 
@@ -62,9 +65,23 @@ class TwoLevelIterator: public Iterator {
   void SetDataIterator(Iterator* data_iter);
   void InitDataBlock();
 
+  // Every key in the current block is >= the upper bound, or < the
+  // lower bound.  Used to stop before opening blocks outside the range.
+  bool IndexPastUpperBound() const {
+    return (options_.iterate_upper_bound != nullptr &&
+            comparator_->Compare(index_iter_.key(),
+                                 *options_.iterate_upper_bound) >= 0);
+  }
+  bool IndexBeforeLowerBound() const {
+    return (options_.iterate_lower_bound != nullptr &&
+            comparator_->Compare(index_iter_.key(),
+                                 *options_.iterate_lower_bound) < 0);
+  }
+
   BlockFunction block_function_;
   void* arg_;
   const ReadOptions options_;
+  const Comparator* const comparator_;
   Status status_;
   IteratorWrapper index_iter_;
   IteratorWrapper data_iter_; // May be nullptr
@@ -77,10 +94,12 @@ TwoLevelIterator::TwoLevelIterator(
     Iterator* index_iter,
     BlockFunction block_function,
     void* arg,
-    const ReadOptions& options)
+    const ReadOptions& options,
+    const Comparator* comparator)
     : block_function_(block_function),
       arg_(arg),
       options_(options),
+      comparator_(comparator),
       index_iter_(index_iter),
       data_iter_(nullptr) {
 }
@@ -89,29 +108,42 @@ TwoLevelIterator::~TwoLevelIterator() {
 }
 
 void TwoLevelIterator::Seek(const Slice& target) {
-  index_iter_.Seek(target);
+  const Slice* lower = options_.iterate_lower_bound;
+  if (lower != nullptr && comparator_->Compare(target, *lower) < 0) {
+    index_iter_.Seek(*lower);
+  } else {
+    index_iter_.Seek(target);
+  }
   InitDataBlock();
   if (data_iter_.iter() != nullptr) data_iter_.Seek(target);
   SkipEmptyDataBlocksForward();
 }
 
 void TwoLevelIterator::SeekToFirst() {
-  index_iter_.SeekToFirst();
+  if (options_.iterate_lower_bound != nullptr) {
+    index_iter_.Seek(*options_.iterate_lower_bound);
+  } else {
+    index_iter_.SeekToFirst();
+  }
   InitDataBlock();
   if (data_iter_.iter() != nullptr) data_iter_.SeekToFirst();
   SkipEmptyDataBlocksForward();
 }
 
 void TwoLevelIterator::SeekToLast() {
-  printf("two level iterator: seek to last\n");
-  index_iter_.SeekToLast();
-  printf("t1\n");
+  // The first block whose index key reaches the upper bound is the
+  // last one that may still hold keys below it.
+  if (options_.iterate_upper_bound != nullptr) {
+    index_iter_.Seek(*options_.iterate_upper_bound);
+    if (!index_iter_.Valid() && index_iter_.status().ok()) {
+      index_iter_.SeekToLast();
+    }
+  } else {
+    index_iter_.SeekToLast();
+  }
   InitDataBlock();
-  printf("t2\n");
   if (data_iter_.iter() != nullptr) data_iter_.SeekToLast();
-  printf("t3\n");
   SkipEmptyDataBlocksBackward();
-  printf("t4\n");
 }
 
 void TwoLevelIterator::Next() {
@@ -130,7 +162,7 @@ void TwoLevelIterator::Prev() {
 void TwoLevelIterator::SkipEmptyDataBlocksForward() {
   while (data_iter_.iter() == nullptr || !data_iter_.Valid()) {
     // Move to next block
-    if (!index_iter_.Valid()) {
+    if (!index_iter_.Valid() || IndexPastUpperBound()) {
       SetDataIterator(nullptr);
       return;
     }
@@ -148,6 +180,10 @@ void TwoLevelIterator::SkipEmptyDataBlocksBackward() {
       return;
     }
     index_iter_.Prev();
+    if (index_iter_.Valid() && IndexBeforeLowerBound()) {
+      SetDataIterator(nullptr);
+      return;
+    }
     InitDataBlock();
     if (data_iter_.iter() != nullptr) data_iter_.SeekToLast();
   }
@@ -180,8 +216,10 @@ Iterator* NewTwoLevelIterator(
     Iterator* index_iter,
     BlockFunction block_function,
     void* arg,
-    const ReadOptions& options) {
-  return new TwoLevelIterator(index_iter, block_function, arg, options);
+    const ReadOptions& options,
+    const Comparator* comparator) {
+  return new TwoLevelIterator(index_iter, block_function, arg, options,
+                              comparator);
 }
 
 }  // namespace leveldb
@@ -6,6 +6,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <atomic>
+#include <vector>
+
 #include "leveldb/cache.h"
 #include "port/port.h"
 #include "port/thread_annotations.h"
@@ -19,7 +22,7 @@ Cache::~Cache() {
 
 namespace {
 
-// LRU cache implementation
+// Segmented LRU cache implementation
 //
 // Cache entries have an "in_cache" boolean indicating whether the cache has a
 // reference on the entry.  The only ways that this can become false without the
@@ -27,30 +30,49 @@ namespace {
 // an element with a duplicate key is inserted, or on destruction of the cache.
 //
 // The cache keeps two linked lists of items in the cache.  All items in the
-// cache are in one list or the other, and never both.  Items still referenced
-// by clients but erased from the cache are in neither list.  The lists are:
-// - in-use:  contains the items currently referenced by clients, in no
-//   particular order.  (This list is used for invariant checking.  If we
-//   removed the check, elements that would otherwise be on this list could be
-//   left as disconnected singleton lists.)
-// - LRU:  contains the items not currently referenced by clients, in LRU order
-// Elements are moved between these lists by the Ref() and Unref() methods,
-// when they detect an element in the cache acquiring or losing its only
-// external reference.
+// cache are in exactly one list, whether or not clients reference them.
+// Items still referenced by clients but erased from the cache are in no
+// list.  The lists are:
+// - probation:  items that have not been promoted since they were
+//   inserted, in insertion order.
+// - protected:  items that were looked up again while on probation.
+//
+// Lookup hits and Release() do not take the shard mutex.  A hit walks the
+// hash chain lock-free, takes a reference with a compare-and-swap on
+// "refs" and sets the entry's "referenced" bit; nothing else is written.
+// The lists are only edited under the mutex by Insert(), which sweeps
+// them like a CLOCK hand when the shard is over capacity: entries in use
+// by clients are passed over, and entries whose referenced bit is set get
+// a second chance -- probationary ones by moving into the protected
+// segment.  Eviction takes probationary items first, so a long scan that
+// touches every item only once cycles through the probation list and
+// leaves the protected (repeatedly used) items alone.  The protected list
+// is capped at kProtectedPercent of the capacity; overflow is demoted
+// back to probation.
+//
+// A lock-free reader may still hold a pointer to an entry that a writer
+// has just removed, so entry memory is never returned to malloc while the
+// shard lives: freed entries go to a per-size free list and are reused by
+// later inserts.  Readers only dereference "hash", "next_hash" and "refs"
+// before they own a reference, and check the key and "in_cache" after.
 
 // An entry is a variable length heap-allocated structure.  Entries
 // are kept in a circular doubly linked list ordered by access time.
 struct LRUHandle {
   void* value;
   void (*deleter)(const Slice&, void* value);
-  LRUHandle* next_hash;
+  std::atomic<LRUHandle*> next_hash;
   LRUHandle* next;
   LRUHandle* prev;
   size_t charge;      // TODO(opt): Only allow uint32_t?
   size_t key_length;
-  bool in_cache;      // Whether entry is in the cache.
-  uint32_t refs;      // References, including cache reference, if present.
-  uint32_t hash;      // Hash of key(); used for fast sharding and comparisons
+  std::atomic<bool> in_cache;    // Whether entry is in the cache.
+  std::atomic<bool> referenced;  // Looked up since the last eviction sweep.
+  bool in_protected;  // Whether entry belongs to the protected segment.
+  uint8_t key_class;  // Free list this entry returns to; see KeyClass().
+  std::atomic<uint32_t> refs;  // References, including cache reference.
+  std::atomic<uint32_t> hash;  // Hash of key(); used for sharding and
+                               // comparisons
   char key_data[1];   // Beginning of key
 
   Slice key() const {
@@ -67,23 +89,37 @@ struct LRUHandle {
 // table implementations in some of the compiler/runtime combinations
 // we have tested.  E.g., readrandom speeds up by ~5% over the g++
 // 4.4.3's builtin hashtable.
+//
+// Insert, Remove and Lookup require the owner's mutex; Head() does not.
+// Slots are published with release stores, and a bucket array replaced
+// by Resize() is kept until the table is destroyed, so a reader that
+// loaded it earlier can still finish its walk.
 class HandleTable {
  public:
-  HandleTable() : length_(0), elems_(0), list_(nullptr) { Resize(); }
-  ~HandleTable() { delete[] list_; }
+  HandleTable() : elems_(0), buckets_(nullptr) { Resize(); }
+  ~HandleTable() {
+    for (size_t i = 0; i < retired_.size(); i++) {
+      delete retired_[i];
+    }
+    delete buckets_.load(std::memory_order_relaxed);
+  }
 
   LRUHandle* Lookup(const Slice& key, uint32_t hash) {
-    return *FindPointer(key, hash);
+    return FindPointer(key, hash)->load(std::memory_order_relaxed);
   }
 
   LRUHandle* Insert(LRUHandle* h) {
-    LRUHandle** ptr = FindPointer(h->key(), h->hash);
-    LRUHandle* old = *ptr;
-    h->next_hash = (old == nullptr ? nullptr : old->next_hash);
-    *ptr = h;
+    std::atomic<LRUHandle*>* ptr =
+        FindPointer(h->key(), h->hash.load(std::memory_order_relaxed));
+    LRUHandle* old = ptr->load(std::memory_order_relaxed);
+    h->next_hash.store(
+        old == nullptr ? nullptr
+                       : old->next_hash.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    ptr->store(h, std::memory_order_release);
     if (old == nullptr) {
       ++elems_;
-      if (elems_ > length_) {
+      if (elems_ > buckets_.load(std::memory_order_relaxed)->length) {
         // Since each cache entry is fairly large, we aim for a small
         // average linked list length (<= 1).
         Resize();
@@ -93,30 +129,52 @@ class HandleTable {
   }
 
   LRUHandle* Remove(const Slice& key, uint32_t hash) {
-    LRUHandle** ptr = FindPointer(key, hash);
-    LRUHandle* result = *ptr;
+    std::atomic<LRUHandle*>* ptr = FindPointer(key, hash);
+    LRUHandle* result = ptr->load(std::memory_order_relaxed);
     if (result != nullptr) {
-      *ptr = result->next_hash;
+      // result->next_hash is left intact for readers standing on result.
+      ptr->store(result->next_hash.load(std::memory_order_relaxed),
+                 std::memory_order_release);
       --elems_;
     }
     return result;
   }
 
+  // Return the first entry of the chain for "hash" without locking.  The
+  // chain may change under the caller, who must tolerate missing an
+  // entry and must bound its walk.
+  LRUHandle* Head(uint32_t hash) const {
+    const Buckets* b = buckets_.load(std::memory_order_acquire);
+    return b->list[hash & (b->length - 1)].load(std::memory_order_acquire);
+  }
+
  private:
   // The table consists of an array of buckets where each bucket is
   // a linked list of cache entries that hash into the bucket.
-  uint32_t length_;
+  struct Buckets {
+    explicit Buckets(uint32_t n)
+        : length(n), list(new std::atomic<LRUHandle*>[n]()) { }
+    ~Buckets() { delete[] list; }
+
+    const uint32_t length;
+    std::atomic<LRUHandle*>* const list;
+  };
+
   uint32_t elems_;
-  LRUHandle** list_;
+  std::atomic<Buckets*> buckets_;
+  std::vector<Buckets*> retired_;
 
   // Return a pointer to slot that points to a cache entry that
   // matches key/hash.  If there is no such cache entry, return a
   // pointer to the trailing slot in the corresponding linked list.
-  LRUHandle** FindPointer(const Slice& key, uint32_t hash) {
-    LRUHandle** ptr = &list_[hash & (length_ - 1)];
-    while (*ptr != nullptr &&
-           ((*ptr)->hash != hash || key != (*ptr)->key())) {
-      ptr = &(*ptr)->next_hash;
+  std::atomic<LRUHandle*>* FindPointer(const Slice& key, uint32_t hash) {
+    Buckets* b = buckets_.load(std::memory_order_relaxed);
+    std::atomic<LRUHandle*>* ptr = &b->list[hash & (b->length - 1)];
+    LRUHandle* h;
+    while ((h = ptr->load(std::memory_order_relaxed)) != nullptr &&
+           (h->hash.load(std::memory_order_relaxed) != hash ||
+            key != h->key())) {
+      ptr = &h->next_hash;
     }
     return ptr;
   }
@@ -126,25 +184,27 @@ class HandleTable {
     while (new_length < elems_) {
       new_length *= 2;
     }
-    LRUHandle** new_list = new LRUHandle*[new_length];
-    memset(new_list, 0, sizeof(new_list[0]) * new_length);
+    Buckets* old = buckets_.load(std::memory_order_relaxed);
+    Buckets* b = new Buckets(new_length);
     uint32_t count = 0;
-    for (uint32_t i = 0; i < length_; i++) {
-      LRUHandle* h = list_[i];
+    for (uint32_t i = 0; old != nullptr && i < old->length; i++) {
+      LRUHandle* h = old->list[i].load(std::memory_order_relaxed);
       while (h != nullptr) {
-        LRUHandle* next = h->next_hash;
-        uint32_t hash = h->hash;
-        LRUHandle** ptr = &new_list[hash & (new_length - 1)];
-        h->next_hash = *ptr;
-        *ptr = h;
+        LRUHandle* next = h->next_hash.load(std::memory_order_relaxed);
+        uint32_t hash = h->hash.load(std::memory_order_relaxed);
+        std::atomic<LRUHandle*>* ptr = &b->list[hash & (new_length - 1)];
+        h->next_hash.store(ptr->load(std::memory_order_relaxed),
+                           std::memory_order_release);
+        ptr->store(h, std::memory_order_relaxed);
         h = next;
         count++;
       }
     }
     assert(elems_ == count);
-    delete[] list_;
-    list_ = new_list;
-    length_ = new_length;
+    buckets_.store(b, std::memory_order_release);
+    if (old != nullptr) {
+      retired_.push_back(old);
+    }
   }
 };
 
@@ -155,7 +215,10 @@ class LRUCache {
   ~LRUCache();
 
   // Separate from constructor so caller can easily make an array of LRUCache
-  void SetCapacity(size_t capacity) { capacity_ = capacity; }
+  void SetCapacity(size_t capacity) {
+    capacity_ = capacity;
+    protected_capacity_ = capacity * kProtectedPercent / 100;
+  }
 
   // Like Cache methods, but with an extra "hash" parameter.
   Cache::Handle* Insert(const Slice& key, uint32_t hash,
@@ -173,72 +236,188 @@ class LRUCache {
  private:
   void LRU_Remove(LRUHandle* e);
   void LRU_Append(LRUHandle*list, LRUHandle* e);
-  void Ref(LRUHandle* e);
-  void Unref(LRUHandle* e);
+  LRUHandle* LookupLockFree(const Slice& key, uint32_t hash);
+  void Unref(LRUHandle* e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void Free(LRUHandle* e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  LRUHandle* Allocate(size_t key_size) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void EvictOverflow() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  void DemoteOverflow() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   bool FinishErase(LRUHandle* e) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Take a reference on e unless it is already being freed.
+  static bool TryRef(LRUHandle* e) {
+    uint32_t r = e->refs.load(std::memory_order_relaxed);
+    while (r != 0) {
+      if (e->refs.compare_exchange_weak(r, r + 1,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Key storage is rounded up to 16 << KeyClass(n) bytes, so a freed
+  // entry fits any later key of its class.
+  static int KeyClass(size_t n) {
+    int c = 0;
+    while ((size_t(16) << c) < n) {
+      c++;
+    }
+    return c;
+  }
+
+  // Share of the capacity that the protected segment may hold.
+  static const size_t kProtectedPercent = 80;
+
+  // Bound on the chain entries a lock-free lookup visits before it falls
+  // back to the mutex; chains average one entry.
+  static const int kMaxLockFreeSteps = 16;
+
+  static const int kNumKeyClasses = 8 * sizeof(size_t) - 3;
+
   // Initialized before use.
   size_t capacity_;
+  size_t protected_capacity_;
 
   // mutex_ protects the following state.
   mutable port::Mutex mutex_;
   size_t usage_ GUARDED_BY(mutex_);
+  size_t protected_usage_ GUARDED_BY(mutex_);
+  size_t entries_ GUARDED_BY(mutex_);
 
-  // Dummy head of LRU list.
-  // lru.prev is newest entry, lru.next is oldest entry.
-  // Entries have refs==1 and in_cache==true.
-  LRUHandle lru_ GUARDED_BY(mutex_);
+  // Dummy head of probation list.
+  // probation.prev is newest entry, probation.next is oldest entry.
+  // Entries have in_cache==true and in_protected==false.
+  LRUHandle probation_ GUARDED_BY(mutex_);
 
-  // Dummy head of in-use list.
-  // Entries are in use by clients, and have refs >= 2 and in_cache==true.
-  LRUHandle in_use_ GUARDED_BY(mutex_);
+  // Dummy head of protected list.
+  // protected.prev is newest entry, protected.next is oldest entry.
+  // Entries have in_cache==true and in_protected==true.
+  LRUHandle protected_ GUARDED_BY(mutex_);
 
-  HandleTable table_ GUARDED_BY(mutex_);
+  // Freed entries, by KeyClass().  Entries have refs==0.
+  std::vector<LRUHandle*> free_[kNumKeyClasses] GUARDED_BY(mutex_);
+
+  HandleTable table_;  // Writers hold mutex_
 };
 
 LRUCache::LRUCache()
-    : usage_(0) {
+    : capacity_(0),
+      protected_capacity_(0),
+      usage_(0),
+      protected_usage_(0),
+      entries_(0) {
   // Make empty circular linked lists.
-  lru_.next = &lru_;
-  lru_.prev = &lru_;
-  in_use_.next = &in_use_;
-  in_use_.prev = &in_use_;
+  probation_.next = &probation_;
+  probation_.prev = &probation_;
+  protected_.next = &protected_;
+  protected_.prev = &protected_;
 }
 
 LRUCache::~LRUCache() {
-  assert(in_use_.next == &in_use_);  // Error if caller has an unreleased handle
-  for (LRUHandle* e = lru_.next; e != &lru_; ) {
-    LRUHandle* next = e->next;
-    assert(e->in_cache);
-    e->in_cache = false;
-    assert(e->refs == 1);  // Invariant of lru_ list.
-    Unref(e);
-    e = next;
+  LRUHandle* lists[2] = { &probation_, &protected_ };
+  for (int i = 0; i < 2; i++) {
+    for (LRUHandle* e = lists[i]->next; e != lists[i]; ) {
+      LRUHandle* next = e->next;
+      assert(e->in_cache);
+      e->in_cache.store(false, std::memory_order_relaxed);
+      // Error if caller has an unreleased handle
+      assert(e->refs.load(std::memory_order_relaxed) == 1);
+      (*e->deleter)(e->key(), e->value);
+      free(e);
+      e = next;
+    }
+  }
+  for (int c = 0; c < kNumKeyClasses; c++) {
+    for (size_t i = 0; i < free_[c].size(); i++) {
+      free(free_[c][i]);
+    }
   }
 }
 
-void LRUCache::Ref(LRUHandle* e) {
-  if (e->refs == 1 && e->in_cache) {  // If on lru_ list, move to in_use_ list.
-    LRU_Remove(e);
-    LRU_Append(&in_use_, e);
+void LRUCache::Unref(LRUHandle* e) {
+  assert(e->refs.load(std::memory_order_relaxed) > 0);
+  if (e->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    Free(e);
   }
-  e->refs++;
 }
 
-void LRUCache::Unref(LRUHandle* e) {
-  assert(e->refs > 0);
-  e->refs--;
-  // printf("Unref %d\n", e->refs);
-  if (e->refs == 0) {  // Deallocate.
-    // printf("opt1\n");
-    assert(!e->in_cache);
-    (*e->deleter)(e->key(), e->value);
-    free(e);
-  } else if (e->in_cache && e->refs == 1) {
-    // printf("opt2\n");
-    // No longer in use; move to lru_ list.
-    LRU_Remove(e);
-    LRU_Append(&lru_, e);
+// Pass *e, whose last reference is gone, to its deleter and keep its
+// memory for reuse; see the comment at the top of this file.
+void LRUCache::Free(LRUHandle* e) {
+  assert(!e->in_cache);
+  (*e->deleter)(Slice(e->key_data, e->key_length), e->value);
+  free_[e->key_class].push_back(e);
+}
+
+LRUHandle* LRUCache::Allocate(size_t key_size) {
+  const int c = KeyClass(key_size);
+  if (!free_[c].empty()) {
+    LRUHandle* e = free_[c].back();
+    free_[c].pop_back();
+    return e;
+  }
+  LRUHandle* e = reinterpret_cast<LRUHandle*>(
+      malloc(sizeof(LRUHandle)-1 + (size_t(16) << c)));
+  e->next_hash.store(nullptr, std::memory_order_relaxed);
+  e->in_cache.store(false, std::memory_order_relaxed);
+  e->referenced.store(false, std::memory_order_relaxed);
+  e->refs.store(0, std::memory_order_relaxed);
+  e->key_class = c;
+  return e;
+}
+
+// Move the oldest protected entries back to probation while the
+// protected segment is over its share of the capacity.
+void LRUCache::DemoteOverflow() {
+  while (protected_usage_ > protected_capacity_ &&
+         protected_.next != &protected_) {
+    LRUHandle* old = protected_.next;
+    old->in_protected = false;
+    protected_usage_ -= old->charge;
+    LRU_Remove(old);
+    LRU_Append(&probation_, old);
+  }
+}
+
+// Evict entries until usage_ fits the capacity, sweeping probation and
+// then the protected segment from their oldest entries.  Each sweep is
+// bounded, so a shard whose entries are all in use stays over capacity
+// until they are released, as before.
+void LRUCache::EvictOverflow() {
+  size_t steps = entries_;
+  while (usage_ > capacity_ && probation_.next != &probation_ &&
+         steps-- > 0) {
+    LRUHandle* e = probation_.next;
+    if (e->referenced.load(std::memory_order_relaxed)) {
+      e->referenced.store(false, std::memory_order_relaxed);
+      e->in_protected = true;
+      protected_usage_ += e->charge;
+      LRU_Remove(e);
+      LRU_Append(&protected_, e);
+      DemoteOverflow();
+    } else if (e->refs.load(std::memory_order_relaxed) > 1) {
+      LRU_Remove(e);
+      LRU_Append(&probation_, e);
+    } else {
+      FinishErase(table_.Remove(e->key(),
+                                e->hash.load(std::memory_order_relaxed)));
+    }
+  }
+  steps = 2 * entries_;
+  while (usage_ > capacity_ && protected_.next != &protected_ &&
+         steps-- > 0) {
+    LRUHandle* e = protected_.next;
+    if (e->referenced.load(std::memory_order_relaxed) ||
+        e->refs.load(std::memory_order_relaxed) > 1) {
+      e->referenced.store(false, std::memory_order_relaxed);
+      LRU_Remove(e);
+      LRU_Append(&protected_, e);
+    } else {
+      FinishErase(table_.Remove(e->key(),
+                                e->hash.load(std::memory_order_relaxed)));
+    }
   }
 }
 
@@ -255,18 +434,54 @@ void LRUCache::LRU_Append(LRUHandle* list, LRUHandle* e) {
   e->next->prev = e;
 }
 
+// Find key and take a reference without the mutex.  Returns nullptr on a
+// miss and also when a concurrent writer got in the way; the caller then
+// looks again under the mutex.
+LRUHandle* LRUCache::LookupLockFree(const Slice& key, uint32_t hash) {
+  LRUHandle* e = table_.Head(hash);
+  for (int steps = 0; e != nullptr && steps < kMaxLockFreeSteps; steps++) {
+    if (e->hash.load(std::memory_order_relaxed) == hash && TryRef(e)) {
+      // The reference keeps e from being freed and reused, so its key
+      // is stable now.
+      if (e->in_cache.load(std::memory_order_acquire) &&
+          Slice(e->key_data, e->key_length) == key) {
+        return e;
+      }
+      if (e->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // It was erased meanwhile and ours was the last reference.
+        MutexLock l(&mutex_);
+        Free(e);
+        return nullptr;
+      }
+    }
+    e = e->next_hash.load(std::memory_order_acquire);
+  }
+  return nullptr;
+}
+
 Cache::Handle* LRUCache::Lookup(const Slice& key, uint32_t hash) {
-  MutexLock l(&mutex_);
-  LRUHandle* e = table_.Lookup(key, hash);
-  if (e != nullptr) {
-    Ref(e);
+  LRUHandle* e = LookupLockFree(key, hash);
+  if (e == nullptr) {
+    MutexLock l(&mutex_);
+    e = table_.Lookup(key, hash);
+    if (e != nullptr) {
+      e->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  if (e != nullptr && !e->referenced.load(std::memory_order_relaxed)) {
+    e->referenced.store(true, std::memory_order_relaxed);
   }
   return reinterpret_cast<Cache::Handle*>(e);
 }
 
 void LRUCache::Release(Cache::Handle* handle) {
-  MutexLock l(&mutex_);
-  Unref(reinterpret_cast<LRUHandle*>(handle));
+  LRUHandle* e = reinterpret_cast<LRUHandle*>(handle);
+  assert(e->refs.load(std::memory_order_relaxed) > 0);
+  if (e->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // The entry already left the cache; only freeing needs the mutex.
+    MutexLock l(&mutex_);
+    Free(e);
+  }
 }
 
 Cache::Handle* LRUCache::Insert(
@@ -274,34 +489,33 @@ Cache::Handle* LRUCache::Insert(
     void (*deleter)(const Slice& key, void* value)) {
   MutexLock l(&mutex_);
 
-  LRUHandle* e = reinterpret_cast<LRUHandle*>(
-      malloc(sizeof(LRUHandle)-1 + key.size()));
+  LRUHandle* e = Allocate(key.size());
   e->value = value;
   e->deleter = deleter;
   e->charge = charge;
   e->key_length = key.size();
-  e->hash = hash;
-  e->in_cache = false;
-  e->refs = 1;  // for the returned handle.
+  e->hash.store(hash, std::memory_order_relaxed);
+  e->in_protected = false;
+  e->referenced.store(false, std::memory_order_relaxed);
   memcpy(e->key_data, key.data(), key.size());
 
   if (capacity_ > 0) {
-    e->refs++;  // for the cache's reference.
-    e->in_cache = true;
-    LRU_Append(&in_use_, e);
+    e->in_cache.store(true, std::memory_order_relaxed);
+    // One for the returned handle, one for the cache's reference.  The
+    // release store publishes the fields above to stale lock-free readers.
+    e->refs.store(2, std::memory_order_release);
+    LRU_Append(&probation_, e);
     usage_ += charge;
+    entries_++;
     FinishErase(table_.Insert(e));
   } else {  // don't cache. (capacity_==0 is supported and turns off caching.)
+    e->in_cache.store(false, std::memory_order_relaxed);
+    e->refs.store(1, std::memory_order_release);  // for the returned handle.
     // next is read by key() in an assert, so it must be initialized
     e->next = nullptr;
   }
-  while (usage_ > capacity_ && lru_.next != &lru_) {
-    LRUHandle* old = lru_.next;
-    assert(old->refs == 1);
-    bool erased = FinishErase(table_.Remove(old->key(), old->hash));
-    if (!erased) {  // to avoid unused variable when compiled NDEBUG
-      assert(erased);
-    }
+  if (usage_ > capacity_) {
+    EvictOverflow();
   }
 
   return reinterpret_cast<Cache::Handle*>(e);
@@ -313,8 +527,13 @@ bool LRUCache::FinishErase(LRUHandle* e) {
   if (e != nullptr) {
     assert(e->in_cache);
     LRU_Remove(e);
-    e->in_cache = false;
+    e->in_cache.store(false, std::memory_order_relaxed);
     usage_ -= e->charge;
+    entries_--;
+    if (e->in_protected) {
+      e->in_protected = false;
+      protected_usage_ -= e->charge;
+    }
     Unref(e);
   }
   return e != nullptr;
@@ -327,17 +546,25 @@ void LRUCache::Erase(const Slice& key, uint32_t hash) {
 
 void LRUCache::Prune() {
   MutexLock l(&mutex_);
-  while (lru_.next != &lru_) {
-    LRUHandle* e = lru_.next;
-    assert(e->refs == 1);
-    bool erased = FinishErase(table_.Remove(e->key(), e->hash));
-    if (!erased) {  // to avoid unused variable when compiled NDEBUG
-      assert(erased);
+  LRUHandle* lists[2] = { &probation_, &protected_ };
+  for (int i = 0; i < 2; i++) {
+    for (LRUHandle* e = lists[i]->next; e != lists[i]; ) {
+      LRUHandle* next = e->next;
+      if (e->refs.load(std::memory_order_relaxed) == 1) {
+        bool erased = FinishErase(
+            table_.Remove(e->key(), e->hash.load(std::memory_order_relaxed)));
+        if (!erased) {  // to avoid unused variable when compiled NDEBUG
+          assert(erased);
+        }
+      }
+      e = next;
     }
   }
 }
 
-static const int kNumShardBits = 4;
+// More shards than stock leveldb: Insert and Erase take the shard mutex,
+// so writers on many threads mostly hit different locks.
+static const int kNumShardBits = 6;
 static const int kNumShards = 1 << kNumShardBits;
 
 class ShardedLRUCache : public Cache {
@@ -374,7 +601,7 @@ class ShardedLRUCache : public Cache {
   }
   virtual void Release(Handle* handle) {
     LRUHandle* h = reinterpret_cast<LRUHandle*>(handle);
-    shard_[Shard(h->hash)].Release(handle);
+    shard_[Shard(h->hash.load(std::memory_order_relaxed))].Release(handle);
   }
   virtual void Erase(const Slice& key) {
     const uint32_t hash = HashSlice(key);
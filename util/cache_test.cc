@@ -4,6 +4,8 @@
 
 #include "leveldb/cache.h"
 
+#include <atomic>
+#include <thread>
 #include <vector>
 #include "util/coding.h"
 #include "util/testharness.h"
@@ -156,6 +158,21 @@ TEST(CacheTest, EvictionPolicy) {
   cache_->Release(h);
 }
 
+TEST(CacheTest, ScanResistance) {
+  // Entries that have been looked up again must survive a scan that
+  // inserts many more entries than the cache can hold, each only once.
+  for (int i = 0; i < 100; i++) {
+    Insert(i, 100+i);
+    ASSERT_EQ(100+i, Lookup(i));
+  }
+  for (int i = 0; i < 2*kCacheSize; i++) {
+    Insert(1000+i, 2000+i);
+  }
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(100+i, Lookup(i));
+  }
+}
+
 TEST(CacheTest, UseExceedsCacheSize) {
   // Overfill the cache, keeping handles on all inserted entries.
   std::vector<Cache::Handle*> h;
@@ -200,6 +217,46 @@ TEST(CacheTest, HeavyEntries) {
   ASSERT_LE(cached_weight, kCacheSize + kCacheSize/10);
 }
 
+static std::atomic<int> concurrent_deleted;
+
+static void ConcurrentDeleter(const Slice& key, void* v) {
+  ASSERT_EQ(DecodeKey(key), DecodeValue(v) / 1000);
+  concurrent_deleted.fetch_add(1);
+}
+
+TEST(CacheTest, ConcurrentLookups) {
+  // Lookups run without the shard mutex while other threads insert,
+  // erase and evict; every hit must see the value stored for its key and
+  // every inserted value must reach its deleter exactly once.
+  concurrent_deleted.store(0);
+  Cache* cache = NewLRUCache(kCacheSize / 4);
+  std::atomic<int> inserted(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([cache, t, &inserted]() {
+      for (int i = 0; i < 20000; i++) {
+        const int key = (i * 7 + t * 13) % 500;
+        Cache::Handle* h = cache->Lookup(EncodeKey(key));
+        if (h != nullptr) {
+          ASSERT_EQ(key, DecodeValue(cache->Value(h)) / 1000);
+          cache->Release(h);
+        } else if (i % 5 == 0) {
+          cache->Erase(EncodeKey(key));
+        } else {
+          cache->Release(cache->Insert(EncodeKey(key),
+                                       EncodeValue(key * 1000 + t), 1,
+                                       &ConcurrentDeleter));
+          inserted.fetch_add(1);
+        }
+      }
+    });
+  }
+  for (size_t t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+  delete cache;
+  ASSERT_EQ(inserted.load(), concurrent_deleted.load());
+}
 TEST(CacheTest, NewId) {
   uint64_t a = cache_->NewId();
   uint64_t b = cache_->NewId();
@@ -187,6 +187,16 @@ class PosixRandomAccessFile: public RandomAccessFile {
     }
     return s;
   }
+
+  // Queue asynchronous readahead; the page cache then serves Read().
+  virtual void Prefetch(uint64_t offset, size_t n) const {
+#if defined(POSIX_FADV_WILLNEED)
+    if (!temporary_fd_) {
+      posix_fadvise(fd_, static_cast<off_t>(offset), static_cast<off_t>(n),
+                    POSIX_FADV_WILLNEED);
+    }
+#endif
+  }
 };
 
 // mmap() based random-access
@@ -350,6 +360,127 @@ class PosixWritableFile : public WritableFile {
   }
 };
 
+// Writable file opened with O_DIRECT.  Writes go from an aligned buffer
+// straight to the device in multiples of kDirectIOAlignment, so table
+// files written by compactions do not evict hot pages from the page cache.
+// The unaligned tail stays in the buffer until Sync() or Close(), which
+// write it zero-padded and then truncate the file to its logical size.
+class PosixDirectWritableFile : public WritableFile {
+ private:
+  std::string filename_;
+  int fd_;
+  char* buf_;            // kDirectBufSize bytes, kDirectIOAlignment-aligned
+  size_t pos_;           // buf_[0, pos_-1] is not yet written
+  uint64_t file_offset_; // Offset of buf_[0] in the file; always aligned
+
+ public:
+  static const size_t kDirectIOAlignment = 4096;
+  static const size_t kDirectBufSize = 1 << 20;
+
+  PosixDirectWritableFile(const std::string& fname, int fd, char* buf)
+      : filename_(fname), fd_(fd), buf_(buf), pos_(0), file_offset_(0) { }
+
+  ~PosixDirectWritableFile() {
+    if (fd_ >= 0) {
+      // Ignoring any potential errors
+      Close();
+    }
+    free(buf_);
+  }
+
+  virtual Status Append(const Slice& data) {
+    size_t n = data.size();
+    const char* p = data.data();
+    while (n > 0) {
+      size_t copy = std::min(n, kDirectBufSize - pos_);
+      memcpy(buf_ + pos_, p, copy);
+      p += copy;
+      n -= copy;
+      pos_ += copy;
+      if (pos_ == kDirectBufSize) {
+        Status s = WriteAligned();
+        if (!s.ok()) {
+          return s;
+        }
+      }
+    }
+    return Status::OK();
+  }
+
+  virtual Status Close() {
+    Status result = WriteTail();
+    const int r = close(fd_);
+    if (r < 0 && result.ok()) {
+      result = PosixError(filename_, errno);
+    }
+    fd_ = -1;
+    return result;
+  }
+
+  // Only whole aligned blocks can be written; the tail waits for Sync().
+  virtual Status Flush() {
+    return WriteAligned();
+  }
+
+  virtual Status Sync() {
+    Status s = WriteTail();
+    if (s.ok()) {
+      if (fdatasync(fd_) != 0) {
+        s = PosixError(filename_, errno);
+      }
+    }
+    return s;
+  }
+
+ private:
+  // Write the aligned prefix of buf_ and move the remainder to the front.
+  Status WriteAligned() {
+    const size_t n = pos_ - (pos_ % kDirectIOAlignment);
+    if (n == 0) {
+      return Status::OK();
+    }
+    Status s = WriteRaw(buf_, n, file_offset_);
+    if (s.ok()) {
+      memmove(buf_, buf_ + n, pos_ - n);
+      pos_ -= n;
+      file_offset_ += n;
+    }
+    return s;
+  }
+
+  // Write everything, padding the tail block with zeroes, and cut the file
+  // back to its logical size.  The tail stays buffered: the next write
+  // rewrites that block in place.
+  Status WriteTail() {
+    Status s = WriteAligned();
+    if (!s.ok() || pos_ == 0) {
+      return s;
+    }
+    memset(buf_ + pos_, 0, kDirectIOAlignment - pos_);
+    s = WriteRaw(buf_, kDirectIOAlignment, file_offset_);
+    if (s.ok() && ftruncate(fd_, file_offset_ + pos_) != 0) {
+      s = PosixError(filename_, errno);
+    }
+    return s;
+  }
+
+  Status WriteRaw(const char* p, size_t n, uint64_t offset) {
+    while (n > 0) {
+      ssize_t r = pwrite(fd_, p, n, static_cast<off_t>(offset));
+      if (r < 0) {
+        if (errno == EINTR) {
+          continue;  // Retry
+        }
+        return PosixError(filename_, errno);
+      }
+      p += r;
+      n -= r;
+      offset += r;
+    }
+    return Status::OK();
+  }
+};
+
 static int LockOrUnlock(int fd, bool lock) {
   errno = 0;
   struct flock f;
@@ -413,6 +544,8 @@ class PosixEnv : public Env {
     int fd = open(fname.c_str(), O_RDONLY);
     if (fd < 0) {
       s = PosixError(fname, errno);
+    } else if (NewDaxReadableFile(fname, fd, result)) {
+      close(fd);
     } else if (mmap_limit_.Acquire()) {
       uint64_t size;
       s = GetFileSize(fname, &size);
@@ -460,6 +593,29 @@ class PosixEnv : public Env {
     return s;
   }
 
+  virtual Status NewDirectWritableFile(const std::string& fname,
+                                       WritableFile** result) {
+#if defined(O_DIRECT)
+    int fd = open(fname.c_str(), O_TRUNC | O_WRONLY | O_CREAT | O_DIRECT, 0644);
+    if (fd >= 0) {
+      void* buf = nullptr;
+      if (posix_memalign(&buf,
+                         PosixDirectWritableFile::kDirectIOAlignment,
+                         PosixDirectWritableFile::kDirectBufSize) == 0) {
+        *result = new PosixDirectWritableFile(fname, fd,
+                                              static_cast<char*>(buf));
+        return Status::OK();
+      }
+      close(fd);
+    } else if (errno != EINVAL) {
+      *result = nullptr;
+      return PosixError(fname, errno);
+    }
+    // The filesystem (e.g. tmpfs) does not support O_DIRECT
+#endif  // defined(O_DIRECT)
+    return NewWritableFile(fname, result);
+  }
+
   virtual bool FileExists(const std::string& fname) {
     return access(fname.c_str(), F_OK) == 0;
   }
@@ -628,8 +784,35 @@ class PosixEnv : public Env {
   typedef std::deque<BGItem> BGQueue;
   BGQueue queue_;
 
+  // JH: Files on a DAX (fsdax PMEM) mount are mapped with MAP_SYNC and
+  // read in place, which turns a table read into a load instead of a
+  // pread plus copies.  The MAP_SYNC mapping fails with EOPNOTSUPP on
+  // anything else, so it doubles as the DAX detection.  DAX mappings are
+  // not subject to mmap_limit (which is 0 here) since they bypass the page
+  // cache; they have their own limit to bound address space use.
+  bool NewDaxReadableFile(const std::string& fname, int fd,
+                          RandomAccessFile** result) {
+#if defined(MAP_SYNC) && defined(MAP_SHARED_VALIDATE)
+    if (!dax_limit_.Acquire()) {
+      return false;
+    }
+    uint64_t size;
+    if (GetFileSize(fname, &size).ok() && size > 0) {
+      void* base = mmap(nullptr, size, PROT_READ,
+                        MAP_SHARED_VALIDATE | MAP_SYNC, fd, 0);
+      if (base != MAP_FAILED) {
+        *result = new PosixMmapReadableFile(fname, base, size, &dax_limit_);
+        return true;
+      }
+    }
+    dax_limit_.Release();
+#endif
+    return false;
+  }
+
   PosixLockTable locks_;
   Limiter mmap_limit_;
+  Limiter dax_limit_;
   Limiter fd_limit_;
 };
 
@@ -664,6 +847,7 @@ static intptr_t MaxOpenFiles() {
 PosixEnv::PosixEnv()
     : started_bgthread_(false),
       mmap_limit_(MaxMmaps()),
+      dax_limit_(sizeof(void*) >= 8 ? 1000 : 0),
       fd_limit_(MaxOpenFiles()) {
   PthreadCall("mutex_init", pthread_mutex_init(&mu_, nullptr));
   PthreadCall("cvar_init", pthread_cond_init(&bgsignal_, nullptr));
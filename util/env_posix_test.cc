@@ -56,6 +56,63 @@ TEST(EnvPosixTest, TestOpenOnRead) {
   ASSERT_OK(env_->DeleteFile(test_file));
 }
 
+TEST(EnvPosixTest, TestPrefetch) {
+  std::string test_dir;
+  ASSERT_OK(env_->GetTestDirectory(&test_dir));
+  std::string test_file = test_dir + "/prefetch.txt";
+
+  std::string data(100000, 'x');
+  for (size_t i = 0; i < data.size(); i += 1000) {
+    data[i] = static_cast<char>('a' + (i / 1000) % 26);
+  }
+  ASSERT_OK(WriteStringToFile(env_, data, test_file));
+
+  // Prefetch is only a hint: reads afterwards (and past the end of the
+  // file) behave exactly as without it.
+  RandomAccessFile* file;
+  ASSERT_OK(env_->NewRandomAccessFile(test_file, &file));
+  file->Prefetch(0, data.size());
+  file->Prefetch(50000, 1000000);
+  char scratch[1000];
+  Slice read_result;
+  for (size_t i = 0; i < data.size(); i += 1000) {
+    ASSERT_OK(file->Read(i, sizeof(scratch), &read_result, scratch));
+    ASSERT_EQ(data.substr(i, sizeof(scratch)), read_result.ToString());
+  }
+  delete file;
+  ASSERT_OK(env_->DeleteFile(test_file));
+}
+
+TEST(EnvPosixTest, TestDirectWritableFile) {
+  std::string test_dir;
+  ASSERT_OK(env_->GetTestDirectory(&test_dir));
+  std::string test_file = test_dir + "/direct_write.txt";
+
+  // Unaligned appends spanning several buffers, with a Sync() in the
+  // middle whose padded tail must be overwritten by later appends.
+  std::string expected;
+  WritableFile* file;
+  ASSERT_OK(env_->NewDirectWritableFile(test_file, &file));
+  for (int i = 0; i < 300; i++) {
+    std::string piece(1000 + i * 37, static_cast<char>('a' + i % 26));
+    ASSERT_OK(file->Append(piece));
+    expected.append(piece);
+    if (i == 100) {
+      ASSERT_OK(file->Sync());
+    }
+  }
+  ASSERT_OK(file->Close());
+  delete file;
+
+  uint64_t size;
+  ASSERT_OK(env_->GetFileSize(test_file, &size));
+  ASSERT_EQ(expected.size(), size);
+  std::string contents;
+  ASSERT_OK(ReadFileToString(env_, test_file, &contents));
+  ASSERT_TRUE(contents == expected);
+  ASSERT_OK(env_->DeleteFile(test_file));
+}
+
 }  // namespace leveldb
 
 int main(int argc, char** argv) {
@@ -0,0 +1,111 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/hdr_histogram.h"
+
+#include <math.h>
+#include <stdio.h>
+
+namespace leveldb {
+
+// Bucket b >= 1 holds [2^(b+6), 2^(b+7)) in 64 sub-buckets of width 2^b;
+// bucket 0 holds [0, 128) exactly.  Sub-bucket indices are laid out
+// contiguously: index = b * 64 + (value >> b).
+int HdrHistogram::BucketIndex(uint64_t value) {
+  if (value > kMaxValue) value = kMaxValue;
+  if (value < kSubBuckets) {
+    return static_cast<int>(value);
+  }
+  int msb = 63 - __builtin_clzll(value);
+  int b = msb - (kSubBucketBits - 1);
+  return b * (kSubBuckets / 2) + static_cast<int>(value >> b);
+}
+
+uint64_t HdrHistogram::BucketLimit(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  int b = index / (kSubBuckets / 2) - 1;
+  uint64_t sub = index - b * (kSubBuckets / 2);
+  return ((sub + 1) << b) - 1;
+}
+
+void HdrHistogram::Clear() {
+  count_ = 0;
+  min_ = ~static_cast<uint64_t>(0);
+  max_ = 0;
+  sum_ = 0;
+  for (int i = 0; i < kNumBuckets; i++) {
+    buckets_[i] = 0;
+  }
+}
+
+void HdrHistogram::Add(uint64_t value) {
+  buckets_[BucketIndex(value)]++;
+  count_++;
+  sum_ += value;
+  if (value < min_) min_ = value;
+  if (value > max_) max_ = value;
+}
+
+void HdrHistogram::Merge(const HdrHistogram& other) {
+  if (other.count_ == 0) return;
+  count_ += other.count_;
+  sum_ += other.sum_;
+  if (other.min_ < min_) min_ = other.min_;
+  if (other.max_ > max_) max_ = other.max_;
+  for (int i = 0; i < kNumBuckets; i++) {
+    buckets_[i] += other.buckets_[i];
+  }
+}
+
+void HdrHistogram::MergeBuckets(const uint64_t* buckets, uint64_t min,
+                                uint64_t max, double sum) {
+  uint64_t count = 0;
+  for (int i = 0; i < kNumBuckets; i++) {
+    buckets_[i] += buckets[i];
+    count += buckets[i];
+  }
+  if (count == 0) return;
+  count_ += count;
+  sum_ += sum;
+  if (min < min_) min_ = min;
+  if (max > max_) max_ = max;
+}
+
+double HdrHistogram::Average() const {
+  if (count_ == 0) return 0;
+  return sum_ / count_;
+}
+
+uint64_t HdrHistogram::Percentile(double p) const {
+  if (count_ == 0) return 0;
+  uint64_t threshold = static_cast<uint64_t>(ceil(count_ * p / 100.0));
+  if (threshold < 1) threshold = 1;
+  uint64_t sum = 0;
+  for (int i = 0; i < kNumBuckets; i++) {
+    sum += buckets_[i];
+    if (sum >= threshold) {
+      uint64_t r = BucketLimit(i);
+      if (r < min_) r = min_;
+      if (r > max_) r = max_;
+      return r;
+    }
+  }
+  return max_;
+}
+
+std::string HdrHistogram::ToString(double scale) const {
+  char buf[200];
+  snprintf(buf, sizeof(buf),
+           "Count: %llu  Average: %.4f  P50: %.2f  P99: %.2f  "
+           "P99.9: %.2f  P99.99: %.2f  Max: %.2f",
+           static_cast<unsigned long long>(count_), Average() / scale,
+           Percentile(50) / scale, Percentile(99) / scale,
+           Percentile(99.9) / scale, Percentile(99.99) / scale,
+           Max() / scale);
+  return buf;
+}
+
+}  // namespace leveldb
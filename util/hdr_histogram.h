@@ -0,0 +1,70 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// HdrHistogram records non-negative integer values (e.g. latencies in
+// nanoseconds) in log-linear buckets: every power of two is split into 64
+// equal sub-buckets, so any percentile is reported to within 1/64 (~1.6%)
+// of the true value, from single units up to kMaxValue.  Larger values are
+// counted in the last bucket.  Unlike Histogram, Add() is a constant-time
+// index computation, so it is cheap enough to call for every operation.
+//
+// Not thread-safe: keep one per thread and Merge() them.
+
+#ifndef STORAGE_LEVELDB_UTIL_HDR_HISTOGRAM_H_
+#define STORAGE_LEVELDB_UTIL_HDR_HISTOGRAM_H_
+
+#include <stdint.h>
+#include <string>
+
+namespace leveldb {
+
+class HdrHistogram {
+ public:
+  // Values up to this are bucketed (~137 seconds in nanoseconds)
+  static const int kMaxValueBits = 37;
+  static const uint64_t kMaxValue = (1ull << kMaxValueBits) - 1;
+
+  HdrHistogram() { Clear(); }
+  ~HdrHistogram() { }
+
+  void Clear();
+  void Add(uint64_t value);
+  void Merge(const HdrHistogram& other);
+
+  uint64_t Count() const { return count_; }
+  uint64_t Min() const { return count_ == 0 ? 0 : min_; }
+  uint64_t Max() const { return max_; }
+  double Average() const;
+  // The highest value in the bucket holding the "p"th percentile (0..100)
+  // of the recorded values, clamped to [Min(), Max()].
+  uint64_t Percentile(double p) const;
+
+  // Count, average and p50/p99/p99.9/p99.99/max, with every value divided
+  // by "scale" (e.g. 1000 to print nanoseconds as microseconds).
+  std::string ToString(double scale = 1) const;
+
+  // For histograms that keep their counts elsewhere (e.g. in atomics):
+  // the bucket a value is counted in, and a way to merge such counts.
+  // "buckets" has kNumBuckets entries.
+  enum { kSubBucketBits = 7 };  // 128 sub-buckets for [0, 128), then 64
+  enum { kSubBuckets = 1 << kSubBucketBits };
+  enum { kNumBuckets = (kMaxValueBits - kSubBucketBits + 2) *
+                       (kSubBuckets / 2) };
+  static int BucketIndex(uint64_t value);
+  void MergeBuckets(const uint64_t* buckets, uint64_t min, uint64_t max,
+                    double sum);
+
+ private:
+  static uint64_t BucketLimit(int index);
+
+  uint64_t count_;
+  uint64_t min_;
+  uint64_t max_;
+  double sum_;
+  uint64_t buckets_[kNumBuckets];
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_HDR_HISTOGRAM_H_
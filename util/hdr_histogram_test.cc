@@ -0,0 +1,83 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/hdr_histogram.h"
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace leveldb {
+
+class HdrHistogramTest { };
+
+TEST(HdrHistogramTest, Empty) {
+  HdrHistogram h;
+  ASSERT_EQ(0, h.Count());
+  ASSERT_EQ(0, h.Min());
+  ASSERT_EQ(0, h.Max());
+  ASSERT_EQ(0, h.Percentile(99));
+}
+
+TEST(HdrHistogramTest, SmallValuesAreExact) {
+  HdrHistogram h;
+  for (uint64_t v = 1; v <= 100; v++) {
+    h.Add(v);
+  }
+  ASSERT_EQ(100, h.Count());
+  ASSERT_EQ(1, h.Min());
+  ASSERT_EQ(100, h.Max());
+  ASSERT_EQ(50, h.Percentile(50));
+  ASSERT_EQ(99, h.Percentile(99));
+  ASSERT_EQ(100, h.Percentile(100));
+  ASSERT_EQ(50.5, h.Average());
+}
+
+TEST(HdrHistogramTest, RelativeError) {
+  HdrHistogram h;
+  Random rnd(301);
+  for (uint64_t v = 1; v < HdrHistogram::kMaxValue / 2;
+       v = v * 3 + rnd.Uniform(7)) {
+    h.Clear();
+    h.Add(v);
+    h.Add(2 * v);
+    ASSERT_EQ(2 * v, h.Percentile(100));  // clamped to the max
+    uint64_t p = h.Percentile(50);
+    ASSERT_GE(p, v);
+    ASSERT_LE(p - v, v / 64) << v;
+  }
+}
+
+TEST(HdrHistogramTest, TailPercentiles) {
+  // 9990 fast ops and 10 slow ones
+  HdrHistogram h;
+  for (int i = 0; i < 9990; i++) h.Add(1000);
+  for (int i = 0; i < 10; i++) h.Add(5000000);
+  ASSERT_LE(h.Percentile(99), 1000 + 1000 / 64);
+  ASSERT_LE(h.Percentile(99.9), 1000 + 1000 / 64);
+  ASSERT_EQ(5000000, h.Percentile(99.99));
+}
+
+TEST(HdrHistogramTest, Overflow) {
+  HdrHistogram h;
+  h.Add(HdrHistogram::kMaxValue * 4);
+  ASSERT_EQ(1, h.Count());
+  ASSERT_EQ(HdrHistogram::kMaxValue * 4, h.Max());
+  ASSERT_EQ(HdrHistogram::kMaxValue * 4, h.Percentile(50));
+}
+
+TEST(HdrHistogramTest, Merge) {
+  HdrHistogram a, b;
+  for (uint64_t v = 1; v <= 50; v++) a.Add(v);
+  for (uint64_t v = 51; v <= 100; v++) b.Add(v);
+  a.Merge(b);
+  ASSERT_EQ(100, a.Count());
+  ASSERT_EQ(1, a.Min());
+  ASSERT_EQ(100, a.Max());
+  ASSERT_EQ(90, a.Percentile(90));
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  return leveldb::test::RunAllTests();
+}
@@ -28,6 +28,8 @@ Options::Options()
 
       compression(kNoCompression),
       // compression(kSnappyCompression),
+      zstd_compression_level(1),
+      zstd_max_dict_bytes(0),
       
       reuse_logs(false),
       filter_policy(nullptr)
@@ -36,14 +38,47 @@ Options::Options()
       , sst_type(kPmemSST) // ozption 1
       // , sst_type(kFileDescriptorSST) // option 2
 
-      /* Pmem-buffer option */
-      , use_pmem_buffer(true)
-      // , use_pmem_buffer(false)
+      // TODO: hashmap is not implemented perfectly
+      /* Data-Structure option */
+      , ds_type(kSkiplist)
+      // , ds_type(kHashmap)
+
+      /* PMEM pool directory (empty: paths in pmem/layout.h) */
+      , pmem_dir()
 
       /* Addtional cache option */
       // , skiplist_cache(true) // NOTE: Only ds_type is "kSkiplist"
       , skiplist_cache(false)
 
+      /* Pmem-buffer option */
+      , use_pmem_buffer(true)
+      // , use_pmem_buffer(false)
+
+      /* Per-record value compression in the pmem-buffer */
+      , pmem_value_compression(kNoCompression)
+      // , pmem_value_compression(kLZ4Compression)
+      , pmem_key_restart_interval(16)
+      // , pmem_key_restart_interval(0)
+
+      /* DRAM row cache in front of pmem tables (disabled if nullptr) */
+      , pmem_row_cache(nullptr)
+
+      /* Write-ahead log in pmem instead of *.log files */
+      , use_pmem_log(false)
+      // , use_pmem_log(true)
+      , pmem_log(nullptr)
+
+      /* Memtable entries in a pmem extent (flushed by linking, not copying) */
+      , use_pmem_memtable(false)
+      // , use_pmem_memtable(true)
+      , pmem_memtable_buffer(nullptr)
+
+      /* SST writes of flushes and compactions */
+      , use_direct_io_for_flush_and_compaction(false)
+      , rate_limiter(nullptr)
+      , statistics(nullptr)
+      , listener(nullptr)
+
       /*
        * [Tiering policies]
        * Opt1: Leveled-tiering
@@ -67,10 +102,6 @@ Options::Options()
       // , tiering_option(kLRUTiering)
       // , tiering_option(kNoTiering)
 
-      // TODO: hashmap is not implemented perfectly
-      /* Data-Structure option */
-      , ds_type(kSkiplist)
-      // , ds_type(kHashmap)
        {
 }
 }  // namespace leveldbf
@@ -0,0 +1,84 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/perf_context_imp.h"
+
+#include <stdio.h>
+
+namespace leveldb {
+
+thread_local PerfLevel tls_perf_level = kPerfDisabled;
+thread_local PerfContext tls_perf_context;
+
+void PerfContext::Reset() {
+  get_memtable_nanos = 0;
+  get_from_files_nanos = 0;
+  tiering_lookup_nanos = 0;
+  sst_probe_count = 0;
+  pmem_probe_count = 0;
+  pmem_row_cache_hit_count = 0;
+  find_table_nanos = 0;
+  pmem_seek_nanos = 0;
+  pmem_read_delay_nanos = 0;
+  pmem_read_delay_count = 0;
+  index_seek_nanos = 0;
+  filter_nanos = 0;
+  block_read_nanos = 0;
+  block_read_count = 0;
+  block_read_bytes = 0;
+  block_cache_hit_count = 0;
+  block_cache_miss_count = 0;
+  iter_seek_nanos = 0;
+  internal_key_skipped_count = 0;
+  internal_delete_skipped_count = 0;
+}
+
+static void AppendField(std::string* r, const char* name, uint64_t value) {
+  if (value == 0) return;
+  char buf[100];
+  snprintf(buf, sizeof(buf), "%s%s = %llu", r->empty() ? "" : ", ", name,
+           static_cast<unsigned long long>(value));
+  r->append(buf);
+}
+
+std::string PerfContext::ToString() const {
+  std::string r;
+#define PERF_FIELD(name) AppendField(&r, #name, name)
+  PERF_FIELD(get_memtable_nanos);
+  PERF_FIELD(get_from_files_nanos);
+  PERF_FIELD(tiering_lookup_nanos);
+  PERF_FIELD(sst_probe_count);
+  PERF_FIELD(pmem_probe_count);
+  PERF_FIELD(pmem_row_cache_hit_count);
+  PERF_FIELD(find_table_nanos);
+  PERF_FIELD(pmem_seek_nanos);
+  PERF_FIELD(pmem_read_delay_nanos);
+  PERF_FIELD(pmem_read_delay_count);
+  PERF_FIELD(index_seek_nanos);
+  PERF_FIELD(filter_nanos);
+  PERF_FIELD(block_read_nanos);
+  PERF_FIELD(block_read_count);
+  PERF_FIELD(block_read_bytes);
+  PERF_FIELD(block_cache_hit_count);
+  PERF_FIELD(block_cache_miss_count);
+  PERF_FIELD(iter_seek_nanos);
+  PERF_FIELD(internal_key_skipped_count);
+  PERF_FIELD(internal_delete_skipped_count);
+#undef PERF_FIELD
+  return r;
+}
+
+void SetPerfLevel(PerfLevel level) {
+  tls_perf_level = level;
+}
+
+PerfLevel GetPerfLevel() {
+  return tls_perf_level;
+}
+
+PerfContext* GetPerfContext() {
+  return &tls_perf_context;
+}
+
+}  // namespace leveldb
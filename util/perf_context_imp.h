@@ -0,0 +1,66 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Measurement points for leveldb/perf_context.h:
+//
+//   PERF_TIMER_GUARD(index_seek_nanos);   // until the end of the scope
+//   PERF_COUNTER_ADD(block_read_bytes, n);
+
+#ifndef STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
+#define STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
+
+#include <chrono>
+#include "leveldb/perf_context.h"
+
+namespace leveldb {
+
+extern thread_local PerfLevel tls_perf_level;
+extern thread_local PerfContext tls_perf_context;
+
+// Adds the time between construction and Stop() (or destruction) to
+// "*metric" if the thread's level is kPerfEnableTime.
+class PerfTimer {
+ public:
+  explicit PerfTimer(uint64_t* metric)
+      : metric_(tls_perf_level >= kPerfEnableTime ? metric : nullptr),
+        start_(metric_ != nullptr ? Now() : 0) { }
+
+  ~PerfTimer() { Stop(); }
+
+  void Stop() {
+    if (metric_ != nullptr) {
+      *metric_ += Now() - start_;
+      metric_ = nullptr;
+    }
+  }
+
+ private:
+  static uint64_t Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  uint64_t* metric_;
+  uint64_t start_;
+
+  // No copying allowed
+  PerfTimer(const PerfTimer&);
+  void operator=(const PerfTimer&);
+};
+
+#define PERF_TIMER_GUARD(metric) \
+  PerfTimer perf_timer_##metric(&tls_perf_context.metric)
+
+#define PERF_TIMER_STOP(metric) perf_timer_##metric.Stop()
+
+#define PERF_COUNTER_ADD(metric, value)         \
+  do {                                          \
+    if (tls_perf_level >= kPerfEnableCount) {   \
+      tls_perf_context.metric += (value);       \
+    }                                           \
+  } while (0)
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_PERF_CONTEXT_IMP_H_
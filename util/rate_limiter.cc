@@ -0,0 +1,95 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include <assert.h>
+#include <algorithm>
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+RateLimiter::~RateLimiter() {
+}
+
+namespace {
+
+class TokenBucketRateLimiter : public RateLimiter {
+ public:
+  TokenBucketRateLimiter(int64_t bytes_per_second, Env* env)
+      : env_(env),
+        bytes_per_second_(bytes_per_second),
+        burst_(std::max<int64_t>(bytes_per_second / 10, 1)),
+        available_(burst_),
+        last_refill_micros_(env->NowMicros()),
+        total_bytes_(0) {
+    assert(bytes_per_second > 0);
+  }
+
+  virtual void Request(size_t bytes) {
+    uint64_t wait_micros;
+    {
+      MutexLock l(&mu_);
+      Refill();
+      // Take the tokens now, going into debt if needed, so that concurrent
+      // requesters queue up behind each other instead of all waking at once.
+      available_ -= static_cast<int64_t>(bytes);
+      total_bytes_ += bytes;
+      if (available_ >= 0) {
+        return;
+      }
+      wait_micros = static_cast<uint64_t>(-available_) * 1000000 /
+                    bytes_per_second_;
+    }
+    env_->SleepForMicroseconds(static_cast<int>(wait_micros));
+  }
+
+  virtual int64_t GetBytesPerSecond() const {
+    return bytes_per_second_;
+  }
+
+  virtual uint64_t GetTotalBytesThrough() const {
+    MutexLock l(&mu_);
+    return total_bytes_;
+  }
+
+ private:
+  void Refill() EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const uint64_t now = env_->NowMicros();
+    if (now <= last_refill_micros_) {
+      return;
+    }
+    const uint64_t elapsed = now - last_refill_micros_;
+    const double tokens = static_cast<double>(elapsed) * bytes_per_second_ /
+                          1000000.0;
+    if (tokens < 1) {
+      return;  // Keep accumulating time
+    }
+    last_refill_micros_ = now;
+    available_ = (tokens >= static_cast<double>(burst_ - available_))
+                     ? burst_
+                     : available_ + static_cast<int64_t>(tokens);
+  }
+
+  Env* const env_;
+  const int64_t bytes_per_second_;
+  const int64_t burst_;
+
+  mutable port::Mutex mu_;
+  int64_t available_ GUARDED_BY(mu_);  // Negative while in debt
+  uint64_t last_refill_micros_ GUARDED_BY(mu_);
+  uint64_t total_bytes_ GUARDED_BY(mu_);
+};
+
+}  // namespace
+
+RateLimiter* NewRateLimiter(int64_t bytes_per_second, Env* env) {
+  return new TokenBucketRateLimiter(bytes_per_second,
+                                    env != nullptr ? env : Env::Default());
+}
+
+}  // namespace leveldb
@@ -0,0 +1,70 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include "leveldb/env.h"
+#include "util/testharness.h"
+
+namespace leveldb {
+
+// Env whose clock only moves when somebody sleeps.
+class FakeClockEnv : public EnvWrapper {
+ public:
+  uint64_t now_micros_;
+
+  FakeClockEnv() : EnvWrapper(Env::Default()), now_micros_(1000000) { }
+
+  virtual uint64_t NowMicros() { return now_micros_; }
+  virtual void SleepForMicroseconds(int micros) { now_micros_ += micros; }
+};
+
+class RateLimiterTest {
+ public:
+  FakeClockEnv env_;
+};
+
+TEST(RateLimiterTest, BurstIsFree) {
+  RateLimiter* limiter = NewRateLimiter(1 << 20, &env_);
+  ASSERT_EQ(1 << 20, limiter->GetBytesPerSecond());
+  // A tenth of a second's worth is available up front.
+  limiter->Request((1 << 20) / 10);
+  ASSERT_EQ(1000000, env_.now_micros_);
+  ASSERT_EQ((1 << 20) / 10, limiter->GetTotalBytesThrough());
+  delete limiter;
+}
+
+TEST(RateLimiterTest, SteadyRate) {
+  const int64_t kRate = 1 << 20;
+  RateLimiter* limiter = NewRateLimiter(kRate, &env_);
+  const uint64_t start = env_.now_micros_;
+  for (int i = 0; i < 100; i++) {
+    limiter->Request(100 << 10);
+  }
+  // 10000KB at 1MB/s, minus the initial burst.
+  const uint64_t elapsed = env_.now_micros_ - start;
+  const uint64_t expected = (100 * (100 << 10) - kRate / 10) * 1000000 / kRate;
+  ASSERT_GE(elapsed, expected - 1000);
+  ASSERT_LE(elapsed, expected + 100000);
+  delete limiter;
+}
+
+TEST(RateLimiterTest, LargeRequestIsPaidBack) {
+  RateLimiter* limiter = NewRateLimiter(1 << 20, &env_);
+  const uint64_t start = env_.now_micros_;
+  // A request far larger than the bucket is granted; the debt delays it.
+  limiter->Request(10 << 20);
+  ASSERT_GE(env_.now_micros_ - start, 9000000);
+  // Once paid back, the limiter is usable again at the normal rate.
+  const uint64_t mid = env_.now_micros_;
+  limiter->Request(1 << 20);
+  ASSERT_LE(env_.now_micros_ - mid, 1100000);
+  delete limiter;
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  return leveldb::test::RunAllTests();
+}
@@ -0,0 +1,231 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/statistics.h"
+
+#include <stdio.h>
+#include <atomic>
+
+#include "util/hdr_histogram.h"
+
+namespace leveldb {
+
+Statistics::~Statistics() { }
+
+namespace {
+
+const char* kTickerNames[kNumTickers] = {
+  "memtable.hits",
+  "get.misses",
+  "pmem.bytes.read",
+  "pmem.bytes.written",
+  "compaction.hot.entries",
+  "compaction.warm.entries",
+  "tiering.migrated.tables",
+  "tiering.migrated.bytes",
+  "write.stall.micros",
+  "bloom.checked",
+  "bloom.useful",
+  "user.bytes.written",
+  "wal.bytes.written",
+};
+
+const char* kLevelTickerNames[kNumLevelTickers] = {
+  "pmem.hits",
+  "sst.hits",
+};
+
+const char* kHistogramNames[kNumHistograms] = {
+  "get.micros",
+  "write.micros",
+  "compaction.micros",
+  "write.stall.micros",
+};
+
+// HdrHistogram with atomic buckets, so that any thread can Add() to it.
+class AtomicHistogram {
+ public:
+  AtomicHistogram() { Clear(); }
+
+  void Clear() {
+    for (int i = 0; i < HdrHistogram::kNumBuckets; i++) {
+      buckets_[i].store(0, std::memory_order_relaxed);
+    }
+    min_.store(~static_cast<uint64_t>(0), std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+  }
+
+  void Add(uint64_t value) {
+    buckets_[HdrHistogram::BucketIndex(value)].fetch_add(
+        1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t min = min_.load(std::memory_order_relaxed);
+    while (value < min &&
+           !min_.compare_exchange_weak(min, value,
+                                       std::memory_order_relaxed)) {
+    }
+    uint64_t max = max_.load(std::memory_order_relaxed);
+    while (value > max &&
+           !max_.compare_exchange_weak(max, value,
+                                       std::memory_order_relaxed)) {
+    }
+  }
+
+  void Snapshot(HdrHistogram* h) const {
+    uint64_t buckets[HdrHistogram::kNumBuckets];
+    for (int i = 0; i < HdrHistogram::kNumBuckets; i++) {
+      buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    h->Clear();
+    h->MergeBuckets(buckets, min_.load(std::memory_order_relaxed),
+                    max_.load(std::memory_order_relaxed),
+                    sum_.load(std::memory_order_relaxed));
+  }
+
+ private:
+  std::atomic<uint64_t> buckets_[HdrHistogram::kNumBuckets];
+  std::atomic<uint64_t> min_;
+  std::atomic<uint64_t> max_;
+  std::atomic<uint64_t> sum_;
+};
+
+class StatisticsImpl : public Statistics {
+ public:
+  StatisticsImpl() { Reset(); }
+
+  virtual void RecordTick(Ticker ticker, uint64_t count) {
+    tickers_[ticker].fetch_add(count, std::memory_order_relaxed);
+  }
+
+  virtual void RecordLevelTick(LevelTicker ticker, int level,
+                               uint64_t count) {
+    if (level < 0 || level >= kNumLevels) return;
+    level_tickers_[ticker][level].fetch_add(count,
+                                            std::memory_order_relaxed);
+  }
+
+  virtual void MeasureTime(HistogramType type, uint64_t micros) {
+    histograms_[type].Add(micros);
+  }
+
+  virtual uint64_t GetTickerCount(Ticker ticker) const {
+    return tickers_[ticker].load(std::memory_order_relaxed);
+  }
+
+  virtual uint64_t GetLevelTickerCount(LevelTicker ticker, int level) const {
+    if (level < 0 || level >= kNumLevels) return 0;
+    return level_tickers_[ticker][level].load(std::memory_order_relaxed);
+  }
+
+  virtual uint64_t GetHistogramCount(HistogramType type) const {
+    HdrHistogram h;
+    histograms_[type].Snapshot(&h);
+    return h.Count();
+  }
+
+  virtual double GetHistogramPercentile(HistogramType type, double p) const {
+    HdrHistogram h;
+    histograms_[type].Snapshot(&h);
+    return h.Percentile(p);
+  }
+
+  virtual void Reset() {
+    for (int i = 0; i < kNumTickers; i++) {
+      tickers_[i].store(0, std::memory_order_relaxed);
+    }
+    for (int t = 0; t < kNumLevelTickers; t++) {
+      for (int level = 0; level < kNumLevels; level++) {
+        level_tickers_[t][level].store(0, std::memory_order_relaxed);
+      }
+    }
+    for (int i = 0; i < kNumHistograms; i++) {
+      histograms_[i].Clear();
+    }
+  }
+
+  virtual std::string ToString() const {
+    std::string r;
+    char buf[200];
+    for (int i = 0; i < kNumTickers; i++) {
+      snprintf(buf, sizeof(buf), "%-24s %llu\n", kTickerNames[i],
+               static_cast<unsigned long long>(
+                   GetTickerCount(static_cast<Ticker>(i))));
+      r.append(buf);
+    }
+    r.append("Level  PMEM-hits   SST-hits\n");
+    for (int level = 0; level < kNumLevels; level++) {
+      snprintf(buf, sizeof(buf), "%3d %12llu %10llu\n", level,
+               static_cast<unsigned long long>(
+                   GetLevelTickerCount(kPmemHits, level)),
+               static_cast<unsigned long long>(
+                   GetLevelTickerCount(kSstHits, level)));
+      r.append(buf);
+    }
+    HdrHistogram h;
+    for (int i = 0; i < kNumHistograms; i++) {
+      histograms_[i].Snapshot(&h);
+      if (h.Count() == 0) continue;
+      r.append(kHistogramNames[i]);
+      r.append(": ");
+      r.append(h.ToString());
+      r.push_back('\n');
+    }
+    return r;
+  }
+
+  virtual std::string ToJSON() const {
+    std::string r = "{\"tickers\": {";
+    char buf[200];
+    for (int i = 0; i < kNumTickers; i++) {
+      snprintf(buf, sizeof(buf), "%s\"%s\": %llu", i > 0 ? ", " : "",
+               kTickerNames[i],
+               static_cast<unsigned long long>(
+                   GetTickerCount(static_cast<Ticker>(i))));
+      r.append(buf);
+    }
+    r.append("}, \"levels\": [");
+    for (int level = 0; level < kNumLevels; level++) {
+      snprintf(buf, sizeof(buf),
+               "%s{\"level\": %d, \"%s\": %llu, \"%s\": %llu}",
+               level > 0 ? ", " : "", level, kLevelTickerNames[kPmemHits],
+               static_cast<unsigned long long>(
+                   GetLevelTickerCount(kPmemHits, level)),
+               kLevelTickerNames[kSstHits],
+               static_cast<unsigned long long>(
+                   GetLevelTickerCount(kSstHits, level)));
+      r.append(buf);
+    }
+    r.append("], \"histograms\": {");
+    HdrHistogram h;
+    for (int i = 0; i < kNumHistograms; i++) {
+      histograms_[i].Snapshot(&h);
+      snprintf(buf, sizeof(buf),
+               "%s\"%s\": {\"count\": %llu, \"avg\": %.2f, \"p50\": %llu, "
+               "\"p99\": %llu, \"p99.9\": %llu, \"max\": %llu}",
+               i > 0 ? ", " : "", kHistogramNames[i],
+               static_cast<unsigned long long>(h.Count()), h.Average(),
+               static_cast<unsigned long long>(h.Percentile(50)),
+               static_cast<unsigned long long>(h.Percentile(99)),
+               static_cast<unsigned long long>(h.Percentile(99.9)),
+               static_cast<unsigned long long>(h.Max()));
+      r.append(buf);
+    }
+    r.append("}}");
+    return r;
+  }
+
+ private:
+  std::atomic<uint64_t> tickers_[kNumTickers];
+  std::atomic<uint64_t> level_tickers_[kNumLevelTickers][kNumLevels];
+  AtomicHistogram histograms_[kNumHistograms];
+};
+
+}  // namespace
+
+Statistics* NewStatistics() {
+  return new StatisticsImpl;
+}
+
+}  // namespace leveldb
@@ -0,0 +1,129 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/statistics.h"
+
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "util/testharness.h"
+
+namespace leveldb {
+
+class StatisticsTest {
+ public:
+  Statistics* stats_;
+
+  StatisticsTest() : stats_(NewStatistics()) { }
+  ~StatisticsTest() { delete stats_; }
+};
+
+TEST(StatisticsTest, Tickers) {
+  for (int i = 0; i < kNumTickers; i++) {
+    ASSERT_EQ(0, stats_->GetTickerCount(static_cast<Ticker>(i)));
+  }
+  stats_->RecordTick(kMemtableHits);
+  stats_->RecordTick(kPmemBytesWritten, 4096);
+  stats_->RecordTick(kPmemBytesWritten, 100);
+  ASSERT_EQ(1, stats_->GetTickerCount(kMemtableHits));
+  ASSERT_EQ(4196, stats_->GetTickerCount(kPmemBytesWritten));
+  ASSERT_EQ(0, stats_->GetTickerCount(kGetMisses));
+}
+
+TEST(StatisticsTest, LevelTickers) {
+  stats_->RecordLevelTick(kPmemHits, 0);
+  stats_->RecordLevelTick(kPmemHits, 0);
+  stats_->RecordLevelTick(kSstHits, 3, 5);
+  stats_->RecordLevelTick(kSstHits, Statistics::kNumLevels);  // Ignored
+  ASSERT_EQ(2, stats_->GetLevelTickerCount(kPmemHits, 0));
+  ASSERT_EQ(0, stats_->GetLevelTickerCount(kSstHits, 0));
+  ASSERT_EQ(5, stats_->GetLevelTickerCount(kSstHits, 3));
+  ASSERT_EQ(0, stats_->GetLevelTickerCount(kSstHits,
+                                           Statistics::kNumLevels));
+}
+
+TEST(StatisticsTest, Histograms) {
+  for (uint64_t v = 1; v <= 100; v++) {
+    stats_->MeasureTime(kGetMicros, v);
+  }
+  ASSERT_EQ(100, stats_->GetHistogramCount(kGetMicros));
+  ASSERT_EQ(0, stats_->GetHistogramCount(kWriteMicros));
+  ASSERT_EQ(50, stats_->GetHistogramPercentile(kGetMicros, 50));
+  ASSERT_EQ(99, stats_->GetHistogramPercentile(kGetMicros, 99));
+}
+
+TEST(StatisticsTest, Reset) {
+  stats_->RecordTick(kGetMisses, 7);
+  stats_->RecordLevelTick(kSstHits, 1);
+  stats_->MeasureTime(kWriteMicros, 10);
+  stats_->Reset();
+  ASSERT_EQ(0, stats_->GetTickerCount(kGetMisses));
+  ASSERT_EQ(0, stats_->GetLevelTickerCount(kSstHits, 1));
+  ASSERT_EQ(0, stats_->GetHistogramCount(kWriteMicros));
+}
+
+TEST(StatisticsTest, Dump) {
+  stats_->RecordTick(kBloomFilterUseful, 3);
+  stats_->RecordLevelTick(kPmemHits, 2, 4);
+  stats_->MeasureTime(kCompactionMicros, 1000);
+  std::string text = stats_->ToString();
+  ASSERT_TRUE(text.find("bloom.useful") != std::string::npos) << text;
+  ASSERT_TRUE(text.find("compaction.micros") != std::string::npos) << text;
+  std::string json = stats_->ToJSON();
+  ASSERT_TRUE(json.find("\"bloom.useful\": 3") != std::string::npos) << json;
+  ASSERT_TRUE(json.find("{\"level\": 2, \"pmem.hits\": 4, \"sst.hits\": 0}")
+              != std::string::npos) << json;
+  ASSERT_TRUE(json.find("\"compaction.micros\": {\"count\": 1") !=
+              std::string::npos) << json;
+  ASSERT_EQ('{', json[0]);
+  ASSERT_EQ('}', json[json.size() - 1]);
+}
+
+namespace {
+
+struct ThreadState {
+  Statistics* stats;
+  port::Mutex mu;
+  int done;
+};
+
+const int kThreads = 4;
+const int kOpsPerThread = 10000;
+
+void Recorder(void* arg) {
+  ThreadState* state = reinterpret_cast<ThreadState*>(arg);
+  for (int i = 0; i < kOpsPerThread; i++) {
+    state->stats->RecordTick(kMemtableHits);
+    state->stats->MeasureTime(kGetMicros, i);
+  }
+  state->mu.Lock();
+  state->done++;
+  state->mu.Unlock();
+}
+
+}  // namespace
+
+TEST(StatisticsTest, Concurrent) {
+  ThreadState state;
+  state.stats = stats_;
+  state.done = 0;
+  for (int i = 0; i < kThreads; i++) {
+    Env::Default()->StartThread(&Recorder, &state);
+  }
+  while (true) {
+    state.mu.Lock();
+    int done = state.done;
+    state.mu.Unlock();
+    if (done == kThreads) break;
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  ASSERT_EQ(kThreads * kOpsPerThread, stats_->GetTickerCount(kMemtableHits));
+  ASSERT_EQ(kThreads * kOpsPerThread,
+            stats_->GetHistogramCount(kGetMicros));
+}
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  return leveldb::test::RunAllTests();
+}
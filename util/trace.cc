@@ -0,0 +1,215 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/trace.h"
+
+#include "leveldb/env.h"
+#include "util/trace_imp.h"
+
+#ifdef LEVELDB_TRACING
+
+#include <stdio.h>
+#include <chrono>
+#include <set>
+#include <vector>
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+std::atomic<bool> trace_enabled(false);
+
+namespace {
+
+// Spans kept per trace; about 24 bytes each
+static const uint64_t kMaxTraceEvents = 4 << 20;
+
+struct TraceEvent {
+  const char* name;
+  uint64_t start;
+  uint64_t end;
+};
+
+// Each thread appends to its own buffer.  The buffer mutex is only
+// contended while EndTrace() drains it.
+struct ThreadBuffer {
+  port::Mutex mu;
+  uint64_t tid;
+  std::vector<TraceEvent> events GUARDED_BY(mu);
+};
+
+struct Tracer {
+  port::Mutex mu;
+  std::set<ThreadBuffer*> buffers GUARDED_BY(mu);
+  // Events of threads that exited during the trace
+  std::vector<std::pair<uint64_t, TraceEvent> > retired GUARDED_BY(mu);
+  WritableFile* file GUARDED_BY(mu) = nullptr;
+  uint64_t start_nanos GUARDED_BY(mu) = 0;
+  uint64_t next_tid GUARDED_BY(mu) = 1;
+  std::atomic<uint64_t> num_events{0};
+  std::atomic<uint64_t> num_dropped{0};
+};
+
+static Tracer* GetTracer() {
+  static Tracer* tracer = new Tracer;  // Never deleted
+  return tracer;
+}
+
+// Registers the thread's buffer on first use and hands its events over
+// when the thread exits.
+class ThreadBufferHolder {
+ public:
+  ThreadBufferHolder() {
+    Tracer* tracer = GetTracer();
+    MutexLock l(&tracer->mu);
+    buffer_.tid = tracer->next_tid++;
+    tracer->buffers.insert(&buffer_);
+  }
+
+  ~ThreadBufferHolder() {
+    Tracer* tracer = GetTracer();
+    MutexLock l(&tracer->mu);
+    tracer->buffers.erase(&buffer_);
+    MutexLock bl(&buffer_.mu);
+    for (size_t i = 0; i < buffer_.events.size(); i++) {
+      tracer->retired.push_back(std::make_pair(buffer_.tid,
+                                               buffer_.events[i]));
+    }
+  }
+
+  ThreadBuffer* buffer() { return &buffer_; }
+
+ private:
+  ThreadBuffer buffer_;
+};
+
+static void AppendEvent(std::string* out, bool* first, uint64_t tid,
+                        const TraceEvent& e, uint64_t base) {
+  const uint64_t start = e.start > base ? e.start - base : 0;
+  const uint64_t dur = e.end > e.start ? e.end - e.start : 0;
+  char buf[200];
+  snprintf(buf, sizeof(buf),
+           "%s\n{\"name\": \"%s\", \"cat\": \"leveldb\", \"ph\": \"X\", "
+           "\"ts\": %llu.%03llu, \"dur\": %llu.%03llu, \"pid\": 1, "
+           "\"tid\": %llu}",
+           *first ? "" : ",", e.name,
+           static_cast<unsigned long long>(start / 1000),
+           static_cast<unsigned long long>(start % 1000),
+           static_cast<unsigned long long>(dur / 1000),
+           static_cast<unsigned long long>(dur % 1000),
+           static_cast<unsigned long long>(tid));
+  out->append(buf);
+  *first = false;
+}
+
+}  // namespace
+
+uint64_t TraceNowNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void RecordTraceSpan(const char* name, uint64_t start_nanos,
+                     uint64_t end_nanos) {
+  static thread_local ThreadBufferHolder holder;
+  Tracer* tracer = GetTracer();
+  if (tracer->num_events.fetch_add(1, std::memory_order_relaxed) >=
+      kMaxTraceEvents) {
+    tracer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  ThreadBuffer* buffer = holder.buffer();
+  TraceEvent e = { name, start_nanos, end_nanos };
+  MutexLock l(&buffer->mu);
+  buffer->events.push_back(e);
+}
+
+Status StartTrace(Env* env, const std::string& fname) {
+  Tracer* tracer = GetTracer();
+  MutexLock l(&tracer->mu);
+  if (tracer->file != nullptr) {
+    return Status::InvalidArgument("trace already started", fname);
+  }
+  WritableFile* file;
+  Status s = env->NewWritableFile(fname, &file);
+  if (!s.ok()) {
+    return s;
+  }
+  // Forget spans that ended after the previous EndTrace()
+  for (std::set<ThreadBuffer*>::iterator it = tracer->buffers.begin();
+       it != tracer->buffers.end(); ++it) {
+    MutexLock bl(&(*it)->mu);
+    (*it)->events.clear();
+  }
+  tracer->retired.clear();
+  tracer->num_events.store(0, std::memory_order_relaxed);
+  tracer->num_dropped.store(0, std::memory_order_relaxed);
+  tracer->file = file;
+  tracer->start_nanos = TraceNowNanos();
+  trace_enabled.store(true, std::memory_order_relaxed);
+  return Status::OK();
+}
+
+Status EndTrace() {
+  Tracer* tracer = GetTracer();
+  MutexLock l(&tracer->mu);
+  if (tracer->file == nullptr) {
+    return Status::InvalidArgument("trace not started");
+  }
+  trace_enabled.store(false, std::memory_order_relaxed);
+
+  std::string out = "{\"traceEvents\": [";
+  bool first = true;
+  for (std::set<ThreadBuffer*>::iterator it = tracer->buffers.begin();
+       it != tracer->buffers.end(); ++it) {
+    MutexLock bl(&(*it)->mu);
+    for (size_t i = 0; i < (*it)->events.size(); i++) {
+      AppendEvent(&out, &first, (*it)->tid, (*it)->events[i],
+                  tracer->start_nanos);
+    }
+    (*it)->events.clear();
+  }
+  for (size_t i = 0; i < tracer->retired.size(); i++) {
+    AppendEvent(&out, &first, tracer->retired[i].first,
+                tracer->retired[i].second, tracer->start_nanos);
+  }
+  tracer->retired.clear();
+  char buf[100];
+  snprintf(buf, sizeof(buf),
+           "\n],\n\"displayTimeUnit\": \"ns\",\n"
+           "\"otherData\": {\"dropped_spans\": %llu}}\n",
+           static_cast<unsigned long long>(
+               tracer->num_dropped.load(std::memory_order_relaxed)));
+  out.append(buf);
+
+  WritableFile* file = tracer->file;
+  tracer->file = nullptr;
+  Status s = file->Append(out);
+  if (s.ok()) {
+    s = file->Close();
+  }
+  delete file;
+  return s;
+}
+
+}  // namespace leveldb
+
+#else
+
+namespace leveldb {
+
+Status StartTrace(Env* env, const std::string& fname) {
+  return Status::NotSupported("tracing is compiled out",
+                              "build with LEVELDB_ENABLE_TRACING");
+}
+
+Status EndTrace() {
+  return Status::NotSupported("tracing is compiled out",
+                              "build with LEVELDB_ENABLE_TRACING");
+}
+
+}  // namespace leveldb
+
+#endif  // LEVELDB_TRACING
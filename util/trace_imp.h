@@ -0,0 +1,64 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// Trace points for leveldb/trace.h:
+//
+//   TRACE_SPAN("wal.append");   // until the end of the scope
+//
+// The name must be a string literal (it is kept by pointer).  Without
+// LEVELDB_TRACING the macro expands to nothing.
+
+#ifndef STORAGE_LEVELDB_UTIL_TRACE_IMP_H_
+#define STORAGE_LEVELDB_UTIL_TRACE_IMP_H_
+
+#ifdef LEVELDB_TRACING
+
+#include <stdint.h>
+#include <atomic>
+
+namespace leveldb {
+
+extern std::atomic<bool> trace_enabled;
+
+uint64_t TraceNowNanos();
+void RecordTraceSpan(const char* name, uint64_t start_nanos,
+                     uint64_t end_nanos);
+
+// Records a span from construction to destruction if tracing was started
+// when it was constructed.
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* name)
+      : name_(trace_enabled.load(std::memory_order_relaxed) ? name : nullptr),
+        start_(name_ != nullptr ? TraceNowNanos() : 0) { }
+
+  ~TraceSpan() {
+    if (name_ != nullptr) {
+      RecordTraceSpan(name_, start_, TraceNowNanos());
+    }
+  }
+
+ private:
+  const char* name_;
+  uint64_t start_;
+
+  // No copying allowed
+  TraceSpan(const TraceSpan&);
+  void operator=(const TraceSpan&);
+};
+
+}  // namespace leveldb
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) \
+  ::leveldb::TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
+
+#else
+
+#define TRACE_SPAN(name) do { } while (0)
+
+#endif  // LEVELDB_TRACING
+
+#endif  // STORAGE_LEVELDB_UTIL_TRACE_IMP_H_
@@ -0,0 +1,116 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/trace.h"
+
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "util/mutexlock.h"
+#include "util/testharness.h"
+#include "util/trace_imp.h"
+
+namespace leveldb {
+
+class TraceTest {
+ public:
+  std::string fname_;
+  Env* env_;
+
+  TraceTest() : env_(Env::Default()) {
+    fname_ = test::TmpDir() + "/trace_test.json";
+    env_->DeleteFile(fname_);
+  }
+
+  ~TraceTest() {
+    env_->DeleteFile(fname_);
+  }
+
+  std::string ReadTrace() {
+    std::string contents;
+    ASSERT_OK(ReadFileToString(env_, fname_, &contents));
+    return contents;
+  }
+};
+
+static void TracedWork() {
+  TRACE_SPAN("test.outer");
+  {
+    TRACE_SPAN("test.inner");
+  }
+}
+
+#ifdef LEVELDB_TRACING
+
+TEST(TraceTest, RecordsSpans) {
+  TracedWork();  // Not traced
+  ASSERT_OK(StartTrace(env_, fname_));
+  ASSERT_TRUE(!StartTrace(env_, fname_).ok());
+  TracedWork();
+  ASSERT_OK(EndTrace());
+  TracedWork();  // Not traced
+  ASSERT_TRUE(!EndTrace().ok());
+
+  std::string trace = ReadTrace();
+  ASSERT_EQ(0, trace.find("{\"traceEvents\": [")) << trace;
+  ASSERT_TRUE(trace.find("\"dropped_spans\": 0") != std::string::npos);
+  size_t outer = trace.find("\"test.outer\"");
+  ASSERT_TRUE(outer != std::string::npos) << trace;
+  ASSERT_EQ(std::string::npos, trace.find("\"test.outer\"", outer + 1));
+  ASSERT_TRUE(trace.find("\"test.inner\"") != std::string::npos);
+}
+
+struct TraceThreadState {
+  port::Mutex mu;
+  port::CondVar cv;
+  bool done;
+
+  TraceThreadState() : cv(&mu), done(false) { }
+};
+
+static void TraceThread(void* arg) {
+  TraceThreadState* state = reinterpret_cast<TraceThreadState*>(arg);
+  TracedWork();
+  MutexLock l(&state->mu);
+  state->done = true;
+  state->cv.Signal();
+}
+
+TEST(TraceTest, ExitedThreads) {
+  ASSERT_OK(StartTrace(env_, fname_));
+  TracedWork();
+  TraceThreadState state;
+  env_->StartThread(&TraceThread, &state);
+  {
+    // The thread's spans are kept whether or not it has exited yet
+    MutexLock l(&state.mu);
+    while (!state.done) {
+      state.cv.Wait();
+    }
+  }
+  ASSERT_OK(EndTrace());
+
+  std::string trace = ReadTrace();
+  ASSERT_TRUE(trace.find("\"tid\": ") != std::string::npos) << trace;
+  size_t first = trace.find("\"test.outer\"");
+  ASSERT_TRUE(first != std::string::npos) << trace;
+  ASSERT_TRUE(trace.find("\"test.outer\"", first + 1) != std::string::npos)
+      << trace;
+}
+
+#else
+
+TEST(TraceTest, CompiledOut) {
+  TracedWork();
+  ASSERT_TRUE(StartTrace(env_, fname_).IsNotSupportedError());
+  ASSERT_TRUE(EndTrace().IsNotSupportedError());
+  ASSERT_TRUE(!env_->FileExists(fname_));
+}
+
+#endif  // LEVELDB_TRACING
+
+}  // namespace leveldb
+
+int main(int argc, char** argv) {
+  return leveldb::test::RunAllTests();
+}